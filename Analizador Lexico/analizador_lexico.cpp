@@ -4,6 +4,18 @@
 #include <string>    //biblioteca de manejo de cadenas de texto.
 #include <vector>    // biblioteca para usar contenedores vector.
 #include <algorithm> //biblioteca de algoritmos, necesaria para all_of.
+#include <array>     // contenedor de tamaño fijo para la tabla hash de palabras clave.
+#include <cstdint>   // tipos enteros de tamaño fijo (uint32_t).
+#include <string_view> // vistas de cadenas sin copia para la tabla de palabras clave.
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>  // proyección de archivos en memoria (MapViewOfFile).
+#else
+#include <fcntl.h>
+#include <sys/mman.h> // proyección de archivos en memoria (mmap).
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std; // Usa el espacio de nombres std para evitar escribir std:: delante de cada elemento de la STL.
 
@@ -24,45 +36,244 @@ struct Token
     string value;   // Valor textual del token.
 };                  // Define una estructura Token con un tipo y valor.
 
-// Función para clasificar las palabras
-TokenType identifyToken(const string &word)
+// Texto fuente completo, de solo lectura. El archivo se proyecta en memoria (mmap o
+// MapViewOfFile) y, si no se puede, se lee con una sola lectura.
+class Fuente
+{
+public:
+    Fuente() = default;
+    explicit Fuente(string texto) : copia(move(texto)), datos(copia.data()), tamano(copia.size()) {}
+    Fuente(const Fuente &) = delete;
+    Fuente &operator=(const Fuente &) = delete;
+    ~Fuente() { liberar(); }
+
+    // Abre el archivo indicado; devuelve false si no se puede leer
+    bool abrir(const string &ruta)
+    {
+        liberar();
+#ifdef _WIN32
+        HANDLE archivo = CreateFileA(ruta.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                     FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (archivo != INVALID_HANDLE_VALUE)
+        {
+            LARGE_INTEGER tam;
+            if (GetFileSizeEx(archivo, &tam) && tam.QuadPart > 0)
+            {
+                HANDLE proyeccion = CreateFileMappingA(archivo, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (proyeccion)
+                {
+                    void *vista = MapViewOfFile(proyeccion, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(proyeccion);
+                    if (vista)
+                    {
+                        CloseHandle(archivo);
+                        mapeo = vista;
+                        datos = static_cast<const char *>(vista);
+                        tamano = static_cast<size_t>(tam.QuadPart);
+                        return true;
+                    }
+                }
+            }
+            CloseHandle(archivo);
+        }
+#else
+        int fd = open(ruta.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+            {
+                void *vista = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (vista != MAP_FAILED)
+                {
+                    madvise(vista, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                    close(fd);
+                    mapeo = vista;
+                    datos = static_cast<const char *>(vista);
+                    tamano = static_cast<size_t>(info.st_size);
+                    return true;
+                }
+            }
+            close(fd);
+        }
+#endif
+        // Alternativa: leer todo el archivo con una sola lectura
+        ifstream archivo(ruta, ios::binary);
+        if (!archivo.is_open())
+        {
+            return false;
+        }
+        archivo.seekg(0, ios::end);
+        streamoff tam = archivo.tellg();
+        if (tam < 0)
+        {
+            // Sin tamaño conocido (p. ej. una tubería): se lee el flujo hasta el final
+            archivo.clear();
+            copia.assign(istreambuf_iterator<char>(archivo), istreambuf_iterator<char>());
+            datos = copia.data();
+            tamano = copia.size();
+            return true;
+        }
+        archivo.seekg(0, ios::beg);
+        copia.resize(static_cast<size_t>(tam));
+        if (!archivo.read(&copia[0], tam))
+        {
+            copia.clear();
+            return false;
+        }
+        datos = copia.data();
+        tamano = copia.size();
+        return true;
+    }
+
+    string_view contenido() const { return string_view(datos, tamano); }
+
+private:
+    string copia;             // Solo se usa cuando el texto no viene de una proyección
+    const char *datos = nullptr;
+    size_t tamano = 0;
+    void *mapeo = nullptr;    // Vista proyectada, o nullptr si se usa la copia
+
+    void liberar()
+    {
+        if (mapeo)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(mapeo);
+#else
+            munmap(mapeo, tamano);
+#endif
+            mapeo = nullptr;
+        }
+        copia.clear();
+        datos = nullptr;
+        tamano = 0;
+    }
+};
+
+
+// Palabras clave del lenguaje
+constexpr string_view PALABRAS_CLAVE[] = {
+    "auto", "break", "case", "catch", "class", "const", "continue", "default", "delete", "do", "else", "enum", "explicit", "export", "extern", "false", "for", "friend", "goto", "if", "inline", "mutable", "namespace", "new", "operator", "private", "protected", "public", "register", "reinterpret_cast", "return", "sizeof", "static", "static_cast", "struct", "switch", "template", "this", "throw", "true", "try", "typedef", "typeid", "typename", "union", "using", "virtual", "void", "volatile", "while"
+};
+
+// Símbolos reconocidos (la búsqueda solo acepta palabras de un carácter)
+constexpr string_view SIMBOLOS = " << >> + - * / % = == != > < >= <= && || ! & | ^ ~  += -= *= /= %= <<= >>= &= |= ^= ++ -- -> . :: ? : , ; ( ) [ ] { } #";
+
+// Tabla hash perfecta de palabras clave, generada en tiempo de compilación.
+// La función hash solo mira la longitud y tres caracteres (primero, segundo y último),
+// y se busca una semilla con la que ninguna palabra clave colisione.
+constexpr int BITS_TABLA_CLAVES = 8;
+
+constexpr uint32_t hashPalabraClave(string_view palabra, uint32_t semilla)
+{
+    uint32_t h = (semilla ^ static_cast<uint32_t>(palabra.size())) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[0])) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[palabra.size() > 1 ? 1 : 0])) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[palabra.size() - 1])) * 0x01000193u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    return h >> (32 - BITS_TABLA_CLAVES);
+}
+
+struct TablaPalabrasClave
 {
-    // Palabras clave
-    const vector<string> keywords = {"auto", "break", "case", "catch", "class", "const", "continue", "default", "delete", "do", "else", "enum", "explicit", "export", "extern", "false", "for", "friend", "goto", "if", "inline", "mutable", "namespace", "new", "operator", "private", "protected", "public", "register", "reinterpret_cast", "return", "sizeof", "static", "static_cast", "struct", "switch", "template", "this", "throw", "true", "try", "typedef", "typeid", "typename", "union", "using", "virtual", "void", "volatile", "while"}; // Lista de palabras clave.
-
-    // Verificar si es una palabra clave
-    for (const string &keyword : keywords)
-    { // Recorre la lista de palabras clave.
-        if (word == keyword)
-            return TokenType::KEYWORD; // Si la palabra es una palabra clave, retorna KEYWORD.
+    uint32_t semilla;
+    array<string_view, 1 << BITS_TABLA_CLAVES> ranuras;
+};
+
+constexpr TablaPalabrasClave construirTablaPalabrasClave()
+{
+    for (uint32_t semilla = 1; semilla < 100000; semilla++)
+    {
+        // Primero se prueba la semilla con un mapa de ranuras ocupadas
+        array<bool, 1 << BITS_TABLA_CLAVES> ocupadas{};
+        bool sinColisiones = true;
+        for (string_view palabra : PALABRAS_CLAVE)
+        {
+            bool &ocupada = ocupadas[hashPalabraClave(palabra, semilla)];
+            if (ocupada)
+            {
+                sinColisiones = false;
+                break;
+            }
+            ocupada = true;
+        }
+        if (!sinColisiones)
+            continue;
+
+        TablaPalabrasClave tabla{semilla, {}};
+        for (string_view palabra : PALABRAS_CLAVE)
+            tabla.ranuras[hashPalabraClave(palabra, semilla)] = palabra;
+        return tabla;
     }
+    return {0, {}};
+}
+
+constexpr TablaPalabrasClave TABLA_PALABRAS_CLAVE = construirTablaPalabrasClave();
+static_assert(TABLA_PALABRAS_CLAVE.semilla != 0, "No se encontró una semilla sin colisiones para las palabras clave");
+
+// Búsqueda en O(1): una sola ranura candidata y una comparación
+inline bool esPalabraClave(string_view palabra)
+{
+    if (palabra.empty()) return false;
+    return TABLA_PALABRAS_CLAVE.ranuras[hashPalabraClave(palabra, TABLA_PALABRAS_CLAVE.semilla)] == palabra;
+}
+
+// Función para clasificar las palabras
+TokenType identifyToken(string_view word)
+{
+    // Verificar si es una palabra clave (búsqueda en la tabla hash perfecta)
+    if (esPalabraClave(word))
+        return TokenType::KEYWORD; // Si la palabra es una palabra clave, retorna KEYWORD.
 
     // Verificar si es un número (simplificación: solo enteros)
-    if (all_of(word.begin(), word.end(), ::isdigit))
+    if (all_of(word.begin(), word.end(), [](unsigned char c) { return isdigit(c) != 0; }))
         return TokenType::NUMBER; // Si todos los caracteres son dígitos, retorna NUMBER.
 
     // Verificar si es un símbolo
-    if (word.size() == 1 && string(" << >> + - * / % = == != > < >= <= && || ! & | ^ ~  += -= *= /= %= <<= >>= &= |= ^= ++ -- -> . :: ? : , ; ( ) [ ] { } #").find(word) != string::npos)
+    if (word.size() == 1 && SIMBOLOS.find(word) != string::npos)
         return TokenType::SYMBOL; // Si es un símboloretorna SYMBOL.
 
     // Por default, es un identificador
     return TokenType::IDENTIFIER; // Si no es ninguna de las anteriores, retorna IDENTIFIER.
 }
 
+// Separa el texto en palabras delimitadas por espacios en blanco (equivale a leer con file >> word)
+vector<Token> separarPalabras(string_view texto)
+{
+    vector<Token> tokens; // Vector para almacenar los tokens identificados.
+    size_t i = 0;
+    while (i < texto.size())
+    {
+        while (i < texto.size() && isspace(static_cast<unsigned char>(texto[i])))
+            i++; // Saltar los espacios en blanco.
+        size_t inicio = i;
+        while (i < texto.size() && !isspace(static_cast<unsigned char>(texto[i])))
+            i++; // Avanzar hasta el final de la palabra.
+        if (i > inicio)
+        {
+            string_view word = texto.substr(inicio, i - inicio);
+            tokens.push_back({identifyToken(word), string(word)}); // Crea un token con el tipo y valor identificados.
+        }
+    }
+    return tokens;
+}
+
 // Función principal
-int main()
+int main(int argc, char *argv[])
 {
-    ifstream file("input.txt"); // Abre el archivo input.txt para analizar.
-    string word;                // Variable para almacenar cada palabra leída del archivo.
-    vector<Token> tokens;       // Vector para almacenar los tokens identificados.
-
-    // Leer cada palabra del archivo
-    while (file >> word)
-    {                                              // leer en el archivo...
-        Token token = {identifyToken(word), word}; // Crea un token con el tipo y valor identificados.
-        tokens.push_back(token);                   // Añade el token al vector de tokens.
+    string ruta = argc >= 2 ? argv[1] : "input.txt"; // Archivo a analizar (input.txt por defecto).
+    Fuente fuente;                                    // Contenido del archivo proyectado en memoria.
+    if (!fuente.abrir(ruta))
+    {
+        cout << "Error al abrir el archivo." << endl;
+        return 1;
     }
 
+    // Separar todas las palabras del archivo de una sola vez
+    vector<Token> tokens = separarPalabras(fuente.contenido());
+
     // Imprimir los tokens identificados
     for (const Token &token : tokens)
     {                                                   // Recorre el vector de tokens.
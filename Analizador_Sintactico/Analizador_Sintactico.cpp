@@ -4,6 +4,18 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 
 using namespace std;
@@ -25,31 +37,209 @@ struct Token
     string value;
 };
 
-// Función para clasificar palabras
-TokenType identifyToken(const string &word)
+// Texto fuente completo, de solo lectura. El archivo se proyecta en memoria (mmap o
+// MapViewOfFile) y, si no se puede, se lee con una sola lectura.
+class Fuente
 {
-    // Palabras clave
-    const vector<string> keywords = {"auto", "break", "case", "catch", "class",
-     "const", "continue", "default", "delete", "do", "else", "enum", "explicit", 
-     "export", "extern", "false", "for", "friend", "goto", "if", "inline", "mutable", 
-     "namespace", "new", "operator", "private", "protected", "public", "register",
-      "reinterpret_cast", "return", "sizeof", "static", "static_cast", "struct",
-       "switch", "template", "this", "throw", "true", "try", "typedef", "typeid", 
-       "typename", "union", "using", "virtual", "void", "volatile", "while"};
+public:
+    Fuente() = default;
+    explicit Fuente(string texto) : copia(move(texto)), datos(copia.data()), tamano(copia.size()) {}
+    Fuente(const Fuente &) = delete;
+    Fuente &operator=(const Fuente &) = delete;
+    ~Fuente() { liberar(); }
 
-    // Verificar si es una palabra clave
-    for (const string &keyword : keywords)
+    // Abre el archivo indicado; devuelve false si no se puede leer
+    bool abrir(const string &ruta)
+    {
+        liberar();
+#ifdef _WIN32
+        HANDLE archivo = CreateFileA(ruta.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                     FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (archivo != INVALID_HANDLE_VALUE)
+        {
+            LARGE_INTEGER tam;
+            if (GetFileSizeEx(archivo, &tam) && tam.QuadPart > 0)
+            {
+                HANDLE proyeccion = CreateFileMappingA(archivo, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (proyeccion)
+                {
+                    void *vista = MapViewOfFile(proyeccion, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(proyeccion);
+                    if (vista)
+                    {
+                        CloseHandle(archivo);
+                        mapeo = vista;
+                        datos = static_cast<const char *>(vista);
+                        tamano = static_cast<size_t>(tam.QuadPart);
+                        return true;
+                    }
+                }
+            }
+            CloseHandle(archivo);
+        }
+#else
+        int fd = open(ruta.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+            {
+                void *vista = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (vista != MAP_FAILED)
+                {
+                    madvise(vista, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                    close(fd);
+                    mapeo = vista;
+                    datos = static_cast<const char *>(vista);
+                    tamano = static_cast<size_t>(info.st_size);
+                    return true;
+                }
+            }
+            close(fd);
+        }
+#endif
+        // Alternativa: leer todo el archivo con una sola lectura
+        ifstream archivo(ruta, ios::binary);
+        if (!archivo.is_open())
+        {
+            return false;
+        }
+        archivo.seekg(0, ios::end);
+        streamoff tam = archivo.tellg();
+        if (tam < 0)
+        {
+            // Sin tamaño conocido (p. ej. una tubería): se lee el flujo hasta el final
+            archivo.clear();
+            copia.assign(istreambuf_iterator<char>(archivo), istreambuf_iterator<char>());
+            datos = copia.data();
+            tamano = copia.size();
+            return true;
+        }
+        archivo.seekg(0, ios::beg);
+        copia.resize(static_cast<size_t>(tam));
+        if (!archivo.read(&copia[0], tam))
+        {
+            copia.clear();
+            return false;
+        }
+        datos = copia.data();
+        tamano = copia.size();
+        return true;
+    }
+
+    string_view contenido() const { return string_view(datos, tamano); }
+
+private:
+    string copia;             // Solo se usa cuando el texto no viene de una proyección
+    const char *datos = nullptr;
+    size_t tamano = 0;
+    void *mapeo = nullptr;    // Vista proyectada, o nullptr si se usa la copia
+
+    void liberar()
     {
-        if (word == keyword)
-            return TokenType::KEYWORD;
+        if (mapeo)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(mapeo);
+#else
+            munmap(mapeo, tamano);
+#endif
+            mapeo = nullptr;
+        }
+        copia.clear();
+        datos = nullptr;
+        tamano = 0;
     }
+};
+
+
+// Palabras clave del lenguaje
+constexpr string_view PALABRAS_CLAVE[] = {
+    "auto", "break", "case", "catch", "class",
+    "const", "continue", "default", "delete", "do", "else", "enum", "explicit",
+    "export", "extern", "false", "for", "friend", "goto", "if", "inline", "mutable",
+    "namespace", "new", "operator", "private", "protected", "public", "register",
+    "reinterpret_cast", "return", "sizeof", "static", "static_cast", "struct",
+    "switch", "template", "this", "throw", "true", "try", "typedef", "typeid",
+    "typename", "union", "using", "virtual", "void", "volatile", "while"
+};
+
+// Símbolos de un solo carácter
+constexpr string_view SIMBOLOS = "+-*/%(){}";
+
+// Tabla hash perfecta de palabras clave, generada en tiempo de compilación.
+// La función hash solo mira la longitud y tres caracteres (primero, segundo y último),
+// y se busca una semilla con la que ninguna palabra clave colisione.
+constexpr int BITS_TABLA_CLAVES = 8;
+
+constexpr uint32_t hashPalabraClave(string_view palabra, uint32_t semilla)
+{
+    uint32_t h = (semilla ^ static_cast<uint32_t>(palabra.size())) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[0])) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[palabra.size() > 1 ? 1 : 0])) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[palabra.size() - 1])) * 0x01000193u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    return h >> (32 - BITS_TABLA_CLAVES);
+}
+
+struct TablaPalabrasClave
+{
+    uint32_t semilla;
+    array<string_view, 1 << BITS_TABLA_CLAVES> ranuras;
+};
+
+constexpr TablaPalabrasClave construirTablaPalabrasClave()
+{
+    for (uint32_t semilla = 1; semilla < 100000; semilla++)
+    {
+        // Primero se prueba la semilla con un mapa de ranuras ocupadas
+        array<bool, 1 << BITS_TABLA_CLAVES> ocupadas{};
+        bool sinColisiones = true;
+        for (string_view palabra : PALABRAS_CLAVE)
+        {
+            bool &ocupada = ocupadas[hashPalabraClave(palabra, semilla)];
+            if (ocupada)
+            {
+                sinColisiones = false;
+                break;
+            }
+            ocupada = true;
+        }
+        if (!sinColisiones)
+            continue;
+
+        TablaPalabrasClave tabla{semilla, {}};
+        for (string_view palabra : PALABRAS_CLAVE)
+            tabla.ranuras[hashPalabraClave(palabra, semilla)] = palabra;
+        return tabla;
+    }
+    return {0, {}};
+}
+
+constexpr TablaPalabrasClave TABLA_PALABRAS_CLAVE = construirTablaPalabrasClave();
+static_assert(TABLA_PALABRAS_CLAVE.semilla != 0, "No se encontró una semilla sin colisiones para las palabras clave");
+
+// Búsqueda en O(1): una sola ranura candidata y una comparación
+inline bool esPalabraClave(string_view palabra)
+{
+    if (palabra.empty()) return false;
+    return TABLA_PALABRAS_CLAVE.ranuras[hashPalabraClave(palabra, TABLA_PALABRAS_CLAVE.semilla)] == palabra;
+}
+
+// Función para clasificar palabras
+TokenType identifyToken(string_view word)
+{
+    // Verificar si es una palabra clave
+    if (esPalabraClave(word))
+        return TokenType::KEYWORD;
 
     // Verificar si es un número (simplificación: solo enteros)
-    if (all_of(word.begin(), word.end(), ::isdigit))
+    if (all_of(word.begin(), word.end(), [](unsigned char c) { return isdigit(c) != 0; }))
         return TokenType::NUMBER;
 
     // Verificar si es un símbolo
-    if (word.size() == 1 && string("+-*/%(){}").find(word) != string::npos)
+    if (word.size() == 1 && SIMBOLOS.find(word) != string::npos)
         return TokenType::SYMBOL;
 
     // Por default, es un identificador
@@ -140,27 +330,43 @@ bool parseFactor(const vector<Token> &tokens, size_t &pos)
 }
 
 
+// Separa el texto en palabras delimitadas por espacios en blanco (equivale a leer con file >> word)
+vector<Token> separarPalabras(string_view texto)
+{
+    vector<Token> tokens;
+    size_t i = 0;
+    while (i < texto.size())
+    {
+        while (i < texto.size() && isspace(static_cast<unsigned char>(texto[i])))
+            i++;
+        size_t inicio = i;
+        while (i < texto.size() && !isspace(static_cast<unsigned char>(texto[i])))
+            i++;
+        if (i > inicio)
+        {
+            string_view word = texto.substr(inicio, i - inicio);
+            tokens.push_back({identifyToken(word), string(word)});
+        }
+    }
+    return tokens;
+}
+
 // Función principal
-int main()
+int main(int argc, char *argv[])
 {
-    ifstream file("prueba.txt");
+    // Archivo a analizar: el primer argumento, o prueba.txt por defecto
+    string ruta = argc >= 2 ? argv[1] : "prueba.txt";
 
-    // Verificar si el archivo se abrió correctamente
-    if (!file.is_open())
+    // Proyectar el archivo en memoria y verificar que se abrió correctamente
+    Fuente fuente;
+    if (!fuente.abrir(ruta))
     {
         cout << "Error al abrir el archivo." << endl;
         return 1; // O gestiona el error de otra manera
     }
 
-    string word;
-    vector<Token> tokens;
-
-    // Leer cada palabra del archivo
-    while (file >> word)
-    {
-        Token token = {identifyToken(word), word};
-        tokens.push_back(token);
-    }
+    // Separar todas las palabras del archivo de una sola vez
+    vector<Token> tokens = separarPalabras(fuente.contenido());
 
     // Imprimir los tokens identificados
     for (const Token &token : tokens)
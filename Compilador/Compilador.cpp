@@ -5,13 +5,37 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string_view>
 #include <iomanip>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <map>
+#include <charconv>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
 // Definir tipos de token
-enum class TokenType {
+enum class TokenType : uint8_t {
     KEYWORD,
     IDENTIFIER,
     NUMBER,
@@ -19,491 +43,7661 @@ enum class TokenType {
     UNKNOWN
 };
 
-// Estructura para representar tokens
+// Estructura para representar tokens: no copia el texto, solo guarda su posición en la fuente
 struct Token {
+    uint32_t offset; // Posición del primer carácter dentro de la fuente
+    uint32_t length; // Longitud del lexema
+    uint32_t line;   // Línea (desde 1)
+    uint16_t column; // Columna (desde 1, saturada en 65535)
     TokenType type;
-    string value;
 };
+static_assert(sizeof(Token) <= 16, "Token debe ocupar 16 bytes o menos");
 
-// Función para clasificar palabras
-TokenType identifyToken(const string &word) {
-    // Palabras clave
-    const vector<string> keywords = {
+// Texto fuente completo, de solo lectura. El archivo se proyecta en memoria (mmap o
+// MapViewOfFile) y, si no se puede, se lee con una sola lectura. Es el único dueño de los
+// caracteres; tokens y AST apuntan dentro de él. Los offsets de Token limitan la fuente a 4 GB.
+class Fuente {
+public:
+    Fuente() = default;
+    explicit Fuente(string texto) : copia(move(texto)), datos(copia.data()), tamano(copia.size()) {}
+    Fuente(const Fuente &) = delete;
+    Fuente &operator=(const Fuente &) = delete;
+    ~Fuente() { liberar(); }
+
+    // Abre el archivo indicado; devuelve false si no se puede leer
+    bool abrir(const string &ruta) {
+        liberar();
+#ifdef _WIN32
+        HANDLE archivo = CreateFileA(ruta.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                     FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (archivo != INVALID_HANDLE_VALUE) {
+            LARGE_INTEGER tam;
+            if (GetFileSizeEx(archivo, &tam) && tam.QuadPart > 0) {
+                HANDLE proyeccion = CreateFileMappingA(archivo, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (proyeccion) {
+                    void *vista = MapViewOfFile(proyeccion, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(proyeccion);
+                    if (vista) {
+                        CloseHandle(archivo);
+                        mapeo = vista;
+                        datos = static_cast<const char *>(vista);
+                        tamano = static_cast<size_t>(tam.QuadPart);
+                        return true;
+                    }
+                }
+            }
+            CloseHandle(archivo);
+        }
+#else
+        int fd = open(ruta.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+                void *vista = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (vista != MAP_FAILED) {
+                    madvise(vista, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                    close(fd);
+                    mapeo = vista;
+                    datos = static_cast<const char *>(vista);
+                    tamano = static_cast<size_t>(info.st_size);
+                    return true;
+                }
+            }
+            close(fd);
+        }
+#endif
+        // Alternativa: leer todo el archivo con una sola lectura
+        ifstream archivo(ruta, ios::binary);
+        if (!archivo.is_open()) {
+            return false;
+        }
+        archivo.seekg(0, ios::end);
+        streamoff tam = archivo.tellg();
+        if (tam < 0) {
+            // Sin tamaño conocido (p. ej. una tubería): se lee el flujo hasta el final
+            archivo.clear();
+            copia.assign(istreambuf_iterator<char>(archivo), istreambuf_iterator<char>());
+            datos = copia.data();
+            tamano = copia.size();
+            return true;
+        }
+        archivo.seekg(0, ios::beg);
+        copia.resize(static_cast<size_t>(tam));
+        if (!archivo.read(&copia[0], tam)) {
+            copia.clear();
+            return false;
+        }
+        datos = copia.data();
+        tamano = copia.size();
+        return true;
+    }
+
+    string_view contenido() const { return string_view(datos, tamano); }
+
+    string_view lexema(const Token &token) const {
+        return contenido().substr(token.offset, token.length);
+    }
+
+private:
+    string copia;             // Solo se usa cuando el texto no viene de una proyección
+    const char *datos = nullptr;
+    size_t tamano = 0;
+    void *mapeo = nullptr;    // Vista proyectada, o nullptr si se usa la copia
+
+    void liberar() {
+        if (mapeo) {
+#ifdef _WIN32
+            UnmapViewOfFile(mapeo);
+#else
+            munmap(mapeo, tamano);
+#endif
+            mapeo = nullptr;
+        }
+        copia.clear();
+        datos = nullptr;
+        tamano = 0;
+    }
+};
+
+// Palabras clave del lenguaje
+constexpr string_view PALABRAS_CLAVE[] = {
         "auto", "break", "case", "catch", "class", "const", "continue", "default", "delete",
         "do", "else", "enum", "explicit", "export", "extern", "false", "for", "friend", "goto",
         "if", "inline", "mutable", "namespace", "new", "operator", "private", "protected", "public",
         "register", "reinterpret_cast", "return", "sizeof", "static", "static_cast", "struct", "switch",
         "template", "this", "throw", "true", "try", "typedef", "typeid", "typename", "union", "using",
         "virtual", "void", "volatile", "while", "int", "string"
-    };
+};
+
+// Símbolos de un solo carácter
+constexpr string_view SIMBOLOS = "+-*/%(){}=;";
+
+// Tabla hash perfecta de palabras clave, generada en tiempo de compilación.
+// La función hash solo mira la longitud y tres caracteres (primero, segundo y último),
+// y se busca una semilla con la que ninguna palabra clave colisione.
+constexpr int BITS_TABLA_CLAVES = 8;
+
+constexpr uint32_t hashPalabraClave(string_view palabra, uint32_t semilla) {
+    uint32_t h = (semilla ^ static_cast<uint32_t>(palabra.size())) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[0])) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[palabra.size() > 1 ? 1 : 0])) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[palabra.size() - 1])) * 0x01000193u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    return h >> (32 - BITS_TABLA_CLAVES);
+}
+
+struct TablaPalabrasClave {
+    uint32_t semilla;
+    array<string_view, 1 << BITS_TABLA_CLAVES> ranuras;
+};
+
+constexpr TablaPalabrasClave construirTablaPalabrasClave() {
+    for (uint32_t semilla = 1; semilla < 100000; semilla++) {
+        // Primero se prueba la semilla con un mapa de ranuras ocupadas
+        array<bool, 1 << BITS_TABLA_CLAVES> ocupadas{};
+        bool sinColisiones = true;
+        for (string_view palabra : PALABRAS_CLAVE) {
+            bool &ocupada = ocupadas[hashPalabraClave(palabra, semilla)];
+            if (ocupada) {
+                sinColisiones = false;
+                break;
+            }
+            ocupada = true;
+        }
+        if (!sinColisiones) continue;
+
+        TablaPalabrasClave tabla{semilla, {}};
+        for (string_view palabra : PALABRAS_CLAVE) {
+            tabla.ranuras[hashPalabraClave(palabra, semilla)] = palabra;
+        }
+        return tabla;
+    }
+    return {0, {}};
+}
 
+constexpr TablaPalabrasClave TABLA_PALABRAS_CLAVE = construirTablaPalabrasClave();
+static_assert(TABLA_PALABRAS_CLAVE.semilla != 0, "No se encontró una semilla sin colisiones para las palabras clave");
+
+// Búsqueda en O(1): una sola ranura candidata y una comparación
+inline bool esPalabraClave(string_view palabra) {
+    if (palabra.empty()) return false;
+    return TABLA_PALABRAS_CLAVE.ranuras[hashPalabraClave(palabra, TABLA_PALABRAS_CLAVE.semilla)] == palabra;
+}
+
+// Función para clasificar palabras
+TokenType identifyToken(string_view word) {
     // Verificar si es una palabra clave
-    if (find(keywords.begin(), keywords.end(), word) != keywords.end()) {
+    if (esPalabraClave(word)) {
         return TokenType::KEYWORD;
     }
 
-    // Verificar si es un número (simplificación: solo enteros)
-    if (all_of(word.begin(), word.end(), ::isdigit)) {
-        return TokenType::NUMBER;
-    }
+    // Verificar si es un número (simplificación: solo enteros)
+    if (all_of(word.begin(), word.end(), [](unsigned char c) { return isdigit(c) != 0; })) {
+        return TokenType::NUMBER;
+    }
+
+    // Verificar si es un símbolo
+    if (word.size() == 1 && SIMBOLOS.find(word) != string::npos) {
+        return TokenType::SYMBOL;
+    }
+
+    // Por default, es un identificador
+    return TokenType::IDENTIFIER;
+}
+
+// ---------------------------------------------------------------------------
+// Analizador léxico basado en tablas (autómata finito determinista)
+// ---------------------------------------------------------------------------
+
+// Clases de caracteres: cada byte de la entrada se reduce a una de estas clases
+enum ClaseCaracter : uint8_t {
+    CC_OTRO,
+    CC_ESPACIO,
+    CC_SALTO,
+    CC_LETRA,
+    CC_DIGITO,
+    CC_COMILLA,
+    CC_ESCAPE,
+    CC_MAS,
+    CC_MENOS,
+    CC_IGUAL,
+    CC_MENOR,
+    CC_MAYOR,
+    CC_AMPERSAND,
+    CC_BARRA,
+    CC_EXCLAMACION,
+    CC_OPERADOR,    // * / % ^ : solo se combinan con '='
+    CC_DELIMITADOR, // ( ) { } [ ] ; , . : ? ~ #
+    NUM_CLASES
+};
+
+// Estados del autómata. Todos los estados desde E_IDENTIFICADOR son de aceptación.
+enum EstadoLexico : uint8_t {
+    E_ERROR,
+    E_INICIO,
+    E_CADENA,
+    E_CADENA_ESCAPE,
+    E_IDENTIFICADOR,
+    E_NUMERO,
+    E_CADENA_FIN,
+    E_MAS,
+    E_MENOS,
+    E_IGUAL,
+    E_MENOR,
+    E_MAYOR,
+    E_MENOR_MENOR,
+    E_MAYOR_MAYOR,
+    E_AMPERSAND,
+    E_BARRA,
+    E_EXCLAMACION,
+    E_OPERADOR,
+    E_OPERADOR_FIN,
+    E_DELIMITADOR,
+    E_DESCONOCIDO,
+    NUM_ESTADOS
+};
+
+using TablaClases = array<uint8_t, 256>;
+using TablaTransiciones = array<array<uint8_t, NUM_CLASES>, NUM_ESTADOS>;
+
+constexpr TablaClases construirTablaClases() {
+    TablaClases clases{};
+    for (int c = 0; c < 256; c++) {
+        // Los bytes >= 0x80 se tratan como letras para aceptar identificadores UTF-8
+        clases[c] = c >= 0x80 ? CC_LETRA : CC_OTRO;
+    }
+    for (int c = 'a'; c <= 'z'; c++) clases[c] = CC_LETRA;
+    for (int c = 'A'; c <= 'Z'; c++) clases[c] = CC_LETRA;
+    for (int c = '0'; c <= '9'; c++) clases[c] = CC_DIGITO;
+    clases['_'] = CC_LETRA;
+    clases[' '] = clases['\t'] = clases['\r'] = clases['\v'] = clases['\f'] = CC_ESPACIO;
+    clases['\n'] = CC_SALTO;
+    clases['"'] = CC_COMILLA;
+    clases['\\'] = CC_ESCAPE;
+    clases['+'] = CC_MAS;
+    clases['-'] = CC_MENOS;
+    clases['='] = CC_IGUAL;
+    clases['<'] = CC_MENOR;
+    clases['>'] = CC_MAYOR;
+    clases['&'] = CC_AMPERSAND;
+    clases['|'] = CC_BARRA;
+    clases['!'] = CC_EXCLAMACION;
+    clases['*'] = clases['/'] = clases['%'] = clases['^'] = CC_OPERADOR;
+    for (char c : {'(', ')', '{', '}', '[', ']', ';', ',', '.', ':', '?', '~', '#'}) {
+        clases[static_cast<unsigned char>(c)] = CC_DELIMITADOR;
+    }
+    return clases;
+}
+
+constexpr TablaTransiciones construirTablaTransiciones() {
+    TablaTransiciones t{}; // Todo lo no definido lleva a E_ERROR
+
+    t[E_INICIO][CC_OTRO] = E_DESCONOCIDO;
+    t[E_INICIO][CC_ESCAPE] = E_DESCONOCIDO;
+    t[E_INICIO][CC_LETRA] = E_IDENTIFICADOR;
+    t[E_INICIO][CC_DIGITO] = E_NUMERO;
+    t[E_INICIO][CC_COMILLA] = E_CADENA;
+    t[E_INICIO][CC_MAS] = E_MAS;
+    t[E_INICIO][CC_MENOS] = E_MENOS;
+    t[E_INICIO][CC_IGUAL] = E_IGUAL;
+    t[E_INICIO][CC_MENOR] = E_MENOR;
+    t[E_INICIO][CC_MAYOR] = E_MAYOR;
+    t[E_INICIO][CC_AMPERSAND] = E_AMPERSAND;
+    t[E_INICIO][CC_BARRA] = E_BARRA;
+    t[E_INICIO][CC_EXCLAMACION] = E_EXCLAMACION;
+    t[E_INICIO][CC_OPERADOR] = E_OPERADOR;
+    t[E_INICIO][CC_DELIMITADOR] = E_DELIMITADOR;
+
+    // Identificadores y números
+    t[E_IDENTIFICADOR][CC_LETRA] = E_IDENTIFICADOR;
+    t[E_IDENTIFICADOR][CC_DIGITO] = E_IDENTIFICADOR;
+    t[E_NUMERO][CC_DIGITO] = E_NUMERO;
+
+    // Cadenas entre comillas dobles (no pueden cruzar un salto de línea)
+    for (int c = 0; c < NUM_CLASES; c++) {
+        t[E_CADENA][c] = E_CADENA;
+        t[E_CADENA_ESCAPE][c] = E_CADENA;
+    }
+    t[E_CADENA][CC_COMILLA] = E_CADENA_FIN;
+    t[E_CADENA][CC_ESCAPE] = E_CADENA_ESCAPE;
+    t[E_CADENA][CC_SALTO] = E_ERROR;
+    t[E_CADENA_ESCAPE][CC_SALTO] = E_ERROR;
+
+    // Operadores de dos o tres caracteres: ++ += -- -= -> == <= << <<= >= >> >>= && &= || |= != *= /= %= ^=
+    t[E_MAS][CC_MAS] = E_OPERADOR_FIN;
+    t[E_MAS][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MENOS][CC_MENOS] = E_OPERADOR_FIN;
+    t[E_MENOS][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MENOS][CC_MAYOR] = E_OPERADOR_FIN;
+    t[E_IGUAL][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MENOR][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MENOR][CC_MENOR] = E_MENOR_MENOR;
+    t[E_MENOR_MENOR][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MAYOR][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MAYOR][CC_MAYOR] = E_MAYOR_MAYOR;
+    t[E_MAYOR_MAYOR][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_AMPERSAND][CC_AMPERSAND] = E_OPERADOR_FIN;
+    t[E_AMPERSAND][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_BARRA][CC_BARRA] = E_OPERADOR_FIN;
+    t[E_BARRA][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_EXCLAMACION][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_OPERADOR][CC_IGUAL] = E_OPERADOR_FIN;
+    return t;
+}
+
+// Tablas construidas una sola vez, en tiempo de compilación
+constexpr TablaClases CLASES_CARACTER = construirTablaClases();
+constexpr TablaTransiciones TRANSICIONES = construirTablaTransiciones();
+
+// Tipo de token que produce cada estado de aceptación
+TokenType tipoPorEstado(uint8_t estado, string_view lexema) {
+    switch (estado) {
+        case E_IDENTIFICADOR: return esPalabraClave(lexema) ? TokenType::KEYWORD : TokenType::IDENTIFIER;
+        case E_NUMERO: return TokenType::NUMBER;
+        case E_CADENA_FIN: return TokenType::IDENTIFIER; // Las cadenas se tratan como identificadores
+        case E_DESCONOCIDO: return TokenType::UNKNOWN;
+        default: return TokenType::SYMBOL;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Núcleos vectoriales para el analizador léxico
+// ---------------------------------------------------------------------------
+// Las rachas de espacios, identificadores, números y el interior de las cadenas se consumen
+// en bloque, 16 (SSE2) o 32 (AVX2) bytes por iteración. La implementación se elige en tiempo
+// de ejecución según la CPU; la versión escalar sirve de respaldo y para el resto de cada bloque.
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define LEXICO_X86 1
+#include <immintrin.h>
+#endif
+
+struct NucleosLexicos {
+    const char *nombre;
+    // Salta espacios y saltos de línea; actualiza el número de línea y el inicio de la línea actual
+    size_t (*saltarEspacios)(const unsigned char *texto, size_t i, size_t n, uint32_t &linea, size_t &inicioLinea);
+    // Devuelven la primera posición que ya no pertenece a la racha
+    size_t (*finIdentificador)(const unsigned char *texto, size_t i, size_t n);
+    size_t (*finNumero)(const unsigned char *texto, size_t i, size_t n);
+    size_t (*finCadena)(const unsigned char *texto, size_t i, size_t n); // Se detiene en '"', '\\' o '\n'
+};
+
+size_t saltarEspaciosEscalar(const unsigned char *texto, size_t i, size_t n, uint32_t &linea, size_t &inicioLinea) {
+    while (i < n) {
+        uint8_t clase = CLASES_CARACTER[texto[i]];
+        if (clase == CC_SALTO) {
+            linea++;
+            inicioLinea = i + 1;
+        } else if (clase != CC_ESPACIO) {
+            break;
+        }
+        i++;
+    }
+    return i;
+}
+
+size_t finIdentificadorEscalar(const unsigned char *texto, size_t i, size_t n) {
+    while (i < n && (CLASES_CARACTER[texto[i]] == CC_LETRA || CLASES_CARACTER[texto[i]] == CC_DIGITO)) i++;
+    return i;
+}
+
+size_t finNumeroEscalar(const unsigned char *texto, size_t i, size_t n) {
+    while (i < n && CLASES_CARACTER[texto[i]] == CC_DIGITO) i++;
+    return i;
+}
+
+size_t finCadenaEscalar(const unsigned char *texto, size_t i, size_t n) {
+    while (i < n && texto[i] != '"' && texto[i] != '\\' && texto[i] != '\n') i++;
+    return i;
+}
+
+constexpr NucleosLexicos NUCLEOS_ESCALARES = {
+    "escalar", saltarEspaciosEscalar, finIdentificadorEscalar, finNumeroEscalar, finCadenaEscalar};
+
+#ifdef LEXICO_X86
+// Cada núcleo calcula una máscara con un bit por byte que sigue dentro de la racha; el primer
+// bit apagado marca el final. Las comparaciones sin signo "x <= k" se hacen con min_epu8(x, k) == x.
+
+inline __m128i enRango128(__m128i bytes, char desde, char cuantos) {
+    __m128i x = _mm_sub_epi8(bytes, _mm_set1_epi8(desde));
+    return _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(cuantos)), x);
+}
+
+inline __m128i esEspacio128(__m128i bytes) {
+    // ' ' o '\t' '\n' '\v' '\f' '\r' (9..13)
+    return _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), enRango128(bytes, 9, 4));
+}
+
+inline __m128i esDigito128(__m128i bytes) {
+    return enRango128(bytes, '0', 9);
+}
+
+inline __m128i esIdentificador128(__m128i bytes) {
+    __m128i letra = enRango128(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 25);
+    __m128i guion = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_'));
+    __m128i alto = _mm_cmplt_epi8(bytes, _mm_setzero_si128()); // Bytes >= 0x80 (UTF-8)
+    return _mm_or_si128(_mm_or_si128(letra, guion), _mm_or_si128(alto, esDigito128(bytes)));
+}
+
+inline __m128i esFinCadena128(__m128i bytes) {
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))),
+                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+}
+
+size_t saltarEspaciosSSE2(const unsigned char *texto, size_t i, size_t n, uint32_t &linea, size_t &inicioLinea) {
+    while (i + 16 <= n) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(texto + i));
+        uint32_t espacios = static_cast<uint32_t>(_mm_movemask_epi8(esEspacio128(bytes)));
+        uint32_t saltos = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))));
+        uint32_t fuera = ~espacios & 0xFFFFu;
+        int largo = fuera ? __builtin_ctz(fuera) : 16;
+        saltos &= (1u << largo) - 1;
+        if (saltos) {
+            linea += static_cast<uint32_t>(__builtin_popcount(saltos));
+            inicioLinea = i + static_cast<size_t>(31 - __builtin_clz(saltos)) + 1;
+        }
+        i += static_cast<size_t>(largo);
+        if (fuera) return i;
+    }
+    return saltarEspaciosEscalar(texto, i, n, linea, inicioLinea);
+}
+
+size_t finIdentificadorSSE2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 16 <= n) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(texto + i));
+        uint32_t fuera = ~static_cast<uint32_t>(_mm_movemask_epi8(esIdentificador128(bytes))) & 0xFFFFu;
+        if (fuera) return i + static_cast<size_t>(__builtin_ctz(fuera));
+        i += 16;
+    }
+    return finIdentificadorEscalar(texto, i, n);
+}
+
+size_t finNumeroSSE2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 16 <= n) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(texto + i));
+        uint32_t fuera = ~static_cast<uint32_t>(_mm_movemask_epi8(esDigito128(bytes))) & 0xFFFFu;
+        if (fuera) return i + static_cast<size_t>(__builtin_ctz(fuera));
+        i += 16;
+    }
+    return finNumeroEscalar(texto, i, n);
+}
+
+size_t finCadenaSSE2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 16 <= n) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(texto + i));
+        uint32_t fin = static_cast<uint32_t>(_mm_movemask_epi8(esFinCadena128(bytes)));
+        if (fin) return i + static_cast<size_t>(__builtin_ctz(fin));
+        i += 16;
+    }
+    return finCadenaEscalar(texto, i, n);
+}
+
+constexpr NucleosLexicos NUCLEOS_SSE2 = {
+    "sse2", saltarEspaciosSSE2, finIdentificadorSSE2, finNumeroSSE2, finCadenaSSE2};
+
+// Versiones AVX2: se compilan con el atributo target para no exigir -mavx2 al resto del programa
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 inline __m256i enRango256(__m256i bytes, char desde, char cuantos) {
+    __m256i x = _mm256_sub_epi8(bytes, _mm256_set1_epi8(desde));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(cuantos)), x);
+}
+
+AVX2 inline __m256i esDigito256(__m256i bytes) {
+    return enRango256(bytes, '0', 9);
+}
+
+AVX2 size_t saltarEspaciosAVX2(const unsigned char *texto, size_t i, size_t n, uint32_t &linea, size_t &inicioLinea) {
+    while (i + 32 <= n) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(texto + i));
+        __m256i espacio = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')), enRango256(bytes, 9, 4));
+        uint32_t fuera = ~static_cast<uint32_t>(_mm256_movemask_epi8(espacio));
+        uint32_t saltos = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'))));
+        int largo = fuera ? __builtin_ctz(fuera) : 32;
+        if (largo < 32) saltos &= (1u << largo) - 1;
+        if (saltos) {
+            linea += static_cast<uint32_t>(__builtin_popcount(saltos));
+            inicioLinea = i + static_cast<size_t>(31 - __builtin_clz(saltos)) + 1;
+        }
+        i += static_cast<size_t>(largo);
+        if (fuera) return i;
+    }
+    return saltarEspaciosSSE2(texto, i, n, linea, inicioLinea);
+}
+
+AVX2 size_t finIdentificadorAVX2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 32 <= n) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(texto + i));
+        __m256i letra = enRango256(_mm256_or_si256(bytes, _mm256_set1_epi8(0x20)), 'a', 25);
+        __m256i guion = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_'));
+        __m256i valido = _mm256_or_si256(_mm256_or_si256(letra, guion), esDigito256(bytes));
+        // Los bytes >= 0x80 ya tienen el bit alto encendido, que es lo que mira movemask
+        uint32_t fuera = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(valido, bytes)));
+        if (fuera) return i + static_cast<size_t>(__builtin_ctz(fuera));
+        i += 32;
+    }
+    return finIdentificadorSSE2(texto, i, n);
+}
+
+AVX2 size_t finNumeroAVX2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 32 <= n) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(texto + i));
+        uint32_t fuera = ~static_cast<uint32_t>(_mm256_movemask_epi8(esDigito256(bytes)));
+        if (fuera) return i + static_cast<size_t>(__builtin_ctz(fuera));
+        i += 32;
+    }
+    return finNumeroSSE2(texto, i, n);
+}
+
+AVX2 size_t finCadenaAVX2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 32 <= n) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(texto + i));
+        __m256i fin = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')),
+                                                      _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'))),
+                                      _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+        uint32_t mascara = static_cast<uint32_t>(_mm256_movemask_epi8(fin));
+        if (mascara) return i + static_cast<size_t>(__builtin_ctz(mascara));
+        i += 32;
+    }
+    return finCadenaSSE2(texto, i, n);
+}
+
+#undef AVX2
+
+constexpr NucleosLexicos NUCLEOS_AVX2 = {
+    "avx2", saltarEspaciosAVX2, finIdentificadorAVX2, finNumeroAVX2, finCadenaAVX2};
+#endif
+
+// Núcleos disponibles en esta CPU, del más lento al más rápido
+vector<const NucleosLexicos *> nucleosDisponibles() {
+    vector<const NucleosLexicos *> disponibles = {&NUCLEOS_ESCALARES};
+#ifdef LEXICO_X86
+    disponibles.push_back(&NUCLEOS_SSE2);
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        disponibles.push_back(&NUCLEOS_AVX2);
+    }
+#endif
+    return disponibles;
+}
+
+// Se elige una sola vez el mejor núcleo que soporta la CPU
+const NucleosLexicos &nucleosLexicos() {
+    static const NucleosLexicos *elegidos = nucleosDisponibles().back();
+    return *elegidos;
+}
+
+// Cursor léxico: entrega un token por llamada, en orden, aplicando la regla del lexema
+// más largo. Solo guarda la posición, así que su memoria no depende del archivo.
+class CursorLexico {
+public:
+    explicit CursorLexico(const Fuente &fuente, const NucleosLexicos &nucleos = nucleosLexicos())
+        : contenido(fuente.contenido()), texto(reinterpret_cast<const unsigned char *>(contenido.data())),
+          n(contenido.size()), nucleos(nucleos) {}
+
+    // Deja el siguiente token en `token`; devuelve false al llegar al final del texto
+    bool siguiente(Token &token) {
+        while (i < n) {
+            uint8_t clase = CLASES_CARACTER[texto[i]];
+            if (clase == CC_ESPACIO || clase == CC_SALTO) {
+                // Un espacio suelto entre tokens es lo más común: no vale la pena llamar al núcleo
+                if (clase == CC_ESPACIO && i + 1 < n) {
+                    uint8_t siguiente = CLASES_CARACTER[texto[i + 1]];
+                    if (siguiente != CC_ESPACIO && siguiente != CC_SALTO) {
+                        i++;
+                        continue;
+                    }
+                }
+                i = nucleos.saltarEspacios(texto, i, n, linea, inicioLinea);
+                continue;
+            }
+
+            size_t inicio = i;
+            uint8_t aceptado = E_ERROR;
+            size_t fin = inicio;
+            if (clase == CC_LETRA) {
+                // Identificadores y números solo se repiten sobre sí mismos: se consume la racha entera
+                aceptado = E_IDENTIFICADOR;
+                fin = nucleos.finIdentificador(texto, i + 1, n);
+            } else if (clase == CC_DIGITO) {
+                aceptado = E_NUMERO;
+                fin = nucleos.finNumero(texto, i + 1, n);
+            } else {
+                uint8_t estado = E_INICIO;
+                while (i < n) {
+                    estado = TRANSICIONES[estado][CLASES_CARACTER[texto[i]]];
+                    if (estado == E_ERROR) break;
+                    i++;
+                    if (estado == E_CADENA) {
+                        i = nucleos.finCadena(texto, i, n);
+                    }
+                    if (estado >= E_IDENTIFICADOR) {
+                        aceptado = estado;
+                        fin = i;
+                    }
+                }
+            }
+
+            // Sin estado de aceptación (p. ej. una comilla sin cerrar): se emite un solo carácter
+            if (aceptado == E_ERROR) {
+                aceptado = E_DESCONOCIDO;
+                fin = inicio + 1;
+            }
+            i = fin;
+
+            string_view lexema(contenido.data() + inicio, fin - inicio);
+            uint16_t columna = static_cast<uint16_t>(min<size_t>(inicio - inicioLinea + 1, UINT16_MAX));
+            token = {static_cast<uint32_t>(inicio), static_cast<uint32_t>(fin - inicio), linea, columna,
+                     tipoPorEstado(aceptado, lexema)};
+            return true;
+        }
+        return false;
+    }
+
+private:
+    string_view contenido;
+    const unsigned char *texto;
+    size_t n;
+    const NucleosLexicos &nucleos;
+    size_t i = 0;
+    uint32_t linea = 1;
+    size_t inicioLinea = 0;
+};
+
+// Todos los tokens del texto de una vez, para quien necesita la lista completa
+vector<Token> tokenize(const Fuente &fuente, const NucleosLexicos &nucleos = nucleosLexicos()) {
+    vector<Token> tokens;
+    tokens.reserve(fuente.contenido().size() / 6 + 16); // Estimación: en el código típico hay un token cada 6-8 bytes
+    CursorLexico cursor(fuente, nucleos);
+    Token token;
+    while (cursor.siguiente(token)) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+// ---------------------------------------------------------------------------
+// Internador de nombres: cada nombre distinto (identificador, tipo, ámbito, operador) se
+// guarda una sola vez y se representa con un id de 32 bits. Las fases comparan ids.
+// ---------------------------------------------------------------------------
+
+using IdNombre = uint32_t;
+
+// FNV-1a de 32 bits sobre el texto del nombre
+inline uint32_t hashNombre(string_view texto) {
+    uint32_t h = 0x811C9DC5u;
+    for (unsigned char c : texto) {
+        h = (h ^ c) * 0x01000193u;
+    }
+    return h;
+}
+
+// Asigna a cada nombre distinto un número consecutivo. Después de internar, dos nombres
+// son iguales si y solo si sus números lo son. Guarda su propia copia de cada texto.
+class Internador {
+public:
+    static constexpr IdNombre NINGUNO = UINT32_MAX;
+
+    IdNombre internar(string_view texto) {
+        if ((textos.size() + 1) * 2 > ranuras.size()) {
+            crecer();
+        }
+        uint32_t h = hashNombre(texto);
+        size_t i = ranura(texto, h);
+        if (ranuras[i] == NINGUNO) {
+            ranuras[i] = static_cast<IdNombre>(textos.size());
+            textos.push_back(guardar(texto));
+            hashes.push_back(h);
+        }
+        return ranuras[i];
+    }
+
+    // Número de un nombre ya internado, o NINGUNO; no agrega nada
+    IdNombre buscar(string_view texto) const {
+        return ranuras.empty() ? NINGUNO : ranuras[ranura(texto, hashNombre(texto))];
+    }
+
+    string_view texto(IdNombre id) const { return textos[id]; }
+    size_t size() const { return textos.size(); }
+
+private:
+    static constexpr size_t TAM_BLOQUE = 64 * 1024;
+
+    vector<string_view> textos;    // id -> texto
+    vector<uint32_t> hashes;       // id -> hash, para no recalcularlo al crecer
+    vector<IdNombre> ranuras;      // direccionamiento abierto con sondeo lineal
+    vector<unique_ptr<char[]>> bloques;
+    char *libre = nullptr;
+    char *fin = nullptr;
+
+    // Ranura que contiene el nombre, o la ranura libre donde debería ir
+    size_t ranura(string_view texto, uint32_t h) const {
+        size_t mascara = ranuras.size() - 1;
+        size_t i = h & mascara;
+        while (ranuras[i] != NINGUNO && (hashes[ranuras[i]] != h || textos[ranuras[i]] != texto)) {
+            i = (i + 1) & mascara;
+        }
+        return i;
+    }
+
+    void crecer() {
+        ranuras.assign(max<size_t>(64, ranuras.size() * 2), NINGUNO);
+        size_t mascara = ranuras.size() - 1;
+        for (IdNombre id = 0; id < textos.size(); id++) {
+            size_t i = hashes[id] & mascara;
+            while (ranuras[i] != NINGUNO) {
+                i = (i + 1) & mascara;
+            }
+            ranuras[i] = id;
+        }
+    }
+
+    string_view guardar(string_view texto) {
+        if (texto.size() > static_cast<size_t>(fin - libre)) {
+            size_t tam = max(TAM_BLOQUE, texto.size());
+            bloques.emplace_back(new char[tam]);
+            libre = bloques.back().get();
+            fin = libre + tam;
+        }
+        char *copia = libre;
+        copy(texto.begin(), texto.end(), copia);
+        libre += texto.size();
+        return {copia, texto.size()};
+    }
+};
+
+// Nombres que las fases usan directamente. Se internan primero y en este orden, así que
+// su id coincide con su posición y se comparan contra constantes.
+enum NombreFijo : IdNombre {
+    N_VACIO,
+    N_INT,
+    N_STRING,
+    N_DESCONOCIDO,
+    N_GLOBAL,
+    N_CONDITION,
+    N_MAS,
+    N_MENOS,
+    N_POR,
+    N_ENTRE,
+    N_MODULO,
+    N_MENOR,
+    N_MENOR_IGUAL,
+    N_MAYOR,
+    N_MAYOR_IGUAL,
+    N_IGUAL,
+    N_DISTINTO,
+    N_Y,
+    N_O,
+    N_NO,
+    N_DESPLAZAR,
+};
+
+constexpr string_view NOMBRES_FIJOS[] = {
+    "", "int", "string", "desconocido", "global", "condition",
+    "+", "-", "*", "/", "%", "<", "<=", ">", ">=", "==", "!=", "&&", "||", "!", "<<",
+};
+
+// Internador compartido por el parser, el analizador semántico y el generador de TAC.
+// Hay uno por hilo: la compilación por lotes corre archivos en paralelo sin candados, y
+// como los nombres fijos se internan primero en todos, sus ids coinciden entre hilos.
+inline Internador &nombres() {
+    static thread_local Internador global = [] {
+        Internador internador;
+        for (string_view nombre : NOMBRES_FIJOS) {
+            internador.internar(nombre);
+        }
+        return internador;
+    }();
+    return global;
+}
+
+inline IdNombre internar(string_view texto) {
+    return nombres().internar(texto);
+}
+
+inline string_view nombreDe(IdNombre id) {
+    return nombres().texto(id);
+}
+
+// ---------------------------------------------------------------------------
+// Arena de memoria para el AST
+// ---------------------------------------------------------------------------
+
+// Secuencia de elementos guardada en una arena (no es dueña de la memoria)
+template <typename T>
+struct Lista {
+    T *datos = nullptr;
+    uint32_t cantidad = 0;
+
+    T *begin() const { return datos; }
+    T *end() const { return datos + cantidad; }
+    size_t size() const { return cantidad; }
+    bool empty() const { return cantidad == 0; }
+    T &operator[](size_t i) const { return datos[i]; }
+};
+
+// Reserva bloques grandes y reparte trozos consecutivos. Todo el AST de una unidad de
+// compilación vive en una sola arena y se libera de una vez, sin recorrer los nodos.
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // Construye un objeto dentro de la arena. Su destructor nunca se ejecuta, así que los
+    // nodos solo deben tener miembros que no liberan nada (punteros, string_view, Lista).
+    template <typename T, typename... Args>
+    T *crear(Args &&...args) {
+        return new (reservar(sizeof(T), alignof(T))) T(forward<Args>(args)...);
+    }
+
+    // Copia una secuencia de elementos a la arena
+    template <typename T>
+    Lista<T> copiar(const T *datos, size_t cantidad) {
+        static_assert(is_trivially_copyable<T>::value, "Solo se copian tipos triviales a la arena");
+        if (cantidad == 0) {
+            return {};
+        }
+        T *destino = static_cast<T *>(reservar(sizeof(T) * cantidad, alignof(T)));
+        copy(datos, datos + cantidad, destino);
+        return {destino, static_cast<uint32_t>(cantidad)};
+    }
+
+    template <typename T>
+    Lista<T> copiar(initializer_list<T> elementos) {
+        return copiar(elementos.begin(), elementos.size());
+    }
+
+    // Libera todos los bloques en una sola llamada
+    void liberar() {
+        bloques.clear();
+        actual = fin = nullptr;
+        usados = 0;
+    }
+
+    size_t bytesUsados() const { return usados; }
+
+private:
+    static constexpr size_t TAM_BLOQUE = 256 * 1024;
+
+    vector<unique_ptr<char[]>> bloques;
+    char *actual = nullptr;
+    char *fin = nullptr;
+    size_t usados = 0;
+
+    void *reservar(size_t bytes, size_t alineacion) {
+        char *inicio = alinear(actual, alineacion);
+        if (!actual || bytes > static_cast<size_t>(fin - inicio)) {
+            size_t tam = max(TAM_BLOQUE, bytes + alineacion);
+            bloques.emplace_back(new char[tam]);
+            actual = bloques.back().get();
+            fin = actual + tam;
+            inicio = alinear(actual, alineacion);
+        }
+        actual = inicio + bytes;
+        usados += bytes;
+        return inicio;
+    }
+
+    static char *alinear(char *p, size_t alineacion) {
+        uintptr_t valor = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char *>((valor + alineacion - 1) & ~static_cast<uintptr_t>(alineacion - 1));
+    }
+};
+
+// Etiqueta de la clase concreta de cada nodo. Los recorridos despachan con un switch
+// sobre este byte en lugar de probar dynamic_cast contra cada clase.
+enum class TipoNodo : uint8_t {
+    FunctionDef,
+    Assign,
+    Literal,
+    Return,
+    If,
+    While,
+    BinaryOp,
+    UnaryOp,
+};
+
+// Definición de clases del AST. Los nodos se crean en una Arena y se enlazan con punteros simples.
+class ASTNode {
+public:
+    const TipoNodo tipo;
+
+    explicit ASTNode(TipoNodo tipo) : tipo(tipo) {}
+    virtual ~ASTNode() = default;
+};
+
+using ListaNodos = Lista<ASTNode *>;
+
+class FunctionDef : public ASTNode {
+public:
+    static constexpr TipoNodo TIPO = TipoNodo::FunctionDef;
+
+    IdNombre name;
+    Lista<IdNombre> args;
+    ListaNodos body;
+    IdNombre return_type;
+
+    FunctionDef(IdNombre name, Lista<IdNombre> args, ListaNodos body, IdNombre return_type)
+        : ASTNode(TIPO), name(name), args(args), body(body), return_type(return_type) {}
+};
+
+class Assign : public ASTNode {
+public:
+    static constexpr TipoNodo TIPO = TipoNodo::Assign;
+
+    IdNombre target;
+    ASTNode* value;
+    IdNombre declared_type; // N_VACIO si es una asignación y no una declaración
+
+    Assign(IdNombre target, ASTNode* value, IdNombre declared_type = N_VACIO)
+        : ASTNode(TIPO), target(target), value(value), declared_type(declared_type) {}
+};
+
+class Literal : public ASTNode {
+public:
+    static constexpr TipoNodo TIPO = TipoNodo::Literal;
+
+    IdNombre value;
+    IdNombre type;
+
+    Literal(IdNombre value, IdNombre type) : ASTNode(TIPO), value(value), type(type) {}
+};
+
+// Valor del texto de un literal entero ("42" o "-7"); falso si no es un entero o no cabe en 64 bits
+inline bool leerEntero(string_view texto, int64_t &valor) {
+    const char *fin = texto.data() + texto.size();
+    auto [ultimo, error] = from_chars(texto.data(), fin, valor);
+    return error == errc() && ultimo == fin;
+}
+
+class Return : public ASTNode {
+public:
+    static constexpr TipoNodo TIPO = TipoNodo::Return;
+
+    ASTNode* value;
+
+    Return(ASTNode* value) : ASTNode(TIPO), value(value) {}
+};
+
+class If : public ASTNode {
+public:
+    static constexpr TipoNodo TIPO = TipoNodo::If;
+
+    ASTNode* condition;
+    ListaNodos then_body;
+    ListaNodos else_body;
+
+    If(ASTNode* condition, ListaNodos then_body, ListaNodos else_body)
+        : ASTNode(TIPO), condition(condition), then_body(then_body), else_body(else_body) {}
+};
+
+class While : public ASTNode {
+public:
+    static constexpr TipoNodo TIPO = TipoNodo::While;
+
+    ASTNode* condition;
+    ListaNodos body;
+
+    While(ASTNode* condition, ListaNodos body)
+        : ASTNode(TIPO), condition(condition), body(body) {}
+};
+
+class BinaryOp : public ASTNode {
+public:
+    static constexpr TipoNodo TIPO = TipoNodo::BinaryOp;
+
+    IdNombre op;
+    ASTNode* left;
+    ASTNode* right;
+
+    BinaryOp(IdNombre op, ASTNode* left, ASTNode* right)
+        : ASTNode(TIPO), op(op), left(left), right(right) {}
+};
+
+class UnaryOp : public ASTNode {
+public:
+    static constexpr TipoNodo TIPO = TipoNodo::UnaryOp;
+
+    IdNombre op;
+    ASTNode* operand;
+
+    UnaryOp(IdNombre op, ASTNode* operand)
+        : ASTNode(TIPO), op(op), operand(operand) {}
+};
+
+// Convierte el nodo a T si su etiqueta coincide (o devuelve nullptr), sin consultar RTTI
+template <typename T>
+T *nodoComo(ASTNode *nodo) {
+    return nodo && nodo->tipo == T::TIPO ? static_cast<T *>(nodo) : nullptr;
+}
+
+// Reúne varias lambdas en un solo visitante con operator() sobrecargado
+template <typename... Casos>
+struct Sobrecarga : Casos... {
+    using Casos::operator()...;
+};
+
+template <typename... Casos>
+Sobrecarga(Casos...) -> Sobrecarga<Casos...>;
+
+// Llama al visitante con el nodo ya convertido a su clase concreta: un switch por visita.
+// El visitante debe aceptar también ASTNode*, que recibe los nodos nulos y las clases
+// que no le interesan.
+template <typename Visitante>
+decltype(auto) despachar(ASTNode *nodo, Visitante &&visitante) {
+    if (nodo) {
+        switch (nodo->tipo) {
+            case TipoNodo::FunctionDef: return visitante(static_cast<FunctionDef *>(nodo));
+            case TipoNodo::Assign: return visitante(static_cast<Assign *>(nodo));
+            case TipoNodo::Literal: return visitante(static_cast<Literal *>(nodo));
+            case TipoNodo::Return: return visitante(static_cast<Return *>(nodo));
+            case TipoNodo::If: return visitante(static_cast<If *>(nodo));
+            case TipoNodo::While: return visitante(static_cast<While *>(nodo));
+            case TipoNodo::BinaryOp: return visitante(static_cast<BinaryOp *>(nodo));
+            case TipoNodo::UnaryOp: return visitante(static_cast<UnaryOp *>(nodo));
+        }
+    }
+    return visitante(nodo);
+}
+
+// ---------------------------------------------------------------------------
+// Representación intermedia: TAC compacto en estructura de arreglos
+// ---------------------------------------------------------------------------
+
+// Operaciones del código de tres direcciones
+enum class OpTAC : uint8_t {
+    ASIGNAR,       // destino = a
+    SUMAR,         // destino = a + b
+    RESTAR,        // destino = a - b
+    MULTIPLICAR,   // destino = a * b
+    DIVIDIR,       // destino = a / b
+    MODULO,        // destino = a % b
+    DESPLAZAR,     // destino = a << b
+    MENOR,         // destino = a < b
+    MENOR_IGUAL,   // destino = a <= b
+    MAYOR,         // destino = a > b
+    MAYOR_IGUAL,   // destino = a >= b
+    IGUAL,         // destino = a == b
+    DISTINTO,      // destino = a != b
+    NEGAR,         // destino = -a
+    NO,            // destino = !a
+    ETIQUETA,      // destino:
+    SALTAR,        // goto destino
+    SALTAR_SI,     // if a goto destino
+    SALTAR_SI_NO,  // ifFalse a goto destino
+    RETORNAR,      // return a
+};
+
+// Operando de 32 bits: 2 bits de clase y 30 bits de índice. El índice es el número de
+// temporal, el IdNombre de la variable, la posición en la tabla de constantes o el número
+// de etiqueta, según la clase.
+struct Operando {
+    enum Clase : uint32_t { TEMPORAL, VARIABLE, CONSTANTE, ETIQUETA };
+
+    static constexpr uint32_t NINGUNO = UINT32_MAX;
+    static constexpr uint32_t BITS_INDICE = 30;
+    static constexpr uint32_t MASCARA_INDICE = (1u << BITS_INDICE) - 1;
+
+    uint32_t bits = NINGUNO;
+
+    static Operando crear(Clase clase, uint32_t indice) {
+        return {(static_cast<uint32_t>(clase) << BITS_INDICE) | (indice & MASCARA_INDICE)};
+    }
+    static Operando temporal(uint32_t numero) { return crear(TEMPORAL, numero); }
+    static Operando variable(IdNombre nombre) { return crear(VARIABLE, nombre); }
+    static Operando etiqueta(uint32_t numero) { return crear(ETIQUETA, numero); }
+
+    bool vacio() const { return bits == NINGUNO; }
+    Clase clase() const { return static_cast<Clase>(bits >> BITS_INDICE); }
+    uint32_t indice() const { return bits & MASCARA_INDICE; }
+
+    bool operator==(Operando otro) const { return bits == otro.bits; }
+    bool operator!=(Operando otro) const { return bits != otro.bits; }
+};
+
+static_assert(sizeof(Operando) == 4, "Los operandos deben ocupar 32 bits");
+
+// Entrada de la tabla de constantes: un entero, o una cadena si `cadena` no es N_VACIO
+struct Constante {
+    int64_t entero;
+    IdNombre cadena;
+};
+
+// Programa en TAC. Cada campo de las instrucciones vive en su propio arreglo contiguo,
+// así que una pasada que solo mira los códigos de operación no carga los operandos.
+class CodigoTAC {
+public:
+    vector<OpTAC> ops;
+    vector<Operando> destinos;
+    vector<Operando> args1;
+    vector<Operando> args2;
+    vector<Constante> constantes;
+    uint32_t temporales = 0;
+    uint32_t etiquetas = 0;
+
+    size_t size() const { return ops.size(); }
+
+    void emitir(OpTAC op, Operando destino = {}, Operando a = {}, Operando b = {}) {
+        ops.push_back(op);
+        destinos.push_back(destino);
+        args1.push_back(a);
+        args2.push_back(b);
+    }
+
+    // Descarta las instrucciones y conserva constantes y contadores
+    void vaciarInstrucciones() {
+        ops.clear();
+        destinos.clear();
+        args1.clear();
+        args2.clear();
+    }
+
+    Operando nuevoTemporal() { return Operando::temporal(temporales++); }
+    Operando nuevaEtiqueta() { return Operando::etiqueta(etiquetas++); }
+
+    // Constantes sin duplicados: el mismo valor siempre devuelve el mismo operando
+    Operando constanteEntera(int64_t valor) {
+        auto [it, nueva] = indiceEnteros.try_emplace(valor, static_cast<uint32_t>(constantes.size()));
+        if (nueva) {
+            constantes.push_back({valor, N_VACIO});
+        }
+        return Operando::crear(Operando::CONSTANTE, it->second);
+    }
+
+    Operando constanteCadena(IdNombre texto) {
+        auto [it, nueva] = indiceCadenas.try_emplace(texto, static_cast<uint32_t>(constantes.size()));
+        if (nueva) {
+            constantes.push_back({0, texto});
+        }
+        return Operando::crear(Operando::CONSTANTE, it->second);
+    }
+
+private:
+    unordered_map<int64_t, uint32_t> indiceEnteros;
+    unordered_map<IdNombre, uint32_t> indiceCadenas;
+};
+
+// Texto de un operando: t0 para temporales, L0 para etiquetas, el nombre o el valor
+void imprimirOperando(ostream &salida, const CodigoTAC &codigo, Operando operando) {
+    switch (operando.clase()) {
+        case Operando::TEMPORAL:
+            salida << 't' << operando.indice();
+            break;
+        case Operando::VARIABLE:
+            salida << nombreDe(operando.indice());
+            break;
+        case Operando::CONSTANTE: {
+            const Constante &constante = codigo.constantes[operando.indice()];
+            if (constante.cadena != N_VACIO) {
+                salida << nombreDe(constante.cadena);
+            } else {
+                salida << constante.entero;
+            }
+            break;
+        }
+        case Operando::ETIQUETA:
+            salida << 'L' << operando.indice();
+            break;
+    }
+}
+
+// Símbolo de cada operación binaria o unaria, indexado por OpTAC
+constexpr string_view SIMBOLOS_OP_TAC[] = {"", "+", "-", "*", "/", "%", "<<", "<", "<=", ">", ">=", "==", "!=", "-", "!"};
+
+// Muestra una instrucción en el formato clásico de tres direcciones, con su salto de línea
+void imprimirInstruccion(ostream &salida, const CodigoTAC &codigo, size_t i) {
+    auto operando = [&](Operando o) { imprimirOperando(salida, codigo, o); };
+    OpTAC op = codigo.ops[i];
+    switch (op) {
+        case OpTAC::ETIQUETA:
+            operando(codigo.destinos[i]);
+            salida << ':';
+            break;
+        case OpTAC::SALTAR:
+            salida << "    goto ";
+            operando(codigo.destinos[i]);
+            break;
+        case OpTAC::SALTAR_SI:
+        case OpTAC::SALTAR_SI_NO:
+            salida << (op == OpTAC::SALTAR_SI ? "    if " : "    ifFalse ");
+            operando(codigo.args1[i]);
+            salida << " goto ";
+            operando(codigo.destinos[i]);
+            break;
+        case OpTAC::RETORNAR:
+            salida << "    return ";
+            operando(codigo.args1[i]);
+            break;
+        case OpTAC::ASIGNAR:
+            salida << "    ";
+            operando(codigo.destinos[i]);
+            salida << " = ";
+            operando(codigo.args1[i]);
+            break;
+        case OpTAC::NEGAR:
+        case OpTAC::NO:
+            salida << "    ";
+            operando(codigo.destinos[i]);
+            salida << " = " << SIMBOLOS_OP_TAC[static_cast<size_t>(op)];
+            operando(codigo.args1[i]);
+            break;
+        default:
+            salida << "    ";
+            operando(codigo.destinos[i]);
+            salida << " = ";
+            operando(codigo.args1[i]);
+            salida << ' ' << SIMBOLOS_OP_TAC[static_cast<size_t>(op)] << ' ';
+            operando(codigo.args2[i]);
+            break;
+    }
+    salida << '\n';
+}
+
+// Muestra el programa completo; solo se llama si se va a imprimir
+void imprimirTAC(ostream &salida, const CodigoTAC &codigo) {
+    for (size_t i = 0; i < codigo.size(); i++) {
+        imprimirInstruccion(salida, codigo, i);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Grafo de flujo de control (CFG) sobre el TAC y administrador de pasadas
+// ---------------------------------------------------------------------------
+
+// Función phi de SSA: `destino` toma args[j] cuando se llega desde predecesores[j]
+struct Phi {
+    Operando destino;
+    Operando variable;   // nombre original, antes de numerar las versiones
+    vector<Operando> args;
+};
+
+// Secuencia de instrucciones sin saltos hacia adentro ni hacia afuera salvo al final.
+// Las instrucciones son índices en el CodigoTAC del CFG; las etiquetas no se guardan,
+// porque cada salto apunta directamente al número de bloque.
+struct BloqueBasico {
+    vector<Phi> phis;    // solo mientras el CFG está en SSA
+    vector<uint32_t> instrucciones;
+    // Con salto condicional: {destino del salto, siguiente bloque}; si no, a lo sumo uno
+    vector<uint32_t> sucesores;
+    vector<uint32_t> predecesores;
+    uint32_t idom = NINGUNO;       // dominador inmediato; NINGUNO si es inalcanzable
+    vector<uint32_t> dominados;    // hijos en el árbol de dominadores
+
+    static constexpr uint32_t NINGUNO = UINT32_MAX;
+};
+
+// Verdadero para las instrucciones que terminan un bloque
+inline bool esTerminador(OpTAC op) {
+    return op == OpTAC::SALTAR || op == OpTAC::SALTAR_SI || op == OpTAC::SALTAR_SI_NO || op == OpTAC::RETORNAR;
+}
+
+// Verdadero si la instrucción puede terminar en error de ejecución: una división o módulo
+// cuyo divisor no es una constante distinta de 0 y de -1. No se borra ni se adelanta.
+inline bool puedeFallar(const CodigoTAC &codigo, uint32_t i) {
+    if (codigo.ops[i] != OpTAC::DIVIDIR && codigo.ops[i] != OpTAC::MODULO) {
+        return false;
+    }
+    Operando divisor = codigo.args2[i];
+    if (divisor.clase() != Operando::CONSTANTE) {
+        return true;
+    }
+    const Constante &constante = codigo.constantes[divisor.indice()];
+    return constante.cadena != N_VACIO || constante.entero == 0 || constante.entero == -1;
+}
+
+class CFG {
+public:
+    static constexpr uint32_t NINGUNO = BloqueBasico::NINGUNO;
+
+    CodigoTAC codigo;                 // almacén de instrucciones, constantes y contadores
+    vector<BloqueBasico> bloques;     // bloques[0] es la entrada y nunca recibe saltos
+    vector<uint32_t> postordenInverso; // solo bloques alcanzables
+    bool enSSA = false;
+
+    // Parte el TAC en bloques básicos, resuelve las etiquetas a números de bloque y
+    // calcula aristas y dominadores
+    static CFG construir(CodigoTAC codigo) {
+        CFG cfg;
+        cfg.codigo = move(codigo);
+        CodigoTAC &tac = cfg.codigo;
+
+        vector<uint32_t> bloqueDeEtiqueta(tac.etiquetas, NINGUNO);
+        cfg.bloques.emplace_back();
+        bool cerrado = false;
+        for (uint32_t i = 0; i < tac.size(); i++) {
+            OpTAC op = tac.ops[i];
+            if (op == OpTAC::ETIQUETA) {
+                // Varias etiquetas seguidas comparten bloque; la entrada queda aparte
+                if (cerrado || cfg.bloques.size() == 1 || !cfg.bloques.back().instrucciones.empty()) {
+                    cfg.bloques.emplace_back();
+                    cerrado = false;
+                }
+                bloqueDeEtiqueta[tac.destinos[i].indice()] = static_cast<uint32_t>(cfg.bloques.size() - 1);
+                continue;
+            }
+            if (cerrado) {
+                cfg.bloques.emplace_back();
+                cerrado = false;
+            }
+            cfg.bloques.back().instrucciones.push_back(i);
+            cerrado = esTerminador(op);
+        }
+
+        // Los saltos pasan a apuntar al bloque; desde aquí una etiqueta es un número de bloque
+        for (BloqueBasico &bloque : cfg.bloques) {
+            for (uint32_t i : bloque.instrucciones) {
+                if (tac.ops[i] == OpTAC::SALTAR || tac.ops[i] == OpTAC::SALTAR_SI || tac.ops[i] == OpTAC::SALTAR_SI_NO) {
+                    tac.destinos[i] = Operando::etiqueta(bloqueDeEtiqueta[tac.destinos[i].indice()]);
+                }
+            }
+        }
+        tac.etiquetas = static_cast<uint32_t>(cfg.bloques.size());
+
+        for (uint32_t b = 0; b < cfg.bloques.size(); b++) {
+            BloqueBasico &bloque = cfg.bloques[b];
+            uint32_t siguiente = b + 1 < cfg.bloques.size() ? b + 1 : NINGUNO;
+            if (bloque.instrucciones.empty()) {
+                if (siguiente != NINGUNO) bloque.sucesores.push_back(siguiente);
+                continue;
+            }
+            uint32_t ultima = bloque.instrucciones.back();
+            switch (tac.ops[ultima]) {
+                case OpTAC::RETORNAR:
+                    break;
+                case OpTAC::SALTAR:
+                    bloque.sucesores.push_back(tac.destinos[ultima].indice());
+                    break;
+                case OpTAC::SALTAR_SI:
+                case OpTAC::SALTAR_SI_NO:
+                    bloque.sucesores.push_back(tac.destinos[ultima].indice());
+                    // Sin bloque siguiente, la rama que sigue de largo sale de la función
+                    if (siguiente != NINGUNO && siguiente != bloque.sucesores[0]) {
+                        bloque.sucesores.push_back(siguiente);
+                    }
+                    break;
+                default:
+                    if (siguiente != NINGUNO) bloque.sucesores.push_back(siguiente);
+                    break;
+            }
+        }
+        cfg.recalcular();
+        return cfg;
+    }
+
+    // Rehace predecesores, el orden y el árbol de dominadores a partir de los sucesores.
+    // Las pasadas que cambian aristas lo llaman (el administrador lo hace por ellas).
+    void recalcular() {
+        for (BloqueBasico &bloque : bloques) {
+            bloque.predecesores.clear();
+        }
+        for (uint32_t b = 0; b < bloques.size(); b++) {
+            for (uint32_t s : bloques[b].sucesores) {
+                bloques[s].predecesores.push_back(b);
+            }
+        }
+        calcularPostordenInverso();
+        calcularDominadores();
+    }
+
+    bool alcanzable(uint32_t b) const { return b == 0 || bloques[b].idom != NINGUNO; }
+
+    // Temporales y variables comparten un espacio de ranuras densas para que las
+    // pasadas indexen vectores en lugar de tablas hash. Se intercalan para que la
+    // ranura de un nombre no cambie cuando una pasada crea temporales o versiones.
+    static bool esNombre(Operando o) {
+        return !o.vacio() && (o.clase() == Operando::TEMPORAL || o.clase() == Operando::VARIABLE);
+    }
+    size_t numeroRanuras() const { return 2 * max<size_t>(codigo.temporales, nombres().size()); }
+    static uint32_t ranura(Operando o) {
+        return 2 * o.indice() + (o.clase() == Operando::VARIABLE);
+    }
+
+    // Instrucciones y phi de los bloques alcanzables; las etiquetas no cuentan
+    size_t instruccionesAlcanzables() const {
+        size_t total = 0;
+        for (uint32_t b : postordenInverso) {
+            total += bloques[b].instrucciones.size() + bloques[b].phis.size();
+        }
+        return total;
+    }
+    size_t bloquesAlcanzables() const { return postordenInverso.size(); }
+
+    // Quita la arista desde -> hacia junto con los argumentos de phi que llegaban por ella
+    void quitarArista(uint32_t desde, uint32_t hacia) {
+        vector<uint32_t> &sucesores = bloques[desde].sucesores;
+        sucesores.erase(find(sucesores.begin(), sucesores.end(), hacia));
+        vector<uint32_t> &predecesores = bloques[hacia].predecesores;
+        auto posicion = find(predecesores.begin(), predecesores.end(), desde);
+        if (posicion == predecesores.end()) {
+            return;
+        }
+        size_t j = posicion - predecesores.begin();
+        for (Phi &phi : bloques[hacia].phis) {
+            phi.args.erase(phi.args.begin() + j);
+        }
+        predecesores.erase(posicion);
+    }
+
+    // Inserta un bloque vacío en la arista desde -> hacia y devuelve su número. El nuevo
+    // bloque ocupa el lugar de `desde` entre los predecesores de `hacia`.
+    uint32_t dividirArista(uint32_t desde, uint32_t hacia) {
+        uint32_t nuevo = static_cast<uint32_t>(bloques.size());
+        bloques.emplace_back();
+        bloques[nuevo].sucesores.push_back(hacia);
+        bloques[nuevo].predecesores.push_back(desde);
+        codigo.etiquetas = static_cast<uint32_t>(bloques.size());
+
+        BloqueBasico &origen = bloques[desde];
+        replace(origen.sucesores.begin(), origen.sucesores.end(), hacia, nuevo);
+        if (!origen.instrucciones.empty()) {
+            uint32_t ultima = origen.instrucciones.back();
+            if (esTerminador(codigo.ops[ultima]) && codigo.destinos[ultima] == Operando::etiqueta(hacia)) {
+                codigo.destinos[ultima] = Operando::etiqueta(nuevo);
+            }
+        }
+        vector<uint32_t> &predecesores = bloques[hacia].predecesores;
+        replace(predecesores.begin(), predecesores.end(), desde, nuevo);
+        return nuevo;
+    }
+
+    // Cambia el sucesor `viejo` de `desde` por `nuevo`, incluido el destino del salto
+    void redirigirArista(uint32_t desde, uint32_t viejo, uint32_t nuevo) {
+        BloqueBasico &origen = bloques[desde];
+        replace(origen.sucesores.begin(), origen.sucesores.end(), viejo, nuevo);
+        if (!origen.instrucciones.empty()) {
+            uint32_t ultima = origen.instrucciones.back();
+            if (esTerminador(codigo.ops[ultima]) && codigo.destinos[ultima] == Operando::etiqueta(viejo)) {
+                codigo.destinos[ultima] = Operando::etiqueta(nuevo);
+            }
+        }
+    }
+
+    // Inserta un bloque vacío en la posición b, que pasa al bloque original a b + 1.
+    // Renumera sucesores y saltos; los predecesores quedan para recalcular().
+    uint32_t insertarBloqueAntes(uint32_t b) {
+        auto renumerar = [b](uint32_t &bloque) {
+            if (bloque >= b) bloque++;
+        };
+        for (BloqueBasico &bloque : bloques) {
+            for (uint32_t &s : bloque.sucesores) renumerar(s);
+            if (!bloque.instrucciones.empty() && esTerminador(codigo.ops[bloque.instrucciones.back()])) {
+                Operando &salto = codigo.destinos[bloque.instrucciones.back()];
+                if (!salto.vacio()) {
+                    uint32_t destino = salto.indice();
+                    renumerar(destino);
+                    salto = Operando::etiqueta(destino);
+                }
+            }
+        }
+        bloques.insert(bloques.begin() + b, BloqueBasico{});
+        bloques[b].sucesores.push_back(b + 1);
+        codigo.etiquetas = static_cast<uint32_t>(bloques.size());
+        return b;
+    }
+
+    // Pone una instrucción existente al final del bloque, antes del salto o return que lo cierra
+    void moverAlFinal(uint32_t b, uint32_t instruccion) {
+        vector<uint32_t> &instrucciones = bloques[b].instrucciones;
+        if (!instrucciones.empty() && esTerminador(codigo.ops[instrucciones.back()])) {
+            instrucciones.insert(instrucciones.end() - 1, instruccion);
+        } else {
+            instrucciones.push_back(instruccion);
+        }
+    }
+
+    void agregarAlFinal(uint32_t b, OpTAC op, Operando destino, Operando a = {}, Operando c = {}) {
+        codigo.emitir(op, destino, a, c);
+        moverAlFinal(b, static_cast<uint32_t>(codigo.size() - 1));
+    }
+
+    // Frontera de dominancia de cada bloque (Cooper, Harvey y Kennedy): los bloques
+    // donde deja de valer la dominancia de b, que es donde se juntan definiciones
+    vector<vector<uint32_t>> fronterasDominancia() const {
+        vector<vector<uint32_t>> frontera(bloques.size());
+        for (uint32_t b = 0; b < bloques.size(); b++) {
+            if (bloques[b].predecesores.size() < 2 || !alcanzable(b)) {
+                continue;
+            }
+            for (uint32_t p : bloques[b].predecesores) {
+                for (uint32_t corredor = p; alcanzable(p) && corredor != bloques[b].idom; corredor = bloques[corredor].idom) {
+                    if (frontera[corredor].empty() || frontera[corredor].back() != b) {
+                        frontera[corredor].push_back(b);
+                    }
+                }
+            }
+        }
+        return frontera;
+    }
+
+    // a domina a b: todo camino desde la entrada hasta b pasa por a. O(1) con la
+    // numeración del árbol de dominadores.
+    bool domina(uint32_t a, uint32_t b) const {
+        return alcanzable(a) && alcanzable(b) && entradaArbol[a] <= entradaArbol[b] && salidaArbol[b] <= salidaArbol[a];
+    }
+
+    // Vuelve a un CodigoTAC plano: etiquetas solo en los bloques que reciben saltos y
+    // sin "goto" al bloque que sigue. Los bloques inalcanzables se omiten.
+    CodigoTAC linearizar() const {
+        CodigoTAC salida = codigo;
+        salida.vaciarInstrucciones();
+        salida.etiquetas = static_cast<uint32_t>(bloques.size());
+
+        vector<uint32_t> orden;
+        for (uint32_t b = 0; b < bloques.size(); b++) {
+            if (alcanzable(b)) orden.push_back(b);
+        }
+        vector<bool> necesitaEtiqueta(bloques.size(), false);
+        for (size_t k = 0; k < orden.size(); k++) {
+            const BloqueBasico &bloque = bloques[orden[k]];
+            uint32_t siguiente = k + 1 < orden.size() ? orden[k + 1] : NINGUNO;
+            for (uint32_t s : bloque.sucesores) {
+                if (s != siguiente) necesitaEtiqueta[s] = true;
+            }
+            // El salto condicional nombra su destino aunque coincida con el siguiente
+            if (!bloque.instrucciones.empty()) {
+                OpTAC ultima = codigo.ops[bloque.instrucciones.back()];
+                if (ultima == OpTAC::SALTAR_SI || ultima == OpTAC::SALTAR_SI_NO) {
+                    necesitaEtiqueta[bloque.sucesores[0]] = true;
+                }
+            }
+        }
+
+        for (size_t k = 0; k < orden.size(); k++) {
+            uint32_t b = orden[k];
+            const BloqueBasico &bloque = bloques[b];
+            uint32_t siguiente = k + 1 < orden.size() ? orden[k + 1] : NINGUNO;
+            if (necesitaEtiqueta[b]) {
+                salida.emitir(OpTAC::ETIQUETA, Operando::etiqueta(b));
+            }
+            bool terminado = false;
+            for (uint32_t i : bloque.instrucciones) {
+                OpTAC op = codigo.ops[i];
+                if (op == OpTAC::SALTAR) {
+                    terminado = true;
+                    if (bloque.sucesores[0] != siguiente) {
+                        salida.emitir(OpTAC::SALTAR, Operando::etiqueta(bloque.sucesores[0]));
+                    }
+                    continue;
+                }
+                if (op == OpTAC::SALTAR_SI || op == OpTAC::SALTAR_SI_NO) {
+                    terminado = true;
+                    salida.emitir(op, Operando::etiqueta(bloque.sucesores[0]), codigo.args1[i]);
+                    if (bloque.sucesores.size() == 2 && bloque.sucesores[1] != siguiente) {
+                        salida.emitir(OpTAC::SALTAR, Operando::etiqueta(bloque.sucesores[1]));
+                    }
+                    continue;
+                }
+                salida.emitir(op, codigo.destinos[i], codigo.args1[i], codigo.args2[i]);
+                terminado = op == OpTAC::RETORNAR;
+            }
+            if (!terminado && !bloque.sucesores.empty() && bloque.sucesores[0] != siguiente) {
+                salida.emitir(OpTAC::SALTAR, Operando::etiqueta(bloque.sucesores[0]));
+            }
+        }
+        return salida;
+    }
+
+    void imprimir(ostream &salida) const {
+        auto lista = [&](const vector<uint32_t> &bloquesLista) {
+            if (bloquesLista.empty()) salida << " -";
+            for (uint32_t b : bloquesLista) salida << " L" << b;
+        };
+        for (uint32_t b = 0; b < bloques.size(); b++) {
+            const BloqueBasico &bloque = bloques[b];
+            salida << 'L' << b << ":  ; pred";
+            lista(bloque.predecesores);
+            salida << " | suc";
+            lista(bloque.sucesores);
+            salida << " | idom ";
+            if (b == 0) {
+                salida << "-";
+            } else if (bloque.idom == NINGUNO) {
+                salida << "inalcanzable";
+            } else {
+                salida << 'L' << bloque.idom;
+            }
+            salida << '\n';
+            for (const Phi &phi : bloque.phis) {
+                salida << "    ";
+                imprimirOperando(salida, codigo, phi.destino);
+                salida << " = phi(";
+                for (size_t j = 0; j < phi.args.size(); j++) {
+                    if (j > 0) salida << ", ";
+                    imprimirOperando(salida, codigo, phi.args[j]);
+                }
+                salida << ")\n";
+            }
+            for (uint32_t i : bloque.instrucciones) {
+                imprimirInstruccion(salida, codigo, i);
+            }
+        }
+    }
+
+private:
+    vector<uint32_t> entradaArbol;   // numeración del árbol de dominadores para domina()
+    vector<uint32_t> salidaArbol;
+
+    void calcularPostordenInverso() {
+        postordenInverso.clear();
+        vector<uint8_t> visto(bloques.size(), 0);
+        // DFS iterativo: (bloque, siguiente sucesor por visitar)
+        vector<pair<uint32_t, uint32_t>> pila{{0, 0}};
+        visto[0] = 1;
+        while (!pila.empty()) {
+            auto &[b, k] = pila.back();
+            if (k < bloques[b].sucesores.size()) {
+                uint32_t s = bloques[b].sucesores[k++];
+                if (!visto[s]) {
+                    visto[s] = 1;
+                    pila.push_back({s, 0});
+                }
+            } else {
+                postordenInverso.push_back(b);
+                pila.pop_back();
+            }
+        }
+        reverse(postordenInverso.begin(), postordenInverso.end());
+    }
+
+    // Algoritmo iterativo de Cooper, Harvey y Kennedy sobre el postorden inverso
+    void calcularDominadores() {
+        vector<uint32_t> posicion(bloques.size(), NINGUNO);
+        for (uint32_t k = 0; k < postordenInverso.size(); k++) {
+            posicion[postordenInverso[k]] = k;
+        }
+        for (BloqueBasico &bloque : bloques) {
+            bloque.idom = NINGUNO;
+            bloque.dominados.clear();
+        }
+        bloques[0].idom = 0;
+
+        auto interseccion = [&](uint32_t a, uint32_t b) {
+            while (a != b) {
+                while (posicion[a] > posicion[b]) a = bloques[a].idom;
+                while (posicion[b] > posicion[a]) b = bloques[b].idom;
+            }
+            return a;
+        };
+
+        bool cambio = true;
+        while (cambio) {
+            cambio = false;
+            for (size_t k = 1; k < postordenInverso.size(); k++) {
+                uint32_t b = postordenInverso[k];
+                uint32_t nuevo = NINGUNO;
+                for (uint32_t p : bloques[b].predecesores) {
+                    if (bloques[p].idom == NINGUNO) continue;
+                    nuevo = nuevo == NINGUNO ? p : interseccion(p, nuevo);
+                }
+                if (bloques[b].idom != nuevo) {
+                    bloques[b].idom = nuevo;
+                    cambio = true;
+                }
+            }
+        }
+
+        for (uint32_t b = 1; b < bloques.size(); b++) {
+            if (bloques[b].idom != NINGUNO) {
+                bloques[bloques[b].idom].dominados.push_back(b);
+            }
+        }
+        bloques[0].idom = NINGUNO; // la entrada no tiene dominador inmediato
+
+        // Numerar el árbol en preorden/postorden para responder domina() en O(1)
+        entradaArbol.assign(bloques.size(), 0);
+        salidaArbol.assign(bloques.size(), 0);
+        uint32_t reloj = 0;
+        vector<pair<uint32_t, uint32_t>> pila{{0, 0}};
+        entradaArbol[0] = reloj++;
+        while (!pila.empty()) {
+            auto &[b, k] = pila.back();
+            if (k < bloques[b].dominados.size()) {
+                uint32_t hijo = bloques[b].dominados[k++];
+                entradaArbol[hijo] = reloj++;
+                pila.push_back({hijo, 0});
+            } else {
+                salidaArbol[b] = reloj++;
+                pila.pop_back();
+            }
+        }
+    }
+};
+
+// Una pasada de optimización sobre el CFG. Devuelve true si cambió el programa.
+class Pasada {
+public:
+    virtual ~Pasada() = default;
+    virtual const char *nombre() const = 0;
+    virtual bool ejecutar(CFG &cfg) = 0;
+};
+
+// Ejecuta las pasadas registradas en orden. Cuando una pasada cambia el programa,
+// recalcula predecesores y dominadores antes de la siguiente.
+class AdministradorPasadas {
+public:
+    void agregar(unique_ptr<Pasada> pasada) {
+        pasadas.push_back(move(pasada));
+    }
+
+    template <typename P, typename... Args>
+    void agregar(Args &&...args) {
+        pasadas.push_back(make_unique<P>(forward<Args>(args)...));
+    }
+
+    // Efecto de una ejecución de una pasada, para el resumen
+    struct Estadistica {
+        const char *nombre;
+        size_t instruccionesAntes, instruccionesDespues;
+        size_t bloquesAntes, bloquesDespues;
+        double milisegundos;
+    };
+
+    bool ejecutar(CFG &cfg) {
+        bool cambio = false;
+        for (auto &pasada : pasadas) {
+            Estadistica estadistica{pasada->nombre(), cfg.instruccionesAlcanzables(), 0, cfg.bloquesAlcanzables(), 0, 0};
+            auto inicio = chrono::steady_clock::now();
+            if (pasada->ejecutar(cfg)) {
+                cfg.recalcular();
+                cambio = true;
+            }
+            estadistica.milisegundos = chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+            estadistica.instruccionesDespues = cfg.instruccionesAlcanzables();
+            estadistica.bloquesDespues = cfg.bloquesAlcanzables();
+            estadisticas.push_back(estadistica);
+        }
+        return cambio;
+    }
+
+    size_t size() const { return pasadas.size(); }
+    const vector<Estadistica> &resumen() const { return estadisticas; }
+
+    void imprimirEstadisticas(ostream &salida) const {
+        salida << left << setw(26) << "Pasada" << right << setw(14) << "Instrucciones" << setw(10) << "Bloques" << setw(10) << "ms" << '\n';
+        for (const Estadistica &e : estadisticas) {
+            string instrucciones = to_string(e.instruccionesAntes) + " -> " + to_string(e.instruccionesDespues);
+            string bloques = to_string(e.bloquesAntes) + " -> " + to_string(e.bloquesDespues);
+            salida << left << setw(26) << e.nombre << right << setw(14) << instrucciones << setw(10) << bloques
+                   << setw(10) << fixed << setprecision(3) << e.milisegundos << '\n';
+        }
+        salida << defaultfloat;
+    }
+
+private:
+    vector<unique_ptr<Pasada>> pasadas;
+    vector<Estadistica> estadisticas;
+};
+
+// Nombres vivos a la entrada y a la salida de cada bloque alcanzable (fuera de SSA).
+// Un nombre está vivo si algún camino desde ese punto lo lee antes de redefinirlo.
+class Vivacidad {
+public:
+    // Conjunto de ranuras como mapa de bits
+    using Conjunto = vector<uint64_t>;
+
+    vector<Conjunto> entrada;
+    vector<Conjunto> salida;
+
+    static void agregar(Conjunto &conjunto, uint32_t r) { conjunto[r >> 6] |= uint64_t{1} << (r & 63); }
+    static void quitar(Conjunto &conjunto, uint32_t r) { conjunto[r >> 6] &= ~(uint64_t{1} << (r & 63)); }
+    static bool contiene(const Conjunto &conjunto, uint32_t r) { return (conjunto[r >> 6] >> (r & 63)) & 1; }
+
+    explicit Vivacidad(const CFG &cfg) {
+        const CodigoTAC &codigo = cfg.codigo;
+        size_t palabras = (cfg.numeroRanuras() + 63) / 64;
+        size_t n = cfg.bloques.size();
+        vector<Conjunto> usa(n, Conjunto(palabras, 0)), define(n, Conjunto(palabras, 0));
+        entrada.assign(n, Conjunto(palabras, 0));
+        salida.assign(n, Conjunto(palabras, 0));
+
+        for (uint32_t b : cfg.postordenInverso) {
+            for (uint32_t i : cfg.bloques[b].instrucciones) {
+                for (Operando o : {codigo.args1[i], codigo.args2[i]}) {
+                    if (CFG::esNombre(o) && !contiene(define[b], cfg.ranura(o))) {
+                        agregar(usa[b], cfg.ranura(o));
+                    }
+                }
+                if (CFG::esNombre(codigo.destinos[i])) {
+                    agregar(define[b], cfg.ranura(codigo.destinos[i]));
+                }
+            }
+        }
+
+        // Análisis hacia atrás: se recorre en postorden para que los sucesores vayan primero
+        bool cambio = true;
+        while (cambio) {
+            cambio = false;
+            for (auto it = cfg.postordenInverso.rbegin(); it != cfg.postordenInverso.rend(); ++it) {
+                uint32_t b = *it;
+                for (uint32_t s : cfg.bloques[b].sucesores) {
+                    for (size_t w = 0; w < palabras; w++) salida[b][w] |= entrada[s][w];
+                }
+                for (size_t w = 0; w < palabras; w++) {
+                    uint64_t nueva = usa[b][w] | (salida[b][w] & ~define[b][w]);
+                    if (nueva != entrada[b][w]) {
+                        entrada[b][w] = nueva;
+                        cambio = true;
+                    }
+                }
+            }
+        }
+    }
+
+    bool vivoAlEntrar(const CFG &cfg, uint32_t b, Operando o) const {
+        return CFG::esNombre(o) && contiene(entrada[b], cfg.ranura(o));
+    }
+};
+
+// ---------------------------------------------------------------------------
+// SSA y propagación de constantes condicional dispersa (SCCP)
+// ---------------------------------------------------------------------------
+
+// Pasa el CFG a SSA. Las phi se colocan en la frontera de dominancia iterada de las
+// definiciones, solo para los nombres que se leen en un bloque distinto del que los
+// define (SSA semipodado): así los temporales de una expresión no generan phi.
+// La primera definición conserva el nombre original y las siguientes son x.1, x.2...
+// (en una segunda vuelta se siguen numerando a partir del nombre base, sin repetir).
+// Si el nombre se puede leer antes de definirse, el original queda para ese valor
+// inicial (sin definición en SSA) y todas las definiciones reciben un nombre nuevo.
+class ConstruirSSA : public Pasada {
+public:
+    const char *nombre() const override { return "ssa"; }
+
+    bool ejecutar(CFG &cfg) override {
+        if (cfg.enSSA) {
+            return false;
+        }
+        size_t ranuras = cfg.numeroRanuras();
+        Vivacidad::Conjunto alEntrar = Vivacidad(cfg).entrada[0];
+        colocarPhis(cfg, ranuras);
+        renombrar(cfg, ranuras, alEntrar);
+        cfg.enSSA = true;
+        return true;
+    }
+
+private:
+    void colocarPhis(CFG &cfg, size_t ranuras) {
+        const CodigoTAC &codigo = cfg.codigo;
+        vector<vector<uint32_t>> definiciones(ranuras);
+        vector<Operando> operandoDe(ranuras);
+        vector<uint8_t> global(ranuras, 0);
+        vector<uint32_t> definidoEn(ranuras, CFG::NINGUNO);
+
+        for (uint32_t b = 0; b < cfg.bloques.size(); b++) {
+            if (!cfg.alcanzable(b)) {
+                continue;
+            }
+            auto leer = [&](Operando o) {
+                if (CFG::esNombre(o) && definidoEn[cfg.ranura(o)] != b) {
+                    global[cfg.ranura(o)] = 1;
+                }
+            };
+            for (uint32_t i : cfg.bloques[b].instrucciones) {
+                leer(codigo.args1[i]);
+                leer(codigo.args2[i]);
+                Operando destino = codigo.destinos[i];
+                if (CFG::esNombre(destino)) {
+                    uint32_t r = cfg.ranura(destino);
+                    operandoDe[r] = destino;
+                    if (definidoEn[r] != b) {
+                        definidoEn[r] = b;
+                        definiciones[r].push_back(b);
+                    }
+                }
+            }
+        }
+
+        vector<vector<uint32_t>> frontera = cfg.fronterasDominancia();
+        vector<uint32_t> tienePhi(cfg.bloques.size(), CFG::NINGUNO);
+        vector<uint32_t> pendiente;
+        for (uint32_t r = 0; r < ranuras; r++) {
+            if (!global[r] || definiciones[r].empty()) {
+                continue;
+            }
+            pendiente = definiciones[r];
+            while (!pendiente.empty()) {
+                uint32_t b = pendiente.back();
+                pendiente.pop_back();
+                for (uint32_t f : frontera[b]) {
+                    if (tienePhi[f] == r) {
+                        continue;
+                    }
+                    tienePhi[f] = r;
+                    BloqueBasico &bloque = cfg.bloques[f];
+                    bloque.phis.push_back({operandoDe[r], operandoDe[r], vector<Operando>(bloque.predecesores.size(), operandoDe[r])});
+                    pendiente.push_back(f);
+                }
+            }
+        }
+    }
+
+    void renombrar(CFG &cfg, size_t ranuras, const Vivacidad::Conjunto &alEntrar) {
+        CodigoTAC &codigo = cfg.codigo;
+        vector<vector<Operando>> pilas(ranuras);
+        vector<uint32_t> versiones(ranuras, 0);
+        for (uint32_t r = 0; r < ranuras; r++) {
+            if (Vivacidad::contiene(alEntrar, r)) versiones[r] = 1;
+        }
+
+        unordered_map<string_view, uint32_t> siguienteSufijo;
+        auto nuevaVariable = [&](IdNombre original) {
+            string_view base = nombreDe(original);
+            base = base.substr(0, base.find('.'));
+            uint32_t &sufijo = siguienteSufijo[base];
+            string nombre;
+            do {
+                nombre = string(base) + "." + to_string(++sufijo);
+            } while (nombres().buscar(nombre) != Internador::NINGUNO);
+            return Operando::variable(internar(nombre));
+        };
+        auto nuevaVersion = [&](Operando original) {
+            uint32_t r = cfg.ranura(original);
+            Operando version = original;
+            if (versiones[r]++ > 0) {
+                version = original.clase() == Operando::TEMPORAL ? codigo.nuevoTemporal() : nuevaVariable(original.indice());
+            }
+            pilas[r].push_back(version);
+            return version;
+        };
+        auto actual = [&](Operando o) {
+            if (!CFG::esNombre(o)) {
+                return o;
+            }
+            const vector<Operando> &pila = pilas[cfg.ranura(o)];
+            return pila.empty() ? o : pila.back();
+        };
+
+        // Recorrido del árbol de dominadores; al salir de un bloque se desapilan sus definiciones
+        struct Marco {
+            uint32_t bloque;
+            uint32_t hijo;
+            vector<uint32_t> definidas;
+        };
+        vector<Marco> pila;
+        pila.push_back({0, 0, {}});
+        bool entrando = true;
+        while (!pila.empty()) {
+            Marco &marco = pila.back();
+            uint32_t b = marco.bloque;
+            BloqueBasico &bloque = cfg.bloques[b];
+            if (entrando) {
+                for (Phi &phi : bloque.phis) {
+                    marco.definidas.push_back(cfg.ranura(phi.variable));
+                    phi.destino = nuevaVersion(phi.variable);
+                }
+                for (uint32_t i : bloque.instrucciones) {
+                    codigo.args1[i] = actual(codigo.args1[i]);
+                    codigo.args2[i] = actual(codigo.args2[i]);
+                    if (CFG::esNombre(codigo.destinos[i])) {
+                        marco.definidas.push_back(cfg.ranura(codigo.destinos[i]));
+                        codigo.destinos[i] = nuevaVersion(codigo.destinos[i]);
+                    }
+                }
+                for (uint32_t s : bloque.sucesores) {
+                    BloqueBasico &sucesor = cfg.bloques[s];
+                    size_t j = find(sucesor.predecesores.begin(), sucesor.predecesores.end(), b) - sucesor.predecesores.begin();
+                    for (Phi &phi : sucesor.phis) {
+                        phi.args[j] = actual(phi.variable);
+                    }
+                }
+            }
+            if (marco.hijo < bloque.dominados.size()) {
+                uint32_t hijo = bloque.dominados[marco.hijo++];
+                pila.push_back({hijo, 0, {}});
+                entrando = true;
+            } else {
+                for (uint32_t r : marco.definidas) {
+                    pilas[r].pop_back();
+                }
+                pila.pop_back();
+                entrando = false;
+            }
+        }
+    }
+};
+
+// Saca el CFG de SSA: cada phi se reemplaza por copias al final de los predecesores.
+// Las aristas críticas (de un bloque con dos salidas a uno con varias entradas) se
+// dividen para que la copia solo se ejecute en el camino que corresponde. Cuando el
+// argumento se calcula en el mismo predecesor y la phi es su único uso, la instrucción
+// escribe directamente en el destino de la phi y la copia desaparece.
+class DestruirSSA : public Pasada {
+public:
+    const char *nombre() const override { return "salir-ssa"; }
+
+    bool ejecutar(CFG &cfg) override {
+        if (!cfg.enSSA) {
+            return false;
+        }
+        contarUsos(cfg);
+        for (uint32_t b = 0; b < cfg.bloques.size(); b++) {
+            if (cfg.bloques[b].phis.empty()) {
+                continue;
+            }
+            vector<Phi> phis = move(cfg.bloques[b].phis);
+            cfg.bloques[b].phis.clear();
+            vector<uint32_t> predecesores = cfg.bloques[b].predecesores;
+            for (size_t j = 0; j < predecesores.size(); j++) {
+                uint32_t p = predecesores[j];
+                if (!cfg.alcanzable(p)) {
+                    continue;
+                }
+                uint32_t destino = cfg.bloques[p].sucesores.size() > 1 ? cfg.dividirArista(p, b) : p;
+                copiarEnParalelo(cfg, destino, phis, j);
+            }
+        }
+        cfg.enSSA = false;
+        return true;
+    }
+
+private:
+    vector<uint32_t> usos;
+
+    void contarUsos(const CFG &cfg) {
+        usos.assign(cfg.numeroRanuras(), 0);
+        auto leer = [&](Operando o) {
+            if (CFG::esNombre(o)) usos[cfg.ranura(o)]++;
+        };
+        for (const BloqueBasico &bloque : cfg.bloques) {
+            for (const Phi &phi : bloque.phis) {
+                for (Operando arg : phi.args) leer(arg);
+            }
+            for (uint32_t i : bloque.instrucciones) {
+                leer(cfg.codigo.args1[i]);
+                leer(cfg.codigo.args2[i]);
+            }
+        }
+    }
+
+    // Hace que la definición de `arg` en el bloque b escriba en `destino`, si nada
+    // lee ni escribe `destino` entre esa definición y el final del bloque
+    bool fusionar(CFG &cfg, uint32_t b, Operando arg, Operando destino) const {
+        if (!CFG::esNombre(arg) || usos[cfg.ranura(arg)] != 1) {
+            return false;
+        }
+        CodigoTAC &codigo = cfg.codigo;
+        const vector<uint32_t> &instrucciones = cfg.bloques[b].instrucciones;
+        for (size_t k = instrucciones.size(); k-- > 0;) {
+            uint32_t i = instrucciones[k];
+            if (codigo.destinos[i] == arg) {
+                codigo.destinos[i] = destino;
+                return true;
+            }
+            if (codigo.args1[i] == destino || codigo.args2[i] == destino || codigo.destinos[i] == destino) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    // Las copias de un mismo borde son simultáneas: si algún destino también se lee
+    // en el grupo, primero se pasan todos los valores por temporales
+    void copiarEnParalelo(CFG &cfg, uint32_t b, const vector<Phi> &phis, size_t j) const {
+        bool conflicto = false;
+        for (const Phi &escrita : phis) {
+            for (const Phi &leida : phis) {
+                if (&escrita != &leida && leida.args[j] == escrita.destino) {
+                    conflicto = true;
+                }
+            }
+        }
+        if (!conflicto) {
+            for (const Phi &phi : phis) {
+                if (phi.args[j] != phi.destino && !fusionar(cfg, b, phi.args[j], phi.destino)) {
+                    cfg.agregarAlFinal(b, OpTAC::ASIGNAR, phi.destino, phi.args[j]);
+                }
+            }
+            return;
+        }
+        vector<Operando> intermedios;
+        for (const Phi &phi : phis) {
+            intermedios.push_back(cfg.codigo.nuevoTemporal());
+            cfg.agregarAlFinal(b, OpTAC::ASIGNAR, intermedios.back(), phi.args[j]);
+        }
+        for (size_t k = 0; k < phis.size(); k++) {
+            cfg.agregarAlFinal(b, OpTAC::ASIGNAR, phis[k].destino, intermedios[k]);
+        }
+    }
+};
+
+// Propagación de constantes condicional dispersa (Wegman y Zadeck). Avanza a la vez
+// sobre las aristas ejecutables del CFG y sobre las aristas definición-uso de SSA, así
+// que una rama cuya condición resulta constante nunca contamina las phi con sus valores.
+// Al terminar reemplaza los usos por constantes, borra las definiciones que quedaron
+// sin uso y convierte los saltos condicionales resueltos en saltos simples.
+class PropagacionConstantes : public Pasada {
+public:
+    const char *nombre() const override { return "sccp"; }
+
+    bool ejecutar(CFG &cfg) override {
+        if (!cfg.enSSA) {
+            return false;
+        }
+        inicializar(cfg);
+        propagar(cfg);
+        return reescribir(cfg);
+    }
+
+private:
+    // Retículo: INDEFINIDO (aún sin valor) > CONSTANTE > VARIABLE
+    struct Celda {
+        enum Estado : uint8_t { INDEFINIDO, CONSTANTE, VARIABLE } estado = INDEFINIDO;
+        int64_t valor = 0;
+
+        bool operator==(const Celda &otra) const {
+            return estado == otra.estado && (estado != CONSTANTE || valor == otra.valor);
+        }
+    };
+
+    // Lugar donde se lee un nombre: una instrucción o una phi de un bloque
+    struct Uso {
+        uint32_t bloque;
+        uint32_t posicion;
+        bool phi;
+    };
+
+    static constexpr Celda VARIABLE{Celda::VARIABLE, 0};
+
+    vector<Celda> celdas;
+    vector<uint8_t> definido;
+    vector<vector<Uso>> usos;
+    vector<vector<uint8_t>> aristaEjecutable;  // alineado con los sucesores de cada bloque
+    vector<uint8_t> visitado;
+    vector<pair<uint32_t, uint32_t>> pendientesFlujo;
+    vector<uint32_t> pendientesSSA;
+
+    void inicializar(CFG &cfg) {
+        const CodigoTAC &codigo = cfg.codigo;
+        size_t ranuras = cfg.numeroRanuras();
+        celdas.assign(ranuras, Celda{});
+        definido.assign(ranuras, 0);
+        usos.assign(ranuras, {});
+        aristaEjecutable.assign(cfg.bloques.size(), {});
+        visitado.assign(cfg.bloques.size(), 0);
+        pendientesFlujo.clear();
+        pendientesSSA.clear();
+
+        auto leer = [&](Operando o, Uso uso) {
+            if (CFG::esNombre(o)) {
+                usos[cfg.ranura(o)].push_back(uso);
+            }
+        };
+        for (uint32_t b = 0; b < cfg.bloques.size(); b++) {
+            const BloqueBasico &bloque = cfg.bloques[b];
+            aristaEjecutable[b].assign(bloque.sucesores.size(), 0);
+            for (uint32_t k = 0; k < bloque.phis.size(); k++) {
+                definido[cfg.ranura(bloque.phis[k].destino)] = 1;
+                for (Operando arg : bloque.phis[k].args) {
+                    leer(arg, {b, k, true});
+                }
+            }
+            for (uint32_t i : bloque.instrucciones) {
+                leer(codigo.args1[i], {b, i, false});
+                leer(codigo.args2[i], {b, i, false});
+                if (CFG::esNombre(codigo.destinos[i])) {
+                    definido[cfg.ranura(codigo.destinos[i])] = 1;
+                }
+            }
+        }
+    }
+
+    // Valor actual de un operando; los nombres sin definición (parámetros) son variables
+    Celda valor(const CFG &cfg, Operando o) const {
+        if (o.vacio()) {
+            return VARIABLE;
+        }
+        if (o.clase() == Operando::CONSTANTE) {
+            const Constante &constante = cfg.codigo.constantes[o.indice()];
+            return constante.cadena == N_VACIO ? Celda{Celda::CONSTANTE, constante.entero} : VARIABLE;
+        }
+        if (!CFG::esNombre(o) || !definido[cfg.ranura(o)]) {
+            return VARIABLE;
+        }
+        return celdas[cfg.ranura(o)];
+    }
+
+    void bajar(const CFG &cfg, Operando destino, Celda nueva) {
+        uint32_t r = cfg.ranura(destino);
+        if (!(celdas[r] == nueva)) {
+            celdas[r] = nueva;
+            pendientesSSA.push_back(r);
+        }
+    }
+
+    void marcarArista(const CFG &cfg, uint32_t desde, uint32_t hacia) {
+        const vector<uint32_t> &sucesores = cfg.bloques[desde].sucesores;
+        for (size_t k = 0; k < sucesores.size(); k++) {
+            if (sucesores[k] == hacia && !aristaEjecutable[desde][k]) {
+                aristaEjecutable[desde][k] = 1;
+                pendientesFlujo.push_back({desde, hacia});
+            }
+        }
+    }
+
+    bool ejecutable(const CFG &cfg, uint32_t desde, uint32_t hacia) const {
+        const vector<uint32_t> &sucesores = cfg.bloques[desde].sucesores;
+        for (size_t k = 0; k < sucesores.size(); k++) {
+            if (sucesores[k] == hacia) {
+                return aristaEjecutable[desde][k];
+            }
+        }
+        return false;
+    }
+
+    // Resultado de una operación con operandos constantes; falso si no se puede calcular
+    // en compilación (desbordamiento o división por cero)
+    static bool calcular(OpTAC op, int64_t a, int64_t b, int64_t &r) {
+        switch (op) {
+            case OpTAC::ASIGNAR: r = a; return true;
+            case OpTAC::SUMAR: return !__builtin_add_overflow(a, b, &r);
+            case OpTAC::RESTAR: return !__builtin_sub_overflow(a, b, &r);
+            case OpTAC::MULTIPLICAR: return !__builtin_mul_overflow(a, b, &r);
+            case OpTAC::DIVIDIR:
+            case OpTAC::MODULO:
+                if (b == 0 || (a == INT64_MIN && b == -1)) {
+                    return false;
+                }
+                r = op == OpTAC::DIVIDIR ? a / b : a % b;
+                return true;
+            case OpTAC::DESPLAZAR:
+                return b >= 0 && b < 63 && !__builtin_mul_overflow(a, int64_t{1} << b, &r);
+            case OpTAC::MENOR: r = a < b; return true;
+            case OpTAC::MENOR_IGUAL: r = a <= b; return true;
+            case OpTAC::MAYOR: r = a > b; return true;
+            case OpTAC::MAYOR_IGUAL: r = a >= b; return true;
+            case OpTAC::IGUAL: r = a == b; return true;
+            case OpTAC::DISTINTO: r = a != b; return true;
+            case OpTAC::NEGAR: return !__builtin_sub_overflow(int64_t{0}, a, &r);
+            case OpTAC::NO: r = a == 0; return true;
+            default: return false;
+        }
+    }
+
+    void evaluarInstruccion(const CFG &cfg, uint32_t b, uint32_t i) {
+        const CodigoTAC &codigo = cfg.codigo;
+        OpTAC op = codigo.ops[i];
+        const BloqueBasico &bloque = cfg.bloques[b];
+        switch (op) {
+            case OpTAC::SALTAR:
+                marcarArista(cfg, b, bloque.sucesores[0]);
+                return;
+            case OpTAC::SALTAR_SI:
+            case OpTAC::SALTAR_SI_NO: {
+                Celda condicion = valor(cfg, codigo.args1[i]);
+                if (condicion.estado == Celda::INDEFINIDO) {
+                    return;
+                }
+                uint32_t salto = bloque.sucesores[0];
+                uint32_t siguiente = bloque.sucesores.back();
+                if (condicion.estado == Celda::VARIABLE) {
+                    marcarArista(cfg, b, salto);
+                    marcarArista(cfg, b, siguiente);
+                } else {
+                    bool salta = (op == OpTAC::SALTAR_SI) == (condicion.valor != 0);
+                    marcarArista(cfg, b, salta ? salto : siguiente);
+                }
+                return;
+            }
+            case OpTAC::RETORNAR:
+            case OpTAC::ETIQUETA:
+                return;
+            default:
+                break;
+        }
+        if (!CFG::esNombre(codigo.destinos[i])) {
+            return;
+        }
+        Celda a = valor(cfg, codigo.args1[i]);
+        Celda c = codigo.args2[i].vacio() ? Celda{Celda::CONSTANTE, 0} : valor(cfg, codigo.args2[i]);
+        Celda resultado = VARIABLE;
+        if (a.estado == Celda::VARIABLE || c.estado == Celda::VARIABLE) {
+            resultado = VARIABLE;
+        } else if (a.estado == Celda::INDEFINIDO || c.estado == Celda::INDEFINIDO) {
+            resultado = Celda{};
+        } else if (int64_t r; calcular(op, a.valor, c.valor, r)) {
+            resultado = {Celda::CONSTANTE, r};
+        }
+        bajar(cfg, codigo.destinos[i], resultado);
+    }
+
+    // Encuentro de los argumentos que llegan por aristas ejecutables
+    void evaluarPhi(const CFG &cfg, uint32_t b, uint32_t k) {
+        const BloqueBasico &bloque = cfg.bloques[b];
+        const Phi &phi = bloque.phis[k];
+        Celda resultado;
+        for (size_t j = 0; j < phi.args.size() && resultado.estado != Celda::VARIABLE; j++) {
+            if (!ejecutable(cfg, bloque.predecesores[j], b)) {
+                continue;
+            }
+            Celda arg = valor(cfg, phi.args[j]);
+            if (arg.estado == Celda::INDEFINIDO) {
+                continue;
+            }
+            if (resultado.estado == Celda::INDEFINIDO) {
+                resultado = arg;
+            } else if (!(resultado == arg)) {
+                resultado = VARIABLE;
+            }
+        }
+        bajar(cfg, phi.destino, resultado);
+    }
+
+    void propagar(const CFG &cfg) {
+        pendientesFlujo.push_back({CFG::NINGUNO, 0});
+        while (!pendientesFlujo.empty() || !pendientesSSA.empty()) {
+            while (!pendientesFlujo.empty()) {
+                uint32_t b = pendientesFlujo.back().second;
+                pendientesFlujo.pop_back();
+                const BloqueBasico &bloque = cfg.bloques[b];
+                for (uint32_t k = 0; k < bloque.phis.size(); k++) {
+                    evaluarPhi(cfg, b, k);
+                }
+                if (visitado[b]) {
+                    continue;
+                }
+                visitado[b] = 1;
+                for (uint32_t i : bloque.instrucciones) {
+                    evaluarInstruccion(cfg, b, i);
+                }
+                if ((bloque.instrucciones.empty() || !esTerminador(cfg.codigo.ops[bloque.instrucciones.back()])) && !bloque.sucesores.empty()) {
+                    marcarArista(cfg, b, bloque.sucesores[0]);
+                }
+            }
+            while (!pendientesSSA.empty()) {
+                uint32_t r = pendientesSSA.back();
+                pendientesSSA.pop_back();
+                for (const Uso &uso : usos[r]) {
+                    if (!visitado[uso.bloque]) {
+                        continue;
+                    }
+                    if (uso.phi) {
+                        evaluarPhi(cfg, uso.bloque, uso.posicion);
+                    } else {
+                        evaluarInstruccion(cfg, uso.bloque, uso.posicion);
+                    }
+                }
+            }
+        }
+    }
+
+    bool reescribir(CFG &cfg) {
+        CodigoTAC &codigo = cfg.codigo;
+        bool cambio = false;
+        auto esConstante = [&](Operando o) {
+            return CFG::esNombre(o) && definido[cfg.ranura(o)] && celdas[cfg.ranura(o)].estado == Celda::CONSTANTE;
+        };
+        auto sustituir = [&](Operando &o) {
+            if (esConstante(o)) {
+                o = codigo.constanteEntera(celdas[cfg.ranura(o)].valor);
+                cambio = true;
+            }
+        };
+
+        for (uint32_t b = 0; b < cfg.bloques.size(); b++) {
+            if (!visitado[b]) {
+                continue;
+            }
+            BloqueBasico &bloque = cfg.bloques[b];
+            size_t antes = bloque.phis.size();
+            bloque.phis.erase(remove_if(bloque.phis.begin(), bloque.phis.end(), [&](const Phi &phi) {
+                return esConstante(phi.destino);
+            }), bloque.phis.end());
+            cambio |= bloque.phis.size() != antes;
+            for (Phi &phi : bloque.phis) {
+                for (Operando &arg : phi.args) {
+                    sustituir(arg);
+                }
+            }
+
+            vector<uint32_t> &instrucciones = bloque.instrucciones;
+            antes = instrucciones.size();
+            instrucciones.erase(remove_if(instrucciones.begin(), instrucciones.end(), [&](uint32_t i) {
+                return esConstante(codigo.destinos[i]);
+            }), instrucciones.end());
+            cambio |= instrucciones.size() != antes;
+            for (uint32_t i : instrucciones) {
+                sustituir(codigo.args1[i]);
+                sustituir(codigo.args2[i]);
+            }
+        }
+
+        // Quitar las aristas que nunca se recorren y resolver los saltos que las usaban
+        for (uint32_t b = 0; b < cfg.bloques.size(); b++) {
+            BloqueBasico &bloque = cfg.bloques[b];
+            vector<uint32_t> muertas;
+            for (size_t k = 0; k < bloque.sucesores.size(); k++) {
+                if (!aristaEjecutable[b][k]) {
+                    muertas.push_back(bloque.sucesores[k]);
+                }
+            }
+            if (muertas.empty()) {
+                continue;
+            }
+            cambio = true;
+            for (uint32_t s : muertas) {
+                cfg.quitarArista(b, s);
+            }
+            if (!visitado[b] || bloque.instrucciones.empty()) {
+                continue;
+            }
+            uint32_t ultima = bloque.instrucciones.back();
+            if (codigo.ops[ultima] == OpTAC::SALTAR_SI || codigo.ops[ultima] == OpTAC::SALTAR_SI_NO) {
+                if (!bloque.sucesores.empty() && codigo.destinos[ultima] == Operando::etiqueta(bloque.sucesores[0])) {
+                    codigo.ops[ultima] = OpTAC::SALTAR;
+                    codigo.args1[ultima] = {};
+                } else {
+                    bloque.instrucciones.pop_back();
+                }
+            }
+        }
+        return cambio;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Limpieza del CFG: bloques inalcanzables y almacenamientos muertos
+// ---------------------------------------------------------------------------
+
+// Borra los bloques a los que no se llega desde la entrada y puentea los bloques
+// vacíos que solo pasan el control a otro, así los saltos van directo al destino.
+// Un salto condicional cuyas dos salidas terminan en el mismo bloque pasa a ser un
+// salto simple. Fuera de SSA, porque puentear cambiaría los predecesores de las phi.
+class LimpiarCFG : public Pasada {
+public:
+    const char *nombre() const override { return "limpiar-cfg"; }
+
+    bool ejecutar(CFG &cfg) override {
+        if (cfg.enSSA) {
+            return false;
+        }
+        bool cambio = puentearVacios(cfg);
+        if (cambio) {
+            cfg.recalcular();
+        }
+        cambio |= quitarInalcanzables(cfg);
+        return cambio;
+    }
+
+private:
+    // Bloque que no hace nada salvo seguir a su único sucesor
+    static bool esPuente(const CFG &cfg, uint32_t b) {
+        const BloqueBasico &bloque = cfg.bloques[b];
+        if (b == 0 || bloque.sucesores.size() != 1 || bloque.sucesores[0] == b) {
+            return false;
+        }
+        return bloque.instrucciones.empty()
+            || (bloque.instrucciones.size() == 1 && cfg.codigo.ops[bloque.instrucciones[0]] == OpTAC::SALTAR);
+    }
+
+    static bool puentearVacios(CFG &cfg) {
+        CodigoTAC &codigo = cfg.codigo;
+        bool cambio = false;
+        for (uint32_t e = 0; e < cfg.bloques.size(); e++) {
+            if (!esPuente(cfg, e)) {
+                continue;
+            }
+            // Seguir la cadena de puentes hasta el primer bloque con contenido
+            uint32_t destino = cfg.bloques[e].sucesores[0];
+            for (uint32_t pasos = 0; esPuente(cfg, destino) && destino != e && pasos < cfg.bloques.size(); pasos++) {
+                destino = cfg.bloques[destino].sucesores[0];
+            }
+            if (destino == e) {
+                continue;
+            }
+            vector<uint32_t> predecesores = move(cfg.bloques[e].predecesores);
+            cfg.bloques[e].predecesores.clear();
+            for (uint32_t p : predecesores) {
+                BloqueBasico &origen = cfg.bloques[p];
+                replace(origen.sucesores.begin(), origen.sucesores.end(), e, destino);
+                if (origen.sucesores.size() == 2 && origen.sucesores[0] == origen.sucesores[1]) {
+                    origen.sucesores.pop_back();
+                }
+                uint32_t ultima = origen.instrucciones.empty() ? CFG::NINGUNO : origen.instrucciones.back();
+                if (ultima != CFG::NINGUNO && codigo.destinos[ultima] == Operando::etiqueta(e)) {
+                    codigo.destinos[ultima] = Operando::etiqueta(destino);
+                }
+                cambio = true;
+            }
+        }
+
+        for (BloqueBasico &bloque : cfg.bloques) {
+            if (bloque.sucesores.size() != 1 || bloque.instrucciones.empty()) {
+                continue;
+            }
+            uint32_t ultima = bloque.instrucciones.back();
+            if (codigo.ops[ultima] == OpTAC::SALTAR_SI || codigo.ops[ultima] == OpTAC::SALTAR_SI_NO) {
+                codigo.ops[ultima] = OpTAC::SALTAR;
+                codigo.destinos[ultima] = Operando::etiqueta(bloque.sucesores[0]);
+                codigo.args1[ultima] = {};
+                cambio = true;
+            }
+        }
+        return cambio;
+    }
+
+    // Compacta el vector de bloques y renumera aristas y destinos de salto
+    static bool quitarInalcanzables(CFG &cfg) {
+        vector<uint32_t> nuevoNumero(cfg.bloques.size(), CFG::NINGUNO);
+        uint32_t vivos = 0;
+        for (uint32_t b = 0; b < cfg.bloques.size(); b++) {
+            if (cfg.alcanzable(b)) {
+                nuevoNumero[b] = vivos++;
+            }
+        }
+        if (vivos == cfg.bloques.size()) {
+            return false;
+        }
+
+        CodigoTAC &codigo = cfg.codigo;
+        vector<BloqueBasico> bloques;
+        bloques.reserve(vivos);
+        for (uint32_t b = 0; b < cfg.bloques.size(); b++) {
+            if (nuevoNumero[b] == CFG::NINGUNO) {
+                continue;
+            }
+            BloqueBasico bloque;
+            bloque.instrucciones = move(cfg.bloques[b].instrucciones);
+            for (uint32_t s : cfg.bloques[b].sucesores) {
+                bloque.sucesores.push_back(nuevoNumero[s]);
+            }
+            if (!bloque.instrucciones.empty()) {
+                Operando &salto = codigo.destinos[bloque.instrucciones.back()];
+                if (esTerminador(codigo.ops[bloque.instrucciones.back()]) && salto.clase() == Operando::ETIQUETA && !salto.vacio()) {
+                    salto = Operando::etiqueta(nuevoNumero[salto.indice()]);
+                }
+            }
+            bloques.push_back(move(bloque));
+        }
+        cfg.bloques = move(bloques);
+        codigo.etiquetas = vivos;
+        return true;
+    }
+};
+
+// Eliminación de almacenamientos muertos guiada por la vivacidad. Una asignación cuyo
+// destino no se lee en ningún camino posterior se borra; como borrarla puede matar
+// a las que la alimentaban, se repite hasta que no cambia nada. El único efecto de una
+// operación del TAC es fallar, así que solo se conservan sin uso las que pueden fallar.
+class EliminarAlmacenamientosMuertos : public Pasada {
+public:
+    const char *nombre() const override { return "almacenamientos-muertos"; }
+
+    bool ejecutar(CFG &cfg) override {
+        if (cfg.enSSA) {
+            return false;
+        }
+        bool cambio = false;
+        while (barrer(cfg)) {
+            cambio = true;
+        }
+        return cambio;
+    }
+
+private:
+    using Conjunto = Vivacidad::Conjunto;
+
+    // Borra las definiciones muertas según la vivacidad actual; verdadero si borró alguna
+    static bool barrer(CFG &cfg) {
+        CodigoTAC &codigo = cfg.codigo;
+        Vivacidad vivacidad(cfg);
+
+        bool borro = false;
+        for (uint32_t b : cfg.postordenInverso) {
+            Conjunto vivos = move(vivacidad.salida[b]);
+            vector<uint32_t> &instrucciones = cfg.bloques[b].instrucciones;
+            vector<uint32_t> conservadas;
+            conservadas.reserve(instrucciones.size());
+            for (size_t k = instrucciones.size(); k-- > 0;) {
+                uint32_t i = instrucciones[k];
+                Operando destino = codigo.destinos[i];
+                if (CFG::esNombre(destino)) {
+                    if (!Vivacidad::contiene(vivos, cfg.ranura(destino)) && !puedeFallar(codigo, i)) {
+                        borro = true;
+                        continue;
+                    }
+                    Vivacidad::quitar(vivos, cfg.ranura(destino));
+                }
+                for (Operando o : {codigo.args1[i], codigo.args2[i]}) {
+                    if (CFG::esNombre(o)) Vivacidad::agregar(vivos, cfg.ranura(o));
+                }
+                conservadas.push_back(i);
+            }
+            reverse(conservadas.begin(), conservadas.end());
+            instrucciones = move(conservadas);
+        }
+        return borro;
+    }
+};
+
+// Fusión de copias: una copia `d = a` se borra renombrando a como d en todo el programa
+// cuando los dos nombres nunca están vivos a la vez (ninguno se define mientras el
+// otro sigue vivo). Limpia sobre todo las copias que deja salir de SSA en los bucles.
+class FusionarCopias : public Pasada {
+public:
+    const char *nombre() const override { return "fusionar-copias"; }
+
+    bool ejecutar(CFG &cfg) override {
+        if (cfg.enSSA) {
+            return false;
+        }
+        bool cambio = false;
+        for (bool fusiono = true; fusiono;) {
+            fusiono = false;
+            Vivacidad vivacidad(cfg);
+            for (uint32_t b : cfg.postordenInverso) {
+                for (uint32_t i : cfg.bloques[b].instrucciones) {
+                    Operando d = cfg.codigo.destinos[i], a = cfg.codigo.args1[i];
+                    if (cfg.codigo.ops[i] == OpTAC::ASIGNAR && CFG::esNombre(d) && CFG::esNombre(a) && d != a
+                        && !interfieren(cfg, vivacidad, d, a)) {
+                        renombrar(cfg, a, d);
+                        fusiono = cambio = true;
+                        break;
+                    }
+                }
+                if (fusiono) break;
+            }
+        }
+        return cambio;
+    }
+
+private:
+    static bool interfieren(const CFG &cfg, const Vivacidad &vivacidad, Operando x, Operando y) {
+        const CodigoTAC &codigo = cfg.codigo;
+        for (uint32_t b : cfg.postordenInverso) {
+            bool vivoX = Vivacidad::contiene(vivacidad.salida[b], CFG::ranura(x));
+            bool vivoY = Vivacidad::contiene(vivacidad.salida[b], CFG::ranura(y));
+            const vector<uint32_t> &instrucciones = cfg.bloques[b].instrucciones;
+            for (size_t k = instrucciones.size(); k-- > 0;) {
+                uint32_t i = instrucciones[k];
+                Operando destino = codigo.destinos[i];
+                // La copia entre los dos no cuenta: después de ella valen lo mismo
+                bool copiaEntreAmbos = codigo.ops[i] == OpTAC::ASIGNAR
+                    && ((destino == x && codigo.args1[i] == y) || (destino == y && codigo.args1[i] == x));
+                if (destino == x) {
+                    if (vivoY && !copiaEntreAmbos) return true;
+                    vivoX = false;
+                } else if (destino == y) {
+                    if (vivoX && !copiaEntreAmbos) return true;
+                    vivoY = false;
+                }
+                for (Operando o : {codigo.args1[i], codigo.args2[i]}) {
+                    vivoX |= o == x;
+                    vivoY |= o == y;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Cambia `viejo` por `nuevo` en todo el programa y borra las copias que quedan triviales
+    static void renombrar(CFG &cfg, Operando viejo, Operando nuevo) {
+        CodigoTAC &codigo = cfg.codigo;
+        for (uint32_t b : cfg.postordenInverso) {
+            vector<uint32_t> &instrucciones = cfg.bloques[b].instrucciones;
+            for (uint32_t i : instrucciones) {
+                if (codigo.destinos[i] == viejo) codigo.destinos[i] = nuevo;
+                if (codigo.args1[i] == viejo) codigo.args1[i] = nuevo;
+                if (codigo.args2[i] == viejo) codigo.args2[i] = nuevo;
+            }
+            instrucciones.erase(remove_if(instrucciones.begin(), instrucciones.end(), [&](uint32_t i) {
+                return codigo.ops[i] == OpTAC::ASIGNAR && codigo.destinos[i] == codigo.args1[i];
+            }), instrucciones.end());
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Bucles naturales: código invariante y variables de inducción
+// ---------------------------------------------------------------------------
+
+// Bucle natural de una cabecera: la unión de los ciclos que vuelven a ella por
+// aristas hacia atrás (desde bloques que la cabecera domina)
+struct BucleNatural {
+    uint32_t cabecera;
+    uint32_t preencabezado = CFG::NINGUNO;  // único bloque externo que entra a la cabecera
+    vector<uint32_t> bloques;               // incluye la cabecera, en postorden inverso
+    vector<uint32_t> retornos;              // orígenes de las aristas hacia atrás
+    vector<uint8_t> contiene;               // indexado por número de bloque
+
+    bool incluye(uint32_t b) const { return contiene[b]; }
+};
+
+// Bucles del CFG, los más internos primero. Dos aristas hacia atrás a la misma
+// cabecera forman un solo bucle.
+vector<BucleNatural> detectarBucles(const CFG &cfg) {
+    vector<BucleNatural> bucles;
+    vector<uint32_t> bucleDe(cfg.bloques.size(), CFG::NINGUNO);
+    for (uint32_t b : cfg.postordenInverso) {
+        for (uint32_t s : cfg.bloques[b].sucesores) {
+            if (!cfg.domina(s, b)) {
+                continue;
+            }
+            if (bucleDe[s] == CFG::NINGUNO) {
+                bucleDe[s] = static_cast<uint32_t>(bucles.size());
+                BucleNatural bucle;
+                bucle.cabecera = s;
+                bucle.contiene.assign(cfg.bloques.size(), 0);
+                bucle.contiene[s] = 1;
+                bucles.push_back(move(bucle));
+            }
+            BucleNatural &bucle = bucles[bucleDe[s]];
+            bucle.retornos.push_back(b);
+            // Todo lo que llega al origen de la arista sin pasar por la cabecera
+            vector<uint32_t> pendiente{b};
+            while (!pendiente.empty()) {
+                uint32_t x = pendiente.back();
+                pendiente.pop_back();
+                if (bucle.contiene[x]) {
+                    continue;
+                }
+                bucle.contiene[x] = 1;
+                for (uint32_t p : cfg.bloques[x].predecesores) {
+                    if (cfg.alcanzable(p)) pendiente.push_back(p);
+                }
+            }
+        }
+    }
+
+    for (BucleNatural &bucle : bucles) {
+        for (uint32_t b : cfg.postordenInverso) {
+            if (bucle.contiene[b]) bucle.bloques.push_back(b);
+        }
+        vector<uint32_t> externos;
+        for (uint32_t p : cfg.bloques[bucle.cabecera].predecesores) {
+            if (!bucle.contiene[p] && cfg.alcanzable(p)) externos.push_back(p);
+        }
+        if (externos.size() == 1 && cfg.bloques[externos[0]].sucesores.size() == 1) {
+            bucle.preencabezado = externos[0];
+        }
+    }
+    stable_sort(bucles.begin(), bucles.end(), [](const BucleNatural &a, const BucleNatural &b) {
+        return a.bloques.size() < b.bloques.size();
+    });
+    return bucles;
+}
+
+// Da a cada bucle un preencabezado: un bloque nuevo justo antes de la cabecera por el
+// que pasan todas las entradas desde fuera. Verdadero si tuvo que crear alguno.
+bool asegurarPreencabezados(CFG &cfg) {
+    bool creo = false;
+    for (;;) {
+        vector<BucleNatural> bucles = detectarBucles(cfg);
+        auto sinPreencabezado = find_if(bucles.begin(), bucles.end(), [](const BucleNatural &bucle) {
+            return bucle.preencabezado == CFG::NINGUNO;
+        });
+        if (sinPreencabezado == bucles.end()) {
+            return creo;
+        }
+        uint32_t cabecera = sinPreencabezado->cabecera;
+        vector<uint32_t> externos;
+        for (uint32_t p : cfg.bloques[cabecera].predecesores) {
+            if (!sinPreencabezado->incluye(p)) externos.push_back(p < cabecera ? p : p + 1);
+        }
+        uint32_t nuevo = cfg.insertarBloqueAntes(cabecera);
+        for (uint32_t p : externos) {
+            cfg.redirigirArista(p, cabecera + 1, nuevo);
+        }
+        cfg.recalcular();
+        creo = true;
+    }
+}
+
+// Operaciones aritméticas y lógicas puras, que se pueden mover sin cambiar efectos
+inline bool esCalculo(OpTAC op) {
+    return op != OpTAC::ETIQUETA && !esTerminador(op);
+}
+
+// Mueve al preencabezado los cálculos cuyos operandos no cambian dentro del bucle.
+// Una instrucción `d = a op b` sale del bucle si a y b son constantes o invariantes,
+// d se define una sola vez en el bucle y d no está vivo ni al entrar a la cabecera
+// ni en las salidas: así ningún camino nota que d se calcula antes. Las divisiones
+// solo salen con un divisor constante distinto de 0 y de -1, para no adelantar un error.
+class MoverInvariantes : public Pasada {
+public:
+    const char *nombre() const override { return "invariantes"; }
+
+    bool ejecutar(CFG &cfg) override {
+        if (cfg.enSSA) {
+            return false;
+        }
+        bool cambio = asegurarPreencabezados(cfg);
+        for (const BucleNatural &bucle : detectarBucles(cfg)) {
+            cambio |= moverDe(cfg, bucle);
+        }
+        return cambio;
+    }
+
+private:
+    static bool moverDe(CFG &cfg, const BucleNatural &bucle) {
+        CodigoTAC &codigo = cfg.codigo;
+        Vivacidad vivacidad(cfg);
+        vector<uint32_t> definiciones(cfg.numeroRanuras(), 0);
+        for (uint32_t b : bucle.bloques) {
+            for (uint32_t i : cfg.bloques[b].instrucciones) {
+                if (CFG::esNombre(codigo.destinos[i])) definiciones[cfg.ranura(codigo.destinos[i])]++;
+            }
+        }
+        vector<uint32_t> salidas;
+        for (uint32_t b : bucle.bloques) {
+            for (uint32_t s : cfg.bloques[b].sucesores) {
+                if (!bucle.incluye(s)) salidas.push_back(s);
+            }
+        }
+
+        // Un nombre movido deja de contar como definido dentro del bucle
+        auto invariante = [&](Operando o) {
+            return o.vacio() || o.clase() == Operando::CONSTANTE || (CFG::esNombre(o) && definiciones[cfg.ranura(o)] == 0);
+        };
+        auto movible = [&](uint32_t i) {
+            Operando destino = codigo.destinos[i];
+            if (!esCalculo(codigo.ops[i]) || !CFG::esNombre(destino) || definiciones[cfg.ranura(destino)] != 1) {
+                return false;
+            }
+            if (!invariante(codigo.args1[i]) || !invariante(codigo.args2[i]) || puedeFallar(codigo, i)) {
+                return false;
+            }
+            if (vivacidad.vivoAlEntrar(cfg, bucle.cabecera, destino)) {
+                return false;
+            }
+            for (uint32_t s : salidas) {
+                if (vivacidad.vivoAlEntrar(cfg, s, destino)) return false;
+            }
+            return true;
+        };
+
+        bool movio = false;
+        bool cambio = true;
+        while (cambio) {
+            cambio = false;
+            for (uint32_t b : bucle.bloques) {
+                vector<uint32_t> &instrucciones = cfg.bloques[b].instrucciones;
+                for (size_t k = 0; k < instrucciones.size();) {
+                    uint32_t i = instrucciones[k];
+                    if (!movible(i)) {
+                        k++;
+                        continue;
+                    }
+                    instrucciones.erase(instrucciones.begin() + k);
+                    cfg.moverAlFinal(bucle.preencabezado, i);
+                    definiciones[cfg.ranura(codigo.destinos[i])] = 0;
+                    cambio = movio = true;
+                }
+            }
+        }
+        return movio;
+    }
+};
+
+// Variable de inducción básica: se define una sola vez en el bucle, como v = v + paso
+struct Induccion {
+    Operando variable;
+    int64_t paso;
+    uint32_t bloque;        // dónde se actualiza
+    uint32_t instruccion;
+};
+
+// Variables de inducción básicas de un bucle
+vector<Induccion> buscarInducciones(const CFG &cfg, const BucleNatural &bucle) {
+    const CodigoTAC &codigo = cfg.codigo;
+    vector<uint32_t> definiciones(cfg.numeroRanuras(), 0);
+    for (uint32_t b : bucle.bloques) {
+        for (uint32_t i : cfg.bloques[b].instrucciones) {
+            if (CFG::esNombre(codigo.destinos[i])) definiciones[cfg.ranura(codigo.destinos[i])]++;
+        }
+    }
+    auto entero = [&](Operando o, int64_t &valor) {
+        if (o.vacio() || o.clase() != Operando::CONSTANTE || codigo.constantes[o.indice()].cadena != N_VACIO) {
+            return false;
+        }
+        valor = codigo.constantes[o.indice()].entero;
+        return true;
+    };
+
+    vector<Induccion> inducciones;
+    for (uint32_t b : bucle.bloques) {
+        for (uint32_t i : cfg.bloques[b].instrucciones) {
+            Operando v = codigo.destinos[i];
+            if (!CFG::esNombre(v) || definiciones[cfg.ranura(v)] != 1) {
+                continue;
+            }
+            int64_t paso;
+            OpTAC op = codigo.ops[i];
+            if (op == OpTAC::SUMAR && codigo.args1[i] == v && entero(codigo.args2[i], paso)) {
+            } else if (op == OpTAC::SUMAR && codigo.args2[i] == v && entero(codigo.args1[i], paso)) {
+            } else if (op == OpTAC::RESTAR && codigo.args1[i] == v && entero(codigo.args2[i], paso) && paso != INT64_MIN) {
+                paso = -paso;
+            } else {
+                continue;
+            }
+            inducciones.push_back({v, paso, b, i});
+        }
+    }
+    return inducciones;
+}
+
+// Reducción de fuerza: un producto `t = i * k` (o `i << k`) con i de inducción y k
+// constante se reemplaza por una variable s que arranca en i * k en el preencabezado y
+// suma paso * k justo después de cada actualización de i. Luego t = s se propaga a los
+// usos siguientes del mismo bloque y la copia suele quedar muerta.
+// Si después i solo se usa en comparaciones con constantes, con k > 0 las pruebas
+// pasan a ser sobre s (i < n equivale a s < n * k) y la actualización de i desaparece.
+class ReducirFuerza : public Pasada {
+public:
+    const char *nombre() const override { return "reduccion-fuerza"; }
+
+    bool ejecutar(CFG &cfg) override {
+        if (cfg.enSSA) {
+            return false;
+        }
+        bool cambio = asegurarPreencabezados(cfg);
+        for (const BucleNatural &bucle : detectarBucles(cfg)) {
+            cambio |= reducir(cfg, bucle);
+        }
+        return cambio;
+    }
+
+private:
+    static bool reducir(CFG &cfg, const BucleNatural &bucle) {
+        CodigoTAC &codigo = cfg.codigo;
+        vector<Induccion> inducciones = buscarInducciones(cfg, bucle);
+        if (inducciones.empty()) {
+            return false;
+        }
+        auto induccionDe = [&](Operando o) -> const Induccion * {
+            for (const Induccion &induccion : inducciones) {
+                if (induccion.variable == o) return &induccion;
+            }
+            return nullptr;
+        };
+
+        // (variable de inducción, factor) -> variable reducida ya creada
+        vector<tuple<Operando, int64_t, Operando>> reducidas;
+        bool cambio = false;
+        for (uint32_t b : bucle.bloques) {
+            vector<uint32_t> &instrucciones = cfg.bloques[b].instrucciones;
+            for (size_t k = 0; k < instrucciones.size(); k++) {
+                uint32_t i = instrucciones[k];
+                OpTAC op = codigo.ops[i];
+                const Induccion *induccion = nullptr;
+                Operando constante;
+                if (op == OpTAC::MULTIPLICAR || op == OpTAC::DESPLAZAR) {
+                    if ((induccion = induccionDe(codigo.args1[i]))) {
+                        constante = codigo.args2[i];
+                    } else if (op == OpTAC::MULTIPLICAR && (induccion = induccionDe(codigo.args2[i]))) {
+                        constante = codigo.args1[i];
+                    }
+                }
+                if (!induccion || constante.vacio() || constante.clase() != Operando::CONSTANTE
+                    || codigo.constantes[constante.indice()].cadena != N_VACIO || codigo.destinos[i] == induccion->variable) {
+                    continue;
+                }
+                int64_t factor = codigo.constantes[constante.indice()].entero;
+                if (op == OpTAC::DESPLAZAR) {
+                    if (factor < 0 || factor > 62) continue;
+                    factor = int64_t{1} << factor;
+                }
+                int64_t incremento;
+                if (__builtin_mul_overflow(induccion->paso, factor, &incremento)) {
+                    continue;
+                }
+
+                Operando reducida;
+                for (auto &[variable, f, s] : reducidas) {
+                    if (variable == induccion->variable && f == factor) reducida = s;
+                }
+                if (reducida.vacio()) {
+                    reducida = codigo.nuevoTemporal();
+                    reducidas.emplace_back(induccion->variable, factor, reducida);
+                    cfg.agregarAlFinal(bucle.preencabezado, OpTAC::MULTIPLICAR, reducida, induccion->variable, codigo.constanteEntera(factor));
+                    codigo.emitir(OpTAC::SUMAR, reducida, reducida, codigo.constanteEntera(incremento));
+                    vector<uint32_t> &actualiza = cfg.bloques[induccion->bloque].instrucciones;
+                    auto despues = find(actualiza.begin(), actualiza.end(), induccion->instruccion) + 1;
+                    size_t posicion = despues - actualiza.begin();
+                    actualiza.insert(despues, static_cast<uint32_t>(codigo.size() - 1));
+                    // La actualización pudo quedar antes de la instrucción actual en este bloque
+                    if (induccion->bloque == b && posicion <= k) k++;
+                    i = instrucciones[k];
+                }
+
+                codigo.ops[i] = OpTAC::ASIGNAR;
+                codigo.args1[i] = reducida;
+                codigo.args2[i] = {};
+                propagarCopia(cfg, b, k, codigo.destinos[i], reducida);
+                cambio = true;
+            }
+        }
+
+        for (auto &[variable, factor, reducida] : reducidas) {
+            if (factor > 0) {
+                reemplazarPruebas(cfg, bucle, *induccionDe(variable), factor, reducida);
+            }
+        }
+        return cambio;
+    }
+
+    static bool esRelacion(OpTAC op) {
+        return op >= OpTAC::MENOR && op <= OpTAC::DISTINTO;
+    }
+
+    // Reemplazo de la prueba lineal: las comparaciones `i REL n` pasan a `s REL n * factor`
+    // y se borra la actualización de i, que ya nadie lee
+    static void reemplazarPruebas(CFG &cfg, const BucleNatural &bucle, const Induccion &induccion, int64_t factor, Operando reducida) {
+        CodigoTAC &codigo = cfg.codigo;
+        Operando i = induccion.variable;
+        vector<uint32_t> pruebas;
+        for (uint32_t b : bucle.bloques) {
+            for (uint32_t instruccion : cfg.bloques[b].instrucciones) {
+                bool lee = codigo.args1[instruccion] == i || codigo.args2[instruccion] == i;
+                if (!lee || instruccion == induccion.instruccion) {
+                    continue;
+                }
+                Operando otro = codigo.args1[instruccion] == i ? codigo.args2[instruccion] : codigo.args1[instruccion];
+                int64_t n, escalado;
+                if (!esRelacion(codigo.ops[instruccion]) || otro.vacio() || otro.clase() != Operando::CONSTANTE
+                    || codigo.constantes[otro.indice()].cadena != N_VACIO) {
+                    return;
+                }
+                n = codigo.constantes[otro.indice()].entero;
+                if (__builtin_mul_overflow(n, factor, &escalado)) {
+                    return;
+                }
+                pruebas.push_back(instruccion);
+            }
+        }
+        Vivacidad vivacidad(cfg);
+        for (uint32_t b : bucle.bloques) {
+            for (uint32_t s : cfg.bloques[b].sucesores) {
+                if (!bucle.incluye(s) && vivacidad.vivoAlEntrar(cfg, s, i)) return;
+            }
+        }
+
+        for (uint32_t prueba : pruebas) {
+            bool izquierda = codigo.args1[prueba] == i;
+            Operando &otro = izquierda ? codigo.args2[prueba] : codigo.args1[prueba];
+            otro = codigo.constanteEntera(codigo.constantes[otro.indice()].entero * factor);
+            (izquierda ? codigo.args1[prueba] : codigo.args2[prueba]) = reducida;
+        }
+        vector<uint32_t> &instrucciones = cfg.bloques[induccion.bloque].instrucciones;
+        instrucciones.erase(find(instrucciones.begin(), instrucciones.end(), induccion.instruccion));
+    }
+
+    // Reemplaza los usos de `copia` por `original` después de la posición k del bloque,
+    // mientras ninguno de los dos se vuelva a definir
+    static void propagarCopia(CFG &cfg, uint32_t b, size_t k, Operando copia, Operando original) {
+        CodigoTAC &codigo = cfg.codigo;
+        const vector<uint32_t> &instrucciones = cfg.bloques[b].instrucciones;
+        for (size_t j = k + 1; j < instrucciones.size(); j++) {
+            uint32_t i = instrucciones[j];
+            if (codigo.args1[i] == copia) codigo.args1[i] = original;
+            if (codigo.args2[i] == copia) codigo.args2[i] = original;
+            if (codigo.destinos[i] == copia || codigo.destinos[i] == original) {
+                return;
+            }
+        }
+    }
+};
+
+// Reemplazo por el valor final: si la única salida de un bucle es la prueba de la
+// cabecera `i REL n` con i de inducción, n constante y el valor inicial de i conocido,
+// el número de vueltas se calcula en compilación. Si además el bucle no hace otra cosa
+// que avanzar variables de inducción (lo demás muere al salir), se reemplaza entero
+// por las asignaciones de los valores finales en el preencabezado.
+class ValorFinalInduccion : public Pasada {
+public:
+    const char *nombre() const override { return "valor-final"; }
+
+    bool ejecutar(CFG &cfg) override {
+        if (cfg.enSSA) {
+            return false;
+        }
+        bool cambio = asegurarPreencabezados(cfg);
+        // Borrar un bucle cambia el CFG, así que se vuelven a buscar después de cada uno
+        for (bool borro = true; borro;) {
+            borro = false;
+            for (const BucleNatural &bucle : detectarBucles(cfg)) {
+                if (reemplazar(cfg, bucle)) {
+                    cfg.recalcular();
+                    borro = cambio = true;
+                    break;
+                }
+            }
+        }
+        return cambio;
+    }
+
+private:
+    static bool entero(const CodigoTAC &codigo, Operando o, int64_t &valor) {
+        if (o.vacio() || o.clase() != Operando::CONSTANTE || codigo.constantes[o.indice()].cadena != N_VACIO) {
+            return false;
+        }
+        valor = codigo.constantes[o.indice()].entero;
+        return true;
+    }
+
+    // Valor constante que tiene `v` al final del preencabezado, siguiendo hacia atrás
+    // los bloques de un solo predecesor
+    static bool valorInicial(const CFG &cfg, uint32_t b, Operando v, int64_t &valor) {
+        const CodigoTAC &codigo = cfg.codigo;
+        for (uint32_t pasos = 0; pasos < cfg.bloques.size(); pasos++) {
+            const vector<uint32_t> &instrucciones = cfg.bloques[b].instrucciones;
+            for (size_t k = instrucciones.size(); k-- > 0;) {
+                uint32_t i = instrucciones[k];
+                if (codigo.destinos[i] == v) {
+                    return codigo.ops[i] == OpTAC::ASIGNAR && entero(codigo, codigo.args1[i], valor);
+                }
+            }
+            if (cfg.bloques[b].predecesores.size() != 1) {
+                return false;
+            }
+            b = cfg.bloques[b].predecesores[0];
+        }
+        return false;
+    }
+
+    // Vueltas que da `while (i REL n)` con i = inicio, inicio + paso, ...; falso si no
+    // termina o no se puede calcular
+    static bool contarVueltas(OpTAC relacion, __int128 inicio, __int128 paso, __int128 n, __int128 &vueltas) {
+        auto cumple = [&](__int128 i) {
+            switch (relacion) {
+                case OpTAC::MENOR: return i < n;
+                case OpTAC::MENOR_IGUAL: return i <= n;
+                case OpTAC::MAYOR: return i > n;
+                case OpTAC::MAYOR_IGUAL: return i >= n;
+                case OpTAC::IGUAL: return i == n;
+                default: return i != n;
+            }
+        };
+        if (!cumple(inicio)) {
+            vueltas = 0;
+            return true;
+        }
+        if (paso == 0) {
+            return false;
+        }
+        switch (relacion) {
+            case OpTAC::MENOR:
+                if (paso < 0) return false;
+                vueltas = (n - inicio + paso - 1) / paso;
+                return true;
+            case OpTAC::MENOR_IGUAL:
+                if (paso < 0) return false;
+                vueltas = (n - inicio) / paso + 1;
+                return true;
+            case OpTAC::MAYOR:
+                if (paso > 0) return false;
+                vueltas = (inicio - n - paso - 1) / -paso;
+                return true;
+            case OpTAC::MAYOR_IGUAL:
+                if (paso > 0) return false;
+                vueltas = (inicio - n) / -paso + 1;
+                return true;
+            case OpTAC::IGUAL:
+                vueltas = 1;
+                return true;
+            case OpTAC::DISTINTO:
+                if ((n - inicio) % paso != 0 || (n - inicio) / paso < 0) return false;
+                vueltas = (n - inicio) / paso;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // La relación que mantiene el bucle cuando la variable queda a la izquierda
+    static OpTAC invertir(OpTAC relacion) {
+        switch (relacion) {
+            case OpTAC::MENOR: return OpTAC::MAYOR;
+            case OpTAC::MENOR_IGUAL: return OpTAC::MAYOR_IGUAL;
+            case OpTAC::MAYOR: return OpTAC::MENOR;
+            case OpTAC::MAYOR_IGUAL: return OpTAC::MENOR_IGUAL;
+            default: return relacion;
+        }
+    }
+
+    static OpTAC negar(OpTAC relacion) {
+        switch (relacion) {
+            case OpTAC::MENOR: return OpTAC::MAYOR_IGUAL;
+            case OpTAC::MENOR_IGUAL: return OpTAC::MAYOR;
+            case OpTAC::MAYOR: return OpTAC::MENOR_IGUAL;
+            case OpTAC::MAYOR_IGUAL: return OpTAC::MENOR;
+            case OpTAC::IGUAL: return OpTAC::DISTINTO;
+            default: return OpTAC::IGUAL;
+        }
+    }
+
+    static bool reemplazar(CFG &cfg, const BucleNatural &bucle) {
+        CodigoTAC &codigo = cfg.codigo;
+        const BloqueBasico &cabecera = cfg.bloques[bucle.cabecera];
+
+        // La cabecera debe ser exactamente `t = i REL n; salto condicional` y la única salida
+        if (cabecera.instrucciones.size() != 2 || cabecera.sucesores.size() != 2) {
+            return false;
+        }
+        uint32_t prueba = cabecera.instrucciones[0], salto = cabecera.instrucciones[1];
+        OpTAC relacion = codigo.ops[prueba];
+        if (relacion < OpTAC::MENOR || relacion > OpTAC::DISTINTO || codigo.args1[salto] != codigo.destinos[prueba]) {
+            return false;
+        }
+        uint32_t salida = CFG::NINGUNO;
+        for (uint32_t b : bucle.bloques) {
+            for (uint32_t s : cfg.bloques[b].sucesores) {
+                if (bucle.incluye(s)) continue;
+                if (b != bucle.cabecera || salida != CFG::NINGUNO) return false;
+                salida = s;
+            }
+        }
+        if (salida == CFG::NINGUNO) {
+            return false;
+        }
+        // El bucle sigue mientras la condición mantiene el salto dentro
+        bool saltaAfuera = codigo.destinos[salto] == Operando::etiqueta(salida);
+        if (saltaAfuera == (codigo.ops[salto] == OpTAC::SALTAR_SI)) {
+            relacion = negar(relacion);
+        }
+
+        // Solo cuentan las inducciones que corren una vez por vuelta: su bloque domina a
+        // todos los retornos. Las que están dentro de un if se tratan como cualquier otra cosa.
+        vector<Induccion> inducciones = buscarInducciones(cfg, bucle);
+        inducciones.erase(remove_if(inducciones.begin(), inducciones.end(), [&](const Induccion &induccion) {
+            return any_of(bucle.retornos.begin(), bucle.retornos.end(), [&](uint32_t r) {
+                return !cfg.domina(induccion.bloque, r);
+            });
+        }), inducciones.end());
+        auto induccionDe = [&](Operando o) -> const Induccion * {
+            for (const Induccion &induccion : inducciones) {
+                if (induccion.variable == o) return &induccion;
+            }
+            return nullptr;
+        };
+        const Induccion *control = induccionDe(codigo.args1[prueba]);
+        Operando limite = codigo.args2[prueba];
+        if (!control) {
+            control = induccionDe(codigo.args2[prueba]);
+            limite = codigo.args1[prueba];
+            relacion = invertir(relacion);
+        }
+        int64_t n, inicio;
+        if (!control || !entero(codigo, limite, n) || !valorInicial(cfg, bucle.preencabezado, control->variable, inicio)) {
+            return false;
+        }
+
+        // Lo que no es inducción ni la prueba tiene que morir al salir, y nada puede fallar
+        Vivacidad vivacidad(cfg);
+        for (uint32_t b : bucle.bloques) {
+            for (uint32_t i : cfg.bloques[b].instrucciones) {
+                if (i == prueba || esTerminador(codigo.ops[i])) {
+                    continue;
+                }
+                if (puedeFallar(codigo, i)) {
+                    return false;
+                }
+                Operando destino = codigo.destinos[i];
+                bool esInduccion = induccionDe(destino) && induccionDe(destino)->instruccion == i;
+                if (!esInduccion && vivacidad.vivoAlEntrar(cfg, salida, destino)) {
+                    return false;
+                }
+            }
+        }
+        if (vivacidad.vivoAlEntrar(cfg, salida, codigo.destinos[prueba])) {
+            return false;
+        }
+
+        __int128 vueltas;
+        if (!contarVueltas(relacion, inicio, control->paso, n, vueltas)) {
+            return false;
+        }
+        // Valores a la salida: constantes si se conoce el inicial, si no un avance que se
+        // suma. La variable de control también debe caber en 64 bits en la última prueba.
+        struct Final {
+            Operando variable;
+            int64_t valor;
+            bool absoluto;
+        };
+        vector<Final> finales;
+        for (const Induccion &induccion : inducciones) {
+            bool viva = vivacidad.vivoAlEntrar(cfg, salida, induccion.variable);
+            if (!viva && &induccion != control) {
+                continue;
+            }
+            __int128 valor = vueltas * induccion.paso;
+            int64_t inicial;
+            bool absoluto = valorInicial(cfg, bucle.preencabezado, induccion.variable, inicial);
+            if (absoluto) {
+                valor += inicial;
+            }
+            if (valor < INT64_MIN || valor > INT64_MAX) {
+                return false;
+            }
+            if (viva) {
+                finales.push_back({induccion.variable, static_cast<int64_t>(valor), absoluto});
+            }
+        }
+
+        for (const Final &final : finales) {
+            if (final.absoluto) {
+                cfg.agregarAlFinal(bucle.preencabezado, OpTAC::ASIGNAR, final.variable, codigo.constanteEntera(final.valor));
+            } else {
+                cfg.agregarAlFinal(bucle.preencabezado, OpTAC::SUMAR, final.variable, final.variable, codigo.constanteEntera(final.valor));
+            }
+        }
+        cfg.redirigirArista(bucle.preencabezado, bucle.cabecera, salida);
+        return true;
+    }
+};
+
+// Pasadas sobre el CFG para cada nivel de optimización
+void registrarPasadas(AdministradorPasadas &pasadas, int nivel) {
+    if (nivel >= 1) {
+        pasadas.agregar<ConstruirSSA>();
+        pasadas.agregar<PropagacionConstantes>();
+        pasadas.agregar<DestruirSSA>();
+        pasadas.agregar<FusionarCopias>();
+        pasadas.agregar<LimpiarCFG>();
+        pasadas.agregar<EliminarAlmacenamientosMuertos>();
+        pasadas.agregar<LimpiarCFG>();
+    }
+    if (nivel >= 2) {
+        // Optimizaciones de bucles; luego otra ronda de constantes sobre lo que dejaron
+        pasadas.agregar<MoverInvariantes>();
+        pasadas.agregar<ReducirFuerza>();
+        pasadas.agregar<ValorFinalInduccion>();
+        pasadas.agregar<LimpiarCFG>();
+        pasadas.agregar<ConstruirSSA>();
+        pasadas.agregar<PropagacionConstantes>();
+        pasadas.agregar<DestruirSSA>();
+        pasadas.agregar<FusionarCopias>();
+        pasadas.agregar<EliminarAlmacenamientosMuertos>();
+        pasadas.agregar<LimpiarCFG>();
+    }
+}
+
+// Instrucciones ejecutables de un programa, sin contar las etiquetas
+size_t contarInstrucciones(const CodigoTAC &codigo) {
+    return codigo.size() - count(codigo.ops.begin(), codigo.ops.end(), OpTAC::ETIQUETA);
+}
+
+// ---------------------------------------------------------------------------
+// Máquina virtual de registros
+// ---------------------------------------------------------------------------
+
+// Códigos del bytecode. Los quince primeros coinciden con OpTAC para traducir sin
+// tabla; los saltos con comparación fusionan `t = a REL b; if t goto L` en una sola
+// instrucción cuando t no se usa en otro lado.
+enum class OpVM : uint8_t {
+    MOVER, SUMAR, RESTAR, MULTIPLICAR, DIVIDIR, MODULO, DESPLAZAR,
+    MENOR, MENOR_IGUAL, MAYOR, MAYOR_IGUAL, IGUAL, DISTINTO, NEGAR, NO,
+    SALTAR, SALTAR_SI, SALTAR_SI_NO,
+    SALTAR_MENOR, SALTAR_MENOR_IGUAL, SALTAR_MAYOR, SALTAR_MAYOR_IGUAL, SALTAR_IGUAL, SALTAR_DISTINTO,
+    RETORNAR, FIN
+};
+
+static_assert(static_cast<int>(OpVM::NO) == static_cast<int>(OpTAC::NO), "OpVM debe empezar como OpTAC");
+
+// Instrucción de tamaño fijo: a es el destino (o el salto), b y c los registros fuente
+struct InstruccionVM {
+    OpVM op;
+    uint32_t a, b, c;
+};
+
+static_assert(sizeof(InstruccionVM) == 16, "Las instrucciones del bytecode ocupan 16 bytes");
+
+// Programa listo para ejecutar. Cada temporal, variable y constante del TAC tiene su
+// registro; los de las constantes arrancan con su valor y el resto en 0.
+struct ProgramaVM {
+    vector<InstruccionVM> codigo;
+    vector<Constante> registrosIniciales;   // un valor en tiempo de ejecución es un par entero/cadena
+    vector<pair<IdNombre, uint32_t>> variables;   // registro de cada variable, por número de registro
+    vector<uint32_t> registroDeConstante;         // por posición en la tabla de constantes del TAC
+
+    static ProgramaVM compilar(const CodigoTAC &tac) {
+        ProgramaVM programa;
+        programa.registrosIniciales.push_back({0, N_VACIO});   // el registro 0 siempre vale 0 y sustituye a los operandos vacíos
+        unordered_map<uint32_t, uint32_t> registroDe;
+        auto registro = [&](Operando o) -> uint32_t {
+            if (o.vacio()) {
+                return 0;
+            }
+            auto [it, nuevo] = registroDe.try_emplace(o.bits, static_cast<uint32_t>(programa.registrosIniciales.size()));
+            if (nuevo) {
+                programa.registrosIniciales.push_back(o.clase() == Operando::CONSTANTE ? tac.constantes[o.indice()] : Constante{0, N_VACIO});
+            }
+            return it->second;
+        };
+
+        // Lecturas de cada nombre, para saber qué comparaciones se pueden fusionar con su salto
+        unordered_map<uint32_t, uint32_t> lecturas;
+        for (size_t i = 0; i < tac.size(); i++) {
+            if (tac.ops[i] == OpTAC::ETIQUETA || tac.ops[i] == OpTAC::SALTAR) continue;
+            if (!tac.args1[i].vacio()) lecturas[tac.args1[i].bits]++;
+            if (!tac.args2[i].vacio()) lecturas[tac.args2[i].bits]++;
+        }
+
+        vector<uint32_t> posicionEtiqueta(tac.etiquetas, UINT32_MAX);
+        vector<pair<size_t, uint32_t>> saltosPendientes;   // (instrucción, etiqueta)
+        auto saltar = [&](OpVM op, Operando etiqueta, uint32_t b = 0, uint32_t c = 0) {
+            saltosPendientes.push_back({programa.codigo.size(), etiqueta.indice()});
+            programa.codigo.push_back({op, 0, b, c});
+        };
+
+        for (size_t i = 0; i < tac.size(); i++) {
+            OpTAC op = tac.ops[i];
+            switch (op) {
+                case OpTAC::ETIQUETA:
+                    posicionEtiqueta[tac.destinos[i].indice()] = static_cast<uint32_t>(programa.codigo.size());
+                    break;
+                case OpTAC::SALTAR:
+                    saltar(OpVM::SALTAR, tac.destinos[i]);
+                    break;
+                case OpTAC::SALTAR_SI:
+                case OpTAC::SALTAR_SI_NO:
+                    saltar(op == OpTAC::SALTAR_SI ? OpVM::SALTAR_SI : OpVM::SALTAR_SI_NO, tac.destinos[i], registro(tac.args1[i]));
+                    break;
+                case OpTAC::RETORNAR:
+                    programa.codigo.push_back({OpVM::RETORNAR, 0, registro(tac.args1[i]), 0});
+                    break;
+                default: {
+                    bool esRelacion = op >= OpTAC::MENOR && op <= OpTAC::DISTINTO;
+                    bool fusionable = esRelacion && i + 1 < tac.size()
+                        && (tac.ops[i + 1] == OpTAC::SALTAR_SI || tac.ops[i + 1] == OpTAC::SALTAR_SI_NO)
+                        && tac.args1[i + 1] == tac.destinos[i] && lecturas[tac.destinos[i].bits] == 1;
+                    if (fusionable) {
+                        // ifFalse (a < b) es saltar si a >= b
+                        OpTAC relacion = tac.ops[i + 1] == OpTAC::SALTAR_SI ? op : relacionContraria(op);
+                        OpVM salto = static_cast<OpVM>(static_cast<int>(OpVM::SALTAR_MENOR) + static_cast<int>(relacion) - static_cast<int>(OpTAC::MENOR));
+                        saltar(salto, tac.destinos[i + 1], registro(tac.args1[i]), registro(tac.args2[i]));
+                        i++;
+                        break;
+                    }
+                    uint32_t a = registro(tac.destinos[i]);
+                    programa.codigo.push_back({static_cast<OpVM>(op), a, registro(tac.args1[i]), registro(tac.args2[i])});
+                    break;
+                }
+            }
+        }
+        programa.codigo.push_back({OpVM::FIN, 0, 0, 0});
+        for (auto [instruccion, etiqueta] : saltosPendientes) {
+            programa.codigo[instruccion].a = posicionEtiqueta[etiqueta];
+        }
+        programa.registroDeConstante.assign(tac.constantes.size(), UINT32_MAX);
+        for (auto [bits, r] : registroDe) {
+            Operando o{bits};
+            if (o.clase() == Operando::VARIABLE) programa.variables.push_back({o.indice(), r});
+            if (o.clase() == Operando::CONSTANTE) programa.registroDeConstante[o.indice()] = r;
+        }
+        sort(programa.variables.begin(), programa.variables.end(), [](auto x, auto y) { return x.second < y.second; });
+        return programa;
+    }
+
+private:
+    static OpTAC relacionContraria(OpTAC relacion) {
+        switch (relacion) {
+            case OpTAC::MENOR: return OpTAC::MAYOR_IGUAL;
+            case OpTAC::MENOR_IGUAL: return OpTAC::MAYOR;
+            case OpTAC::MAYOR: return OpTAC::MENOR_IGUAL;
+            case OpTAC::MAYOR_IGUAL: return OpTAC::MENOR;
+            case OpTAC::IGUAL: return OpTAC::DISTINTO;
+            default: return OpTAC::IGUAL;
+        }
+    }
+};
+
+// Error de ejecución de una división; el código nativo informa el mismo
+constexpr const char *ERROR_DIVISION = "división por cero o fuera de rango";
+
+// Resultado de ejecutar main(): el valor devuelto o el error que cortó la ejecución
+struct ResultadoVM {
+    bool ok = true;
+    Constante valor{0, N_VACIO};
+    string error;
+    uint64_t instrucciones = 0;   // solo si se pidió contarlas
+};
+
+// Escribe un valor como lo haría el programa: enteros en decimal, cadenas con comillas
+void imprimirValor(ostream &salida, const Constante &valor) {
+    if (valor.cadena != N_VACIO) {
+        salida << nombreDe(valor.cadena);
+    } else {
+        salida << valor.entero;
+    }
+}
+
+// Intérprete del bytecode. Con GCC y Clang despacha con goto computado: cada
+// instrucción salta directo a la siguiente, sin volver a un switch central, y el
+// predictor de saltos aprende cada transición por separado.
+class MaquinaVirtual {
+public:
+    explicit MaquinaVirtual(const ProgramaVM &programa) : MaquinaVirtual(programa.codigo.data(), programa.registrosIniciales) {}
+
+    // El bytecode se ejecuta en el lugar: puede venir de un objeto proyectado en memoria
+    MaquinaVirtual(const InstruccionVM *codigo, vector<Constante> registrosIniciales)
+        : codigo(codigo), registrosIniciales(move(registrosIniciales)), registros(this->registrosIniciales.size()) {}
+
+    ResultadoVM ejecutar() { return correr<false>(); }
+    ResultadoVM ejecutarContando() { return correr<true>(); }
+
+private:
+    const InstruccionVM *codigo;
+    vector<Constante> registrosIniciales;
+    vector<Constante> registros;
+
+    // Las cadenas solo se suman (concatenan) y se comparan por igualdad
+    static bool operarCadenas(OpVM op, const Constante &a, const Constante &b, Constante &r) {
+        if (op == OpVM::SUMAR && a.cadena != N_VACIO && b.cadena != N_VACIO) {
+            auto sinComillas = [](string_view texto) {
+                return texto.size() >= 2 && texto.front() == '"' ? texto.substr(1, texto.size() - 2) : texto;
+            };
+            string unida = "\"";
+            unida.append(sinComillas(nombreDe(a.cadena))).append(sinComillas(nombreDe(b.cadena))).push_back('"');
+            r = {0, internar(unida)};
+            return true;
+        }
+        return false;
+    }
+
+    template <bool CONTAR>
+    ResultadoVM correr() {
+        copy(registrosIniciales.begin(), registrosIniciales.end(), registros.begin());
+        Constante *r = registros.data();
+        const InstruccionVM *inicio = codigo;
+        const InstruccionVM *pc = inicio;
+        ResultadoVM resultado;
+        uint64_t contador = 0;
+
+        // Aritmética con enteros de 64 bits que dan la vuelta, como la máquina
+        auto envolver = [](uint64_t valor) { return static_cast<int64_t>(valor); };
+
+#if defined(__GNUC__)
+        static const void *const despacho[] = {
+            &&op_MOVER, &&op_SUMAR, &&op_RESTAR, &&op_MULTIPLICAR, &&op_DIVIDIR, &&op_MODULO, &&op_DESPLAZAR,
+            &&op_MENOR, &&op_MENOR_IGUAL, &&op_MAYOR, &&op_MAYOR_IGUAL, &&op_IGUAL, &&op_DISTINTO, &&op_NEGAR, &&op_NO,
+            &&op_SALTAR, &&op_SALTAR_SI, &&op_SALTAR_SI_NO,
+            &&op_SALTAR_MENOR, &&op_SALTAR_MENOR_IGUAL, &&op_SALTAR_MAYOR, &&op_SALTAR_MAYOR_IGUAL, &&op_SALTAR_IGUAL, &&op_SALTAR_DISTINTO,
+            &&op_RETORNAR, &&op_FIN};
+#define CASO(nombre) op_##nombre:
+#define SIGUIENTE() do { if (CONTAR) contador++; goto *despacho[static_cast<size_t>(pc->op)]; } while (0)
+        SIGUIENTE();
+#else
+#define CASO(nombre) case OpVM::nombre:
+#define SIGUIENTE() do { if (CONTAR) contador++; goto despachar; } while (0)
+    despachar:
+        switch (pc->op) {
+#endif
+
+// Operación entera de dos registros; las cadenas van por el camino lento
+#define BINARIA(nombre, expresion)                                              \
+        CASO(nombre) {                                                          \
+            const Constante &x = r[pc->b], &y = r[pc->c];                       \
+            if (__builtin_expect((x.cadena | y.cadena) != N_VACIO, 0)) {        \
+                if (!operarCadenas(OpVM::nombre, x, y, r[pc->a])) goto error_tipos; \
+            } else {                                                            \
+                int64_t a = x.entero, b = y.entero;                             \
+                r[pc->a] = {(expresion), N_VACIO};                              \
+            }                                                                   \
+            pc++;                                                               \
+            SIGUIENTE();                                                        \
+        }
+// Salto si se cumple la relación entre dos registros enteros; las cadenas no se ordenan
+#define SALTO_RELACION(nombre, operador)                                        \
+        CASO(nombre) {                                                          \
+            const Constante &x = r[pc->b], &y = r[pc->c];                       \
+            if (__builtin_expect((x.cadena | y.cadena) != N_VACIO, 0)) goto error_tipos; \
+            pc = x.entero operador y.entero ? inicio + pc->a : pc + 1;          \
+            SIGUIENTE();                                                        \
+        }
+
+        CASO(MOVER) {
+            r[pc->a] = r[pc->b];
+            pc++;
+            SIGUIENTE();
+        }
+        BINARIA(SUMAR, envolver(static_cast<uint64_t>(a) + static_cast<uint64_t>(b)))
+        BINARIA(RESTAR, envolver(static_cast<uint64_t>(a) - static_cast<uint64_t>(b)))
+        BINARIA(MULTIPLICAR, envolver(static_cast<uint64_t>(a) * static_cast<uint64_t>(b)))
+        CASO(DIVIDIR)
+        CASO(MODULO) {
+            const Constante &x = r[pc->b], &y = r[pc->c];
+            if ((x.cadena | y.cadena) != N_VACIO) goto error_tipos;
+            if (y.entero == 0 || (x.entero == INT64_MIN && y.entero == -1)) {
+                resultado.ok = false;
+                resultado.error = ERROR_DIVISION;
+                goto terminar;
+            }
+            r[pc->a] = {pc->op == OpVM::DIVIDIR ? x.entero / y.entero : x.entero % y.entero, N_VACIO};
+            pc++;
+            SIGUIENTE();
+        }
+        BINARIA(DESPLAZAR, envolver(static_cast<uint64_t>(a) << (b & 63)))
+        BINARIA(MENOR, a < b)
+        BINARIA(MENOR_IGUAL, a <= b)
+        BINARIA(MAYOR, a > b)
+        BINARIA(MAYOR_IGUAL, a >= b)
+        CASO(IGUAL) {
+            r[pc->a] = {r[pc->b].entero == r[pc->c].entero && r[pc->b].cadena == r[pc->c].cadena, N_VACIO};
+            pc++;
+            SIGUIENTE();
+        }
+        CASO(DISTINTO) {
+            r[pc->a] = {r[pc->b].entero != r[pc->c].entero || r[pc->b].cadena != r[pc->c].cadena, N_VACIO};
+            pc++;
+            SIGUIENTE();
+        }
+        CASO(NEGAR) {
+            if (r[pc->b].cadena != N_VACIO) goto error_tipos;
+            r[pc->a] = {envolver(0 - static_cast<uint64_t>(r[pc->b].entero)), N_VACIO};
+            pc++;
+            SIGUIENTE();
+        }
+        CASO(NO) {
+            r[pc->a] = {r[pc->b].entero == 0 && r[pc->b].cadena == N_VACIO, N_VACIO};
+            pc++;
+            SIGUIENTE();
+        }
+        CASO(SALTAR) {
+            pc = inicio + pc->a;
+            SIGUIENTE();
+        }
+        CASO(SALTAR_SI) {
+            pc = r[pc->b].entero != 0 || r[pc->b].cadena != N_VACIO ? inicio + pc->a : pc + 1;
+            SIGUIENTE();
+        }
+        CASO(SALTAR_SI_NO) {
+            pc = r[pc->b].entero == 0 && r[pc->b].cadena == N_VACIO ? inicio + pc->a : pc + 1;
+            SIGUIENTE();
+        }
+        SALTO_RELACION(SALTAR_MENOR, <)
+        SALTO_RELACION(SALTAR_MENOR_IGUAL, <=)
+        SALTO_RELACION(SALTAR_MAYOR, >)
+        SALTO_RELACION(SALTAR_MAYOR_IGUAL, >=)
+        CASO(SALTAR_IGUAL) {
+            pc = r[pc->b].entero == r[pc->c].entero && r[pc->b].cadena == r[pc->c].cadena ? inicio + pc->a : pc + 1;
+            SIGUIENTE();
+        }
+        CASO(SALTAR_DISTINTO) {
+            pc = r[pc->b].entero != r[pc->c].entero || r[pc->b].cadena != r[pc->c].cadena ? inicio + pc->a : pc + 1;
+            SIGUIENTE();
+        }
+        CASO(RETORNAR) {
+            resultado.valor = r[pc->b];
+            goto terminar;
+        }
+        CASO(FIN) {
+            goto terminar;
+        }
+#if !defined(__GNUC__)
+        }
+#endif
+#undef CASO
+#undef SIGUIENTE
+#undef BINARIA
+#undef SALTO_RELACION
+
+    error_tipos:
+        resultado.ok = false;
+        resultado.error = "operación no válida entre una cadena y otro valor";
+    terminar:
+        resultado.instrucciones = contador;
+        return resultado;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Backend x86-64: asignación de registros por barrido lineal y emisión
+// ---------------------------------------------------------------------------
+
+// Registros de propósito general en el orden de su codificación
+enum class RegistroX86 : uint8_t { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+// Condiciones de jcc y setcc; el valor es el nibble de la codificación (jcc corto = 0x70 + c)
+enum class CondicionX86 : uint8_t { IGUAL = 0x4, DISTINTO = 0x5, MENOR = 0xC, MAYOR_IGUAL = 0xD, MENOR_IGUAL = 0xE, MAYOR = 0xF };
+
+// Operaciones de dos operandos cuyo destino es un registro
+enum class OperacionX86 : uint8_t { SUMAR, RESTAR, MULTIPLICAR, COMPARAR };
+
+// Dónde está un valor: en un registro, en una ranura de la pila relativa a rbp, o es
+// un inmediato. Las cadenas son constantes del programa y se cargan por su dirección.
+struct UbicacionX86 {
+    enum Tipo : uint8_t { REGISTRO, PILA, INMEDIATO, CADENA };
+
+    Tipo tipo = INMEDIATO;
+    RegistroX86 registro = RegistroX86::RAX;
+    int32_t desplazamiento = 0;
+    int64_t valor = 0;   // el inmediato, o la posición de la cadena en la tabla de constantes
+
+    static UbicacionX86 enRegistro(RegistroX86 r) { return {REGISTRO, r, 0, 0}; }
+    static UbicacionX86 enPila(int32_t desplazamiento) { return {PILA, RegistroX86::RAX, desplazamiento, 0}; }
+    static UbicacionX86 inmediato(int64_t valor) { return {INMEDIATO, RegistroX86::RAX, 0, valor}; }
+    static UbicacionX86 cadena(uint32_t constante) { return {CADENA, RegistroX86::RAX, 0, constante}; }
+
+    bool es(RegistroX86 r) const { return tipo == REGISTRO && registro == r; }
+    bool cabeEn32() const { return tipo == INMEDIATO && valor >= INT32_MIN && valor <= INT32_MAX; }
+};
+
+// Recibe las instrucciones ya seleccionadas. Las formas válidas son las de la máquina:
+// mover admite registro <- cualquiera y pila <- registro o inmediato de 32 bits; la
+// fuente de operar es un registro, la pila o un inmediato de 32 bits.
+class EmisorX86 {
+public:
+    virtual ~EmisorX86() = default;
+
+    virtual void prologo(const vector<RegistroX86> &guardados, uint32_t marco) = 0;
+    virtual void epilogo(const vector<RegistroX86> &guardados) = 0;
+    virtual void etiqueta(uint32_t numero) = 0;
+    virtual void mover(UbicacionX86 destino, UbicacionX86 fuente) = 0;
+    virtual void operar(OperacionX86 op, RegistroX86 destino, UbicacionX86 fuente) = 0;
+    virtual void desplazar(RegistroX86 destino, UbicacionX86 cantidad) = 0;   // inmediato o rcx
+    virtual void negar(RegistroX86 destino) = 0;
+    virtual void dividir(UbicacionX86 divisor) = 0;                            // rdx:rax / divisor
+    virtual void guardarEn(RegistroX86 direccion, int32_t valor) = 0;          // QWORD [direccion] = valor
+    virtual void fijarSi(CondicionX86 condicion, RegistroX86 destino) = 0;    // destino = 0 o 1
+    virtual void saltar(uint32_t numero) = 0;
+    virtual void saltarSi(CondicionX86 condicion, uint32_t numero) = 0;
+};
+
+// Traduce el TAC optimizado a una función x86-64 que sigue la convención de System V
+// y devuelve en rax el valor de `return`. Los nombres viven en registros según un
+// barrido lineal sobre intervalos de vida; los que no caben van a la pila. rax, rcx,
+// rdx y r11 quedan libres para la selección de instrucciones (división, desplazamientos
+// y operandos que no pueden ir en memoria). La función recibe un `int64_t *fallo`: una
+// división por 0 o de INT64_MIN entre -1 escribe 1 ahí y vuelve, como el error de la
+// máquina virtual, en lugar de la excepción del procesador.
+class GeneradorX86 {
+public:
+    string error;
+    bool devuelveCadena = false;
+    size_t nombresEnRegistro = 0;
+    size_t nombresEnPila = 0;
+
+    explicit GeneradorX86(const CodigoTAC &tac) : cfg(CFG::construir(tac)), codigo(cfg.codigo) {}
+
+    // Falla, dejando el motivo en `error`, si el programa hace con cadenas algo que el
+    // código nativo no sabe hacer (concatenar, comparar por orden)
+    bool generar(EmisorX86 &salida) {
+        emisor = &salida;
+        if (!inferirTipos()) {
+            return false;
+        }
+        asignarRegistros();
+
+        // Registros que la convención exige preservar; en Windows también rsi y rdi
+        vector<RegistroX86> guardados;
+        for (RegistroX86 r : {RegistroX86::RBX, RegistroX86::R12, RegistroX86::R13, RegistroX86::R14, RegistroX86::R15,
+#ifdef _WIN32
+                              RegistroX86::RSI, RegistroX86::RDI
+#endif
+             }) {
+            if (usados[static_cast<size_t>(r)]) guardados.push_back(r);
+        }
+        // Las ranuras de la pila van debajo de los registros guardados; si alguna división
+        // puede fallar, la última guarda el puntero `fallo` recibido como argumento
+        int32_t base = -8 * static_cast<int32_t>(guardados.size() + 1);
+        for (UbicacionX86 &u : ubicaciones) {
+            if (u.tipo == UbicacionX86::PILA) u.desplazamiento = base - 8 * u.desplazamiento;
+        }
+        bool conFallo = false;
+        for (uint32_t b = 0; b < cfg.bloques.size() && !conFallo; b++) {
+            if (!cfg.alcanzable(b)) continue;
+            for (uint32_t i : cfg.bloques[b].instrucciones) {
+                conFallo |= puedeFallar(codigo, i);
+            }
+        }
+        UbicacionX86 punteroFallo = UbicacionX86::enPila(base - 8 * static_cast<int32_t>(nombresEnPila));
+        emisor->prologo(guardados, static_cast<uint32_t>(8 * (nombresEnPila + conFallo)));
+        if (conFallo) emisor->mover(punteroFallo, UbicacionX86::enRegistro(ARGUMENTO));
+
+        // Lo que se lee antes de escribirse arranca en 0, como en la máquina virtual
+        Vivacidad::Conjunto &alEntrar = vivacidad->entrada[0];
+        for (uint32_t r = 0; r < ubicaciones.size(); r++) {
+            if (Vivacidad::contiene(alEntrar, r)) emisor->mover(ubicaciones[r], UbicacionX86::inmediato(0));
+        }
+
+        // Si el código termina en un return, cae solo en el epílogo. Las etiquetas que no
+        // son bloques se numeran después de ellos.
+        uint32_t salidaFuncion = static_cast<uint32_t>(cfg.bloques.size());
+        etiquetaFallo = salidaFuncion + 1;
+        siguienteEtiqueta = salidaFuncion + 2;
+        ultimaInstruccion = CFG::NINGUNO;
+        for (uint32_t b = 0; b < cfg.bloques.size(); b++) {
+            if (!cfg.alcanzable(b)) continue;
+            ultimaInstruccion = cfg.bloques[b].instrucciones.empty() ? CFG::NINGUNO : cfg.bloques[b].instrucciones.back();
+        }
+        for (uint32_t b = 0; b < cfg.bloques.size(); b++) {
+            if (!cfg.alcanzable(b)) continue;
+            emisor->etiqueta(b);
+            const vector<uint32_t> &instrucciones = cfg.bloques[b].instrucciones;
+            for (size_t k = 0; k < instrucciones.size(); k++) {
+                uint32_t i = instrucciones[k];
+                if (k + 1 < instrucciones.size() && fusionable(i, instrucciones[k + 1])) {
+                    uint32_t salto = instrucciones[++k];
+                    comparar(codigo.args1[i], codigo.args2[i]);
+                    OpTAC relacion = codigo.ops[salto] == OpTAC::SALTAR_SI ? codigo.ops[i] : relacionContraria(codigo.ops[i]);
+                    emisor->saltarSi(condicion(relacion), codigo.destinos[salto].indice());
+                    continue;
+                }
+                seleccionar(i, salidaFuncion);
+            }
+        }
+        // Sin return explícito main() devuelve 0
+        if (ultimaInstruccion == CFG::NINGUNO || codigo.ops[ultimaInstruccion] != OpTAC::RETORNAR) {
+            emisor->mover(UbicacionX86::enRegistro(RegistroX86::RAX), UbicacionX86::inmediato(0));
+        }
+        emisor->etiqueta(salidaFuncion);
+        emisor->epilogo(guardados);
+        if (conFallo) {
+            emisor->etiqueta(etiquetaFallo);
+            emisor->mover(UbicacionX86::enRegistro(RegistroX86::R11), punteroFallo);
+            emisor->guardarEn(RegistroX86::R11, 1);
+            emisor->saltar(salidaFuncion);
+        }
+        return true;
+    }
+
+private:
+    // Tipos de los nombres: un mapa de bits para detectar los que mezclan
+    static constexpr uint8_t ENTERO = 1, CADENA = 2;
+
+    // Registro del primer argumento entero
+#ifdef _WIN32
+    static constexpr RegistroX86 ARGUMENTO = RegistroX86::RCX;
+#else
+    static constexpr RegistroX86 ARGUMENTO = RegistroX86::RDI;
+#endif
+
+    CFG cfg;
+    const CodigoTAC &codigo;
+    EmisorX86 *emisor = nullptr;
+    unique_ptr<Vivacidad> vivacidad;
+    vector<uint8_t> tipos;
+    vector<UbicacionX86> ubicaciones;   // por ranura de nombre
+    vector<uint32_t> lecturas;          // por ranura de nombre
+    array<bool, 16> usados{};
+    uint32_t ultimaInstruccion = 0;
+    uint32_t etiquetaFallo = 0;
+    uint32_t siguienteEtiqueta = 0;
+
+    uint8_t tipoDe(Operando o) const {
+        if (o.vacio()) return ENTERO;
+        if (o.clase() == Operando::CONSTANTE) return codigo.constantes[o.indice()].cadena != N_VACIO ? CADENA : ENTERO;
+        return tipos[cfg.ranura(o)];
+    }
+
+    bool inferirTipos() {
+        tipos.assign(cfg.numeroRanuras(), 0);
+        lecturas.assign(cfg.numeroRanuras(), 0);
+        for (size_t i = 0; i < codigo.size(); i++) {
+            for (Operando o : {codigo.args1[i], codigo.args2[i]}) {
+                if (CFG::esNombre(o)) lecturas[cfg.ranura(o)]++;
+            }
+        }
+        // Las copias y las sumas (que concatenan) propagan el tipo; se repite hasta el
+        // punto fijo porque puede haber ciclos
+        bool cambio = true;
+        while (cambio) {
+            cambio = false;
+            for (size_t i = 0; i < codigo.size(); i++) {
+                Operando destino = codigo.destinos[i];
+                if (!CFG::esNombre(destino) || esTerminador(codigo.ops[i])) continue;
+                OpTAC op = codigo.ops[i];
+                uint8_t tipo = op == OpTAC::ASIGNAR ? tipoDe(codigo.args1[i])
+                             : op == OpTAC::SUMAR ? tipoDe(codigo.args1[i]) | tipoDe(codigo.args2[i])
+                             : ENTERO;
+                uint8_t &actual = tipos[cfg.ranura(destino)];
+                if ((actual | tipo) != actual) {
+                    actual |= tipo;
+                    cambio = true;
+                }
+            }
+        }
+
+        uint8_t retorno = 0;
+        for (size_t i = 0; i < codigo.size(); i++) {
+            OpTAC op = codigo.ops[i];
+            if (CFG::esNombre(codigo.destinos[i]) && tipoDe(codigo.destinos[i]) == (ENTERO | CADENA)) {
+                return fallar("el nombre ", codigo.destinos[i], " guarda a veces un entero y a veces una cadena");
+            }
+            bool soloEnteros = op != OpTAC::ASIGNAR && op != OpTAC::IGUAL && op != OpTAC::DISTINTO && op != OpTAC::NO
+                && op != OpTAC::SALTAR_SI && op != OpTAC::SALTAR_SI_NO && op != OpTAC::RETORNAR;
+            for (Operando o : {codigo.args1[i], codigo.args2[i]}) {
+                if (soloEnteros && (tipoDe(o) & CADENA)) {
+                    return fallar("la operación sobre ", o, " no está soportada con cadenas en código nativo");
+                }
+            }
+            if (op == OpTAC::RETORNAR) retorno |= tipoDe(codigo.args1[i]);
+        }
+        if (retorno == (ENTERO | CADENA)) {
+            error = "main() devuelve a veces un entero y a veces una cadena";
+            return false;
+        }
+        devuelveCadena = retorno == CADENA;
+        return true;
+    }
+
+    bool fallar(const char *antes, Operando o, const char *despues) {
+        ostringstream texto;
+        texto << antes;
+        imprimirOperando(texto, codigo, o);
+        texto << despues;
+        error = texto.str();
+        return false;
+    }
+
+    // Barrido lineal de Poletto y Sarkar. El intervalo de un nombre va de su primera a su
+    // última aparición en el orden del código, ampliado a los bordes de cada bloque en
+    // el que está vivo al entrar o al salir; así cubre también los bucles.
+    void asignarRegistros() {
+        vivacidad = make_unique<Vivacidad>(cfg);
+        size_t ranuras = cfg.numeroRanuras();
+        vector<uint32_t> inicio(ranuras, UINT32_MAX), fin(ranuras, 0);
+        auto extender = [&](uint32_t r, uint32_t posicion) {
+            inicio[r] = min(inicio[r], posicion);
+            fin[r] = max(fin[r], posicion);
+        };
+        auto extenderConjunto = [&](const Vivacidad::Conjunto &conjunto, uint32_t posicion) {
+            for (size_t w = 0; w < conjunto.size(); w++) {
+                for (uint64_t bits = conjunto[w]; bits; bits &= bits - 1) {
+                    extender(static_cast<uint32_t>(w * 64 + __builtin_ctzll(bits)), posicion);
+                }
+            }
+        };
+        extenderConjunto(vivacidad->entrada[0], 0);
+        for (uint32_t b = 0; b < cfg.bloques.size(); b++) {
+            const vector<uint32_t> &instrucciones = cfg.bloques[b].instrucciones;
+            if (!cfg.alcanzable(b) || instrucciones.empty()) continue;
+            extenderConjunto(vivacidad->entrada[b], instrucciones.front());
+            extenderConjunto(vivacidad->salida[b], instrucciones.back());
+            for (uint32_t i : instrucciones) {
+                for (Operando o : {codigo.destinos[i], codigo.args1[i], codigo.args2[i]}) {
+                    if (CFG::esNombre(o)) extender(cfg.ranura(o), i);
+                }
+            }
+        }
+
+        vector<uint32_t> orden;
+        for (uint32_t r = 0; r < ranuras; r++) {
+            if (inicio[r] != UINT32_MAX) orden.push_back(r);
+        }
+        sort(orden.begin(), orden.end(), [&](uint32_t x, uint32_t y) { return inicio[x] < inicio[y]; });
+
+        // Primero los que no hay que guardar en el prólogo
+        vector<RegistroX86> libres = {RegistroX86::R15, RegistroX86::R14, RegistroX86::R13, RegistroX86::R12, RegistroX86::RBX,
+                                      RegistroX86::R10, RegistroX86::R9, RegistroX86::R8, RegistroX86::RDI, RegistroX86::RSI};
+        ubicaciones.assign(ranuras, UbicacionX86::inmediato(0));
+        vector<uint32_t> activos;   // ordenados por fin
+        auto aPila = [&](uint32_t r) {
+            ubicaciones[r] = UbicacionX86::enPila(static_cast<int32_t>(nombresEnPila++));   // se reubica al conocer el marco
+        };
+        for (uint32_t r : orden) {
+            while (!activos.empty() && fin[activos.front()] < inicio[r]) {
+                libres.push_back(ubicaciones[activos.front()].registro);
+                activos.erase(activos.begin());
+            }
+            if (libres.empty()) {
+                // Se derrama el que termina más tarde: libera el registro por más tiempo
+                uint32_t ultimo = activos.back();
+                if (fin[ultimo] <= fin[r]) {
+                    aPila(r);
+                    continue;
+                }
+                ubicaciones[r] = ubicaciones[ultimo];
+                aPila(ultimo);
+                activos.pop_back();
+            } else {
+                ubicaciones[r] = UbicacionX86::enRegistro(libres.back());
+                libres.pop_back();
+            }
+            usados[static_cast<size_t>(ubicaciones[r].registro)] = true;
+            activos.insert(upper_bound(activos.begin(), activos.end(), r, [&](uint32_t x, uint32_t y) { return fin[x] < fin[y]; }), r);
+        }
+        nombresEnRegistro = orden.size() - nombresEnPila;
+    }
+
+    UbicacionX86 ubicacion(Operando o) const {
+        if (o.vacio()) return UbicacionX86::inmediato(0);
+        if (o.clase() == Operando::CONSTANTE) {
+            const Constante &c = codigo.constantes[o.indice()];
+            return c.cadena != N_VACIO ? UbicacionX86::cadena(o.indice()) : UbicacionX86::inmediato(c.entero);
+        }
+        return ubicaciones[cfg.ranura(o)];
+    }
+
+    void cargar(RegistroX86 r, Operando o) {
+        UbicacionX86 u = ubicacion(o);
+        if (!u.es(r)) emisor->mover(UbicacionX86::enRegistro(r), u);
+    }
+
+    // Operando fuente para operar: lo que no se puede codificar directo pasa por `auxiliar`
+    UbicacionX86 fuente(Operando o, RegistroX86 auxiliar) {
+        UbicacionX86 u = ubicacion(o);
+        if (u.tipo == UbicacionX86::CADENA || (u.tipo == UbicacionX86::INMEDIATO && !u.cabeEn32())) {
+            emisor->mover(UbicacionX86::enRegistro(auxiliar), u);
+            return UbicacionX86::enRegistro(auxiliar);
+        }
+        return u;
+    }
+
+    void guardar(Operando destino, RegistroX86 r) {
+        UbicacionX86 u = ubicacion(destino);
+        if (!u.es(r)) emisor->mover(u, UbicacionX86::enRegistro(r));
+    }
+
+    // Registro donde calcular `destino`: el suyo, salvo que esté en la pila o que sea el
+    // del segundo operando, que se pisaría al cargar el primero
+    RegistroX86 registroPara(Operando destino, Operando segundo) const {
+        UbicacionX86 u = ubicacion(destino);
+        if (u.tipo == UbicacionX86::REGISTRO && !ubicacion(segundo).es(u.registro)) return u.registro;
+        return RegistroX86::RAX;
+    }
+
+    // cmp a, b con a en un registro; devuelve ese registro
+    RegistroX86 comparar(Operando a, Operando b) {
+        UbicacionX86 izquierdo = ubicacion(a);
+        RegistroX86 r = izquierdo.tipo == UbicacionX86::REGISTRO ? izquierdo.registro : RegistroX86::R11;
+        cargar(r, a);
+        emisor->operar(OperacionX86::COMPARAR, r, fuente(b, RegistroX86::RAX));
+        return r;
+    }
+
+    bool fusionable(uint32_t i, uint32_t siguiente) const {
+        OpTAC op = codigo.ops[i];
+        return op >= OpTAC::MENOR && op <= OpTAC::DISTINTO
+            && (codigo.ops[siguiente] == OpTAC::SALTAR_SI || codigo.ops[siguiente] == OpTAC::SALTAR_SI_NO)
+            && codigo.args1[siguiente] == codigo.destinos[i] && CFG::esNombre(codigo.destinos[i])
+            && lecturas[cfg.ranura(codigo.destinos[i])] == 1;
+    }
+
+    void seleccionar(uint32_t i, uint32_t salidaFuncion) {
+        OpTAC op = codigo.ops[i];
+        Operando d = codigo.destinos[i], a = codigo.args1[i], b = codigo.args2[i];
+        switch (op) {
+            case OpTAC::ASIGNAR: {
+                UbicacionX86 destino = ubicacion(d), valor = ubicacion(a);
+                if (destino.tipo == UbicacionX86::REGISTRO || valor.tipo == UbicacionX86::REGISTRO || valor.cabeEn32()) {
+                    if (!(destino.tipo == valor.tipo && destino.registro == valor.registro && destino.desplazamiento == valor.desplazamiento)) {
+                        emisor->mover(destino, valor);
+                    }
+                } else {
+                    cargar(RegistroX86::RAX, a);
+                    guardar(d, RegistroX86::RAX);
+                }
+                break;
+            }
+            case OpTAC::SUMAR:
+            case OpTAC::RESTAR:
+            case OpTAC::MULTIPLICAR: {
+                RegistroX86 r = registroPara(d, b);
+                cargar(r, a);
+                OperacionX86 operacion = op == OpTAC::SUMAR ? OperacionX86::SUMAR : op == OpTAC::RESTAR ? OperacionX86::RESTAR : OperacionX86::MULTIPLICAR;
+                emisor->operar(operacion, r, fuente(b, RegistroX86::R11));
+                guardar(d, r);
+                break;
+            }
+            case OpTAC::DIVIDIR:
+            case OpTAC::MODULO: {
+                // idiv divide rdx:rax; el cociente queda en rax y el resto en rdx
+                cargar(RegistroX86::RAX, a);
+                UbicacionX86 divisor = ubicacion(b);
+                if (puedeFallar(codigo, i)) {
+                    // Antes de idiv: un divisor 0, o -1 con el dividendo en INT64_MIN, van al error
+                    RegistroX86 r11 = RegistroX86::R11;
+                    if (!divisor.es(r11)) emisor->mover(UbicacionX86::enRegistro(r11), divisor);
+                    divisor = UbicacionX86::enRegistro(r11);
+                    uint32_t dividir = siguienteEtiqueta++;
+                    emisor->operar(OperacionX86::COMPARAR, r11, UbicacionX86::inmediato(0));
+                    emisor->saltarSi(CondicionX86::IGUAL, etiquetaFallo);
+                    emisor->operar(OperacionX86::COMPARAR, r11, UbicacionX86::inmediato(-1));
+                    emisor->saltarSi(CondicionX86::DISTINTO, dividir);
+                    emisor->mover(UbicacionX86::enRegistro(RegistroX86::RDX), UbicacionX86::inmediato(INT64_MIN));
+                    emisor->operar(OperacionX86::COMPARAR, RegistroX86::RAX, UbicacionX86::enRegistro(RegistroX86::RDX));
+                    emisor->saltarSi(CondicionX86::IGUAL, etiquetaFallo);
+                    emisor->etiqueta(dividir);
+                } else if (divisor.tipo == UbicacionX86::INMEDIATO || divisor.tipo == UbicacionX86::CADENA) {
+                    emisor->mover(UbicacionX86::enRegistro(RegistroX86::R11), divisor);
+                    divisor = UbicacionX86::enRegistro(RegistroX86::R11);
+                }
+                emisor->dividir(divisor);
+                guardar(d, op == OpTAC::DIVIDIR ? RegistroX86::RAX : RegistroX86::RDX);
+                break;
+            }
+            case OpTAC::DESPLAZAR: {
+                UbicacionX86 cantidad = ubicacion(b);
+                if (cantidad.tipo == UbicacionX86::INMEDIATO) {
+                    cantidad.valor &= 63;
+                } else {
+                    cargar(RegistroX86::RCX, b);
+                    cantidad = UbicacionX86::enRegistro(RegistroX86::RCX);
+                }
+                RegistroX86 r = registroPara(d, b);
+                cargar(r, a);
+                emisor->desplazar(r, cantidad);
+                guardar(d, r);
+                break;
+            }
+            case OpTAC::MENOR:
+            case OpTAC::MENOR_IGUAL:
+            case OpTAC::MAYOR:
+            case OpTAC::MAYOR_IGUAL:
+            case OpTAC::IGUAL:
+            case OpTAC::DISTINTO:
+            case OpTAC::NO: {
+                // !a es a == 0
+                comparar(a, op == OpTAC::NO ? Operando{} : b);
+                RegistroX86 r = registroPara(d, {});
+                emisor->fijarSi(condicion(op == OpTAC::NO ? OpTAC::IGUAL : op), r);
+                guardar(d, r);
+                break;
+            }
+            case OpTAC::NEGAR: {
+                RegistroX86 r = registroPara(d, {});
+                cargar(r, a);
+                emisor->negar(r);
+                guardar(d, r);
+                break;
+            }
+            case OpTAC::SALTAR:
+                emisor->saltar(d.indice());
+                break;
+            case OpTAC::SALTAR_SI:
+            case OpTAC::SALTAR_SI_NO: {
+                UbicacionX86 valor = ubicacion(a);
+                if (valor.tipo == UbicacionX86::INMEDIATO || valor.tipo == UbicacionX86::CADENA) {
+                    // Condición constante: salta siempre o nunca
+                    bool verdadero = valor.tipo == UbicacionX86::CADENA || valor.valor != 0;
+                    if (verdadero == (op == OpTAC::SALTAR_SI)) emisor->saltar(d.indice());
+                    break;
+                }
+                comparar(a, Operando{});
+                emisor->saltarSi(op == OpTAC::SALTAR_SI ? CondicionX86::DISTINTO : CondicionX86::IGUAL, d.indice());
+                break;
+            }
+            case OpTAC::RETORNAR:
+                cargar(RegistroX86::RAX, a);
+                if (i != ultimaInstruccion) emisor->saltar(salidaFuncion);
+                break;
+            case OpTAC::ETIQUETA:
+                break;
+        }
+    }
+
+    static CondicionX86 condicion(OpTAC relacion) {
+        switch (relacion) {
+            case OpTAC::MENOR: return CondicionX86::MENOR;
+            case OpTAC::MENOR_IGUAL: return CondicionX86::MENOR_IGUAL;
+            case OpTAC::MAYOR: return CondicionX86::MAYOR;
+            case OpTAC::MAYOR_IGUAL: return CondicionX86::MAYOR_IGUAL;
+            case OpTAC::IGUAL: return CondicionX86::IGUAL;
+            default: return CondicionX86::DISTINTO;
+        }
+    }
+
+    static OpTAC relacionContraria(OpTAC relacion) {
+        switch (relacion) {
+            case OpTAC::MENOR: return OpTAC::MAYOR_IGUAL;
+            case OpTAC::MENOR_IGUAL: return OpTAC::MAYOR;
+            case OpTAC::MAYOR: return OpTAC::MENOR_IGUAL;
+            case OpTAC::MAYOR_IGUAL: return OpTAC::MENOR;
+            case OpTAC::IGUAL: return OpTAC::DISTINTO;
+            default: return OpTAC::IGUAL;
+        }
+    }
+};
+
+// Emisor de ensamblador GNU con sintaxis Intel. El archivo completo trae la función
+// del programa, un main() que imprime su resultado con printf y las cadenas en .rodata;
+// se enlaza con `cc archivo.s -o programa`.
+class EmisorGAS : public EmisorX86 {
+public:
+    size_t instrucciones = 0;
+
+    void prologo(const vector<RegistroX86> &guardados, uint32_t marco) override {
+        instruccion("push", "rbp");
+        instruccion("mov", "rbp, rsp");
+        for (RegistroX86 r : guardados) instruccion("push", nombre(r));
+        if (marco > 0) instruccion("sub", "rsp, " + to_string(marco));
+    }
+
+    void epilogo(const vector<RegistroX86> &guardados) override {
+        if (guardados.empty()) {
+            instruccion("mov", "rsp, rbp");
+        } else {
+            instruccion("lea", "rsp, [rbp-" + to_string(8 * guardados.size()) + "]");
+        }
+        for (auto it = guardados.rbegin(); it != guardados.rend(); ++it) instruccion("pop", nombre(*it));
+        instruccion("pop", "rbp");
+        instruccion("ret", "");
+    }
+
+    void etiqueta(uint32_t numero) override { cuerpo << ".LB" << numero << ":\n"; }
+
+    void mover(UbicacionX86 destino, UbicacionX86 fuente) override {
+        if (fuente.tipo == UbicacionX86::CADENA) {
+            instruccion("lea", texto(destino) + ", [rip+.Lcadena" + to_string(fuente.valor) + "]");
+            cadenas.push_back(static_cast<uint32_t>(fuente.valor));
+        } else if (fuente.tipo == UbicacionX86::INMEDIATO && destino.tipo == UbicacionX86::REGISTRO) {
+            // Con 32 bits alcanza si el valor no es negativo: la escritura limpia la parte alta
+            if (fuente.valor >= 0 && fuente.valor <= UINT32_MAX) {
+                instruccion("mov", nombre32(destino.registro) + ", " + to_string(fuente.valor));
+            } else if (fuente.cabeEn32()) {
+                instruccion("mov", texto(destino) + ", " + to_string(fuente.valor));
+            } else {
+                instruccion("movabs", texto(destino) + ", " + to_string(fuente.valor));
+            }
+        } else {
+            instruccion("mov", texto(destino) + ", " + texto(fuente));
+        }
+    }
+
+    void operar(OperacionX86 op, RegistroX86 destino, UbicacionX86 fuente) override {
+        static const char *const mnemonicos[] = {"add", "sub", "imul", "cmp"};
+        if (op == OperacionX86::MULTIPLICAR && fuente.tipo == UbicacionX86::INMEDIATO) {
+            instruccion("imul", nombre(destino) + ", " + nombre(destino) + ", " + texto(fuente));
+        } else {
+            instruccion(mnemonicos[static_cast<size_t>(op)], nombre(destino) + ", " + texto(fuente));
+        }
+    }
+
+    void desplazar(RegistroX86 destino, UbicacionX86 cantidad) override {
+        instruccion("shl", nombre(destino) + ", " + (cantidad.tipo == UbicacionX86::INMEDIATO ? to_string(cantidad.valor) : string("cl")));
+    }
+
+    void negar(RegistroX86 destino) override { instruccion("neg", nombre(destino)); }
+
+    void dividir(UbicacionX86 divisor) override {
+        instruccion("cqo", "");
+        instruccion("idiv", texto(divisor));
+    }
+
+    void guardarEn(RegistroX86 direccion, int32_t valor) override {
+        instruccion("mov", "QWORD PTR [" + nombre(direccion) + "], " + to_string(valor));
+    }
+
+    void fijarSi(CondicionX86 condicion, RegistroX86 destino) override {
+        instruccion(string("set") + sufijo(condicion), nombre8(destino));
+        instruccion("movzx", nombre32(destino) + ", " + nombre8(destino));
+    }
+
+    void saltar(uint32_t numero) override { instruccion("jmp", ".LB" + to_string(numero)); }
+
+    void saltarSi(CondicionX86 condicion, uint32_t numero) override {
+        instruccion(string("j") + sufijo(condicion), ".LB" + to_string(numero));
+    }
+
+    // Archivo completo, listo para ensamblar y enlazar
+    void escribir(ostream &salida, const CodigoTAC &codigo, bool devuelveCadena) {
+        salida << "\t.intel_syntax noprefix\n";
+        salida << "\t.section .rodata\n";
+        salida << ".Lformato:\n\t.string \"" << (devuelveCadena ? "%s" : "%ld") << "\\n\"\n";
+        string error = string("Error de ejecución: ") + ERROR_DIVISION + "\n";
+        salida << ".Lerror:\n\t.string ";
+        escribirCadena(salida, error);
+        sort(cadenas.begin(), cadenas.end());
+        cadenas.erase(unique(cadenas.begin(), cadenas.end()), cadenas.end());
+        for (uint32_t c : cadenas) {
+            salida << ".Lcadena" << c << ":\n\t.string ";
+            escribirCadena(salida, nombreDe(codigo.constantes[c].cadena));
+        }
+        salida << "\t.text\n";
+        salida << "\t.type\tprograma, @function\n";
+        salida << "programa:\n" << cuerpo.str();
+        salida << "\t.size\tprograma, .-programa\n";
+        salida << "\t.globl\tmain\n";
+        salida << "\t.type\tmain, @function\n";
+        salida << "main:\n";
+        salida << "\tpush\trbp\n";   // con el marco de 16 bytes la pila queda alineada para printf
+        salida << "\tmov\trbp, rsp\n";
+        salida << "\tsub\trsp, 16\n";
+        salida << "\tmov\tQWORD PTR [rbp-8], 0\n";
+        salida << "\tlea\trdi, [rbp-8]\n";
+        salida << "\tcall\tprograma\n";
+        salida << "\tcmp\tQWORD PTR [rbp-8], 0\n";
+        salida << "\tjne\t.Lfallo\n";
+        salida << "\tlea\trdi, [rip+.Lformato]\n";
+        salida << "\tmov\trsi, rax\n";
+        salida << "\txor\teax, eax\n";
+        salida << "\tcall\tprintf@PLT\n";
+        salida << "\txor\teax, eax\n";
+        salida << "\tleave\n";
+        salida << "\tret\n";
+        // Error de ejecución: el mensaje a stderr y código de salida 1
+        salida << ".Lfallo:\n";
+        salida << "\tmov\tedi, 2\n";
+        salida << "\tlea\trsi, [rip+.Lerror]\n";
+        salida << "\tmov\tedx, " << error.size() << "\n";
+        salida << "\tcall\twrite@PLT\n";
+        salida << "\tmov\teax, 1\n";
+        salida << "\tleave\n";
+        salida << "\tret\n";
+        salida << "\t.size\tmain, .-main\n";
+        salida << "\t.section\t.note.GNU-stack,\"\",@progbits\n";
+    }
+
+private:
+    ostringstream cuerpo;
+    vector<uint32_t> cadenas;
+
+    // Literal de .string con comillas; los bytes no imprimibles van en octal
+    static void escribirCadena(ostream &salida, string_view texto) {
+        salida << '"';
+        for (unsigned char ch : texto) {
+            if (ch == '"' || ch == '\\') {
+                salida << '\\' << ch;
+            } else if (ch < 32 || ch >= 127) {
+                salida << '\\' << oct << setw(3) << setfill('0') << static_cast<int>(ch) << dec << setfill(' ');
+            } else {
+                salida << ch;
+            }
+        }
+        salida << "\"\n";
+    }
+
+    void instruccion(const string &mnemonico, const string &operandos) {
+        cuerpo << '\t' << mnemonico;
+        if (!operandos.empty()) cuerpo << '\t' << operandos;
+        cuerpo << '\n';
+        instrucciones++;
+    }
+
+    static string nombre(RegistroX86 r) {
+        static const char *const nombres64[] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+                                                "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"};
+        return nombres64[static_cast<size_t>(r)];
+    }
+
+    static string nombre32(RegistroX86 r) {
+        static const char *const nombres32[] = {"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+                                                "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"};
+        return nombres32[static_cast<size_t>(r)];
+    }
+
+    static string nombre8(RegistroX86 r) {
+        static const char *const nombres8[] = {"al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+                                               "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"};
+        return nombres8[static_cast<size_t>(r)];
+    }
+
+    static const char *sufijo(CondicionX86 condicion) {
+        switch (condicion) {
+            case CondicionX86::IGUAL: return "e";
+            case CondicionX86::DISTINTO: return "ne";
+            case CondicionX86::MENOR: return "l";
+            case CondicionX86::MAYOR_IGUAL: return "ge";
+            case CondicionX86::MENOR_IGUAL: return "le";
+            default: return "g";
+        }
+    }
+
+    static string texto(UbicacionX86 u) {
+        switch (u.tipo) {
+            case UbicacionX86::REGISTRO: return nombre(u.registro);
+            case UbicacionX86::PILA: return "QWORD PTR [rbp" + to_string(u.desplazamiento) + "]";
+            default: return to_string(u.valor);
+        }
+    }
+};
+
+// Emisor de código máquina: codifica cada instrucción directo en bytes y al final
+// resuelve los saltos. Todos los saltos usan desplazamientos de 32 bits, así que no
+// hace falta iterar para ajustar tamaños. Una cadena se carga como su posición en la
+// tabla de constantes más uno: la misma constante da el mismo valor y nunca es 0. Con
+// `numeracion` la posición se traduce antes (el objeto usa el registro de la VM).
+class EmisorBinario : public EmisorX86 {
+public:
+    vector<uint8_t> bytes;
+
+    EmisorBinario() = default;
+    explicit EmisorBinario(vector<uint32_t> numeracion) : numeracion(move(numeracion)) {}
+
+    void prologo(const vector<RegistroX86> &guardados, uint32_t marco) override {
+        empujar(RegistroX86::RBP);
+        byte(0x48); byte(0x89); byte(0xE5);   // mov rbp, rsp
+        for (RegistroX86 r : guardados) empujar(r);
+        if (marco > 0) {
+            byte(0x48); byte(0x81); byte(0xEC); entero32(static_cast<int32_t>(marco));   // sub rsp, marco
+        }
+    }
+
+    void epilogo(const vector<RegistroX86> &guardados) override {
+        if (guardados.empty()) {
+            byte(0x48); byte(0x89); byte(0xEC);   // mov rsp, rbp
+        } else {
+            // lea rsp, [rbp - 8n]
+            modrm(0x8D, RegistroX86::RSP, UbicacionX86::enPila(-8 * static_cast<int32_t>(guardados.size())));
+        }
+        for (auto it = guardados.rbegin(); it != guardados.rend(); ++it) sacar(*it);
+        sacar(RegistroX86::RBP);
+        byte(0xC3);
+    }
+
+    void etiqueta(uint32_t numero) override {
+        if (numero >= posicionEtiqueta.size()) posicionEtiqueta.resize(numero + 1, UINT32_MAX);
+        posicionEtiqueta[numero] = static_cast<uint32_t>(bytes.size());
+    }
+
+    void mover(UbicacionX86 destino, UbicacionX86 fuente) override {
+        if (fuente.tipo == UbicacionX86::CADENA) {
+            int64_t posicion = numeracion.empty() ? fuente.valor : numeracion[static_cast<size_t>(fuente.valor)];
+            fuente = UbicacionX86::inmediato(posicion + 1);
+        }
+        if (fuente.tipo == UbicacionX86::INMEDIATO && destino.tipo == UbicacionX86::REGISTRO) {
+            uint8_t r = numero(destino.registro);
+            if (fuente.valor >= 0 && fuente.valor <= UINT32_MAX) {
+                if (r >= 8) byte(0x41);
+                byte(0xB8 + (r & 7));                          // mov r32, imm32
+                entero32(static_cast<int32_t>(static_cast<uint32_t>(fuente.valor)));
+            } else if (fuente.cabeEn32()) {
+                modrm(0xC7, 0, destino);                       // mov r/m64, imm32
+                entero32(static_cast<int32_t>(fuente.valor));
+            } else {
+                byte(0x48 | (r >> 3));
+                byte(0xB8 + (r & 7));                          // movabs r64, imm64
+                for (int k = 0; k < 8; k++) byte(static_cast<uint8_t>(static_cast<uint64_t>(fuente.valor) >> (8 * k)));
+            }
+        } else if (fuente.tipo == UbicacionX86::INMEDIATO) {
+            modrm(0xC7, 0, destino);
+            entero32(static_cast<int32_t>(fuente.valor));
+        } else if (destino.tipo == UbicacionX86::REGISTRO) {
+            modrm(0x8B, destino.registro, fuente);             // mov r64, r/m64
+        } else {
+            modrm(0x89, fuente.registro, destino);             // mov r/m64, r64
+        }
+    }
+
+    void operar(OperacionX86 op, RegistroX86 destino, UbicacionX86 fuente) override {
+        if (fuente.tipo == UbicacionX86::INMEDIATO) {
+            bool corto = fuente.valor >= INT8_MIN && fuente.valor <= INT8_MAX;
+            if (op == OperacionX86::MULTIPLICAR) {
+                modrm(corto ? 0x6B : 0x69, destino, UbicacionX86::enRegistro(destino));   // imul r, r, imm
+            } else {
+                static const uint8_t extension[] = {0, 5, 0, 7};   // add /0, sub /5, cmp /7
+                modrm(corto ? 0x83 : 0x81, extension[static_cast<size_t>(op)], UbicacionX86::enRegistro(destino));
+            }
+            if (corto) {
+                byte(static_cast<uint8_t>(fuente.valor));
+            } else {
+                entero32(static_cast<int32_t>(fuente.valor));
+            }
+            return;
+        }
+        switch (op) {
+            case OperacionX86::SUMAR: modrm(0x03, destino, fuente); break;
+            case OperacionX86::RESTAR: modrm(0x2B, destino, fuente); break;
+            case OperacionX86::MULTIPLICAR: modrm(0x0FAF, destino, fuente); break;
+            case OperacionX86::COMPARAR: modrm(0x3B, destino, fuente); break;
+        }
+    }
+
+    void desplazar(RegistroX86 destino, UbicacionX86 cantidad) override {
+        if (cantidad.tipo == UbicacionX86::INMEDIATO) {
+            modrm(0xC1, 4, UbicacionX86::enRegistro(destino));   // shl r/m64, imm8
+            byte(static_cast<uint8_t>(cantidad.valor));
+        } else {
+            modrm(0xD3, 4, UbicacionX86::enRegistro(destino));   // shl r/m64, cl
+        }
+    }
+
+    void negar(RegistroX86 destino) override { modrm(0xF7, 3, UbicacionX86::enRegistro(destino)); }
+
+    void dividir(UbicacionX86 divisor) override {
+        byte(0x48); byte(0x99);   // cqo
+        modrm(0xF7, 7, divisor);  // idiv r/m64
+    }
+
+    // mov QWORD [r], imm32. Sin SIB ni desplazamiento: r no puede ser rsp, rbp, r12 ni r13
+    void guardarEn(RegistroX86 direccion, int32_t valor) override {
+        uint8_t r = numero(direccion);
+        byte(0x48 | (r >> 3)); byte(0xC7); byte(r & 7);
+        entero32(valor);
+    }
+
+    void fijarSi(CondicionX86 condicion, RegistroX86 destino) override {
+        // setcc r/m8 y movzx r32, r/m8. Sin REX, los registros 4 a 7 serían ah, ch, dh y bh
+        uint8_t r = numero(destino);
+        if (r >= 4) byte(0x40 | (r >> 3));
+        byte(0x0F); byte(0x90 + static_cast<uint8_t>(condicion)); byte(0xC0 | (r & 7));
+        if (r >= 4) byte(0x40 | (r >> 3) << 2 | (r >> 3));
+        byte(0x0F); byte(0xB6); byte(0xC0 | (r & 7) << 3 | (r & 7));
+    }
+
+    void saltar(uint32_t numero) override {
+        byte(0xE9);
+        pendiente(numero);
+    }
+
+    void saltarSi(CondicionX86 condicion, uint32_t numero) override {
+        byte(0x0F); byte(0x80 + static_cast<uint8_t>(condicion));
+        pendiente(numero);
+    }
+
+    // Escribe los desplazamientos de los saltos, relativos al final de cada instrucción
+    void resolverSaltos() {
+        for (auto [posicion, numero] : saltosPendientes) {
+            int32_t relativo = static_cast<int32_t>(posicionEtiqueta[numero]) - static_cast<int32_t>(posicion + 4);
+            memcpy(&bytes[posicion], &relativo, 4);
+        }
+        saltosPendientes.clear();
+    }
+
+private:
+    vector<uint32_t> numeracion;
+    vector<uint32_t> posicionEtiqueta;
+    vector<pair<size_t, uint32_t>> saltosPendientes;   // (posición del rel32, etiqueta)
+
+    static uint8_t numero(RegistroX86 r) { return static_cast<uint8_t>(r); }
+
+    void byte(uint8_t b) { bytes.push_back(b); }
+
+    void entero32(int32_t valor) {
+        for (int k = 0; k < 4; k++) byte(static_cast<uint8_t>(static_cast<uint32_t>(valor) >> (8 * k)));
+    }
+
+    void pendiente(uint32_t numero) {
+        saltosPendientes.push_back({bytes.size(), numero});
+        entero32(0);
+    }
+
+    void empujar(RegistroX86 r) {
+        if (numero(r) >= 8) byte(0x41);
+        byte(0x50 + (numero(r) & 7));
+    }
+
+    void sacar(RegistroX86 r) {
+        if (numero(r) >= 8) byte(0x41);
+        byte(0x58 + (numero(r) & 7));
+    }
+
+    void modrm(uint16_t opcode, RegistroX86 reg, UbicacionX86 rm) { modrm(opcode, numero(reg), rm); }
+
+    // REX.W, el código de operación (uno o dos bytes) y ModRM con el campo reg y un
+    // operando r/m que es un registro o [rbp + desplazamiento]
+    void modrm(uint16_t opcode, uint8_t reg, UbicacionX86 rm) {
+        uint8_t base = rm.tipo == UbicacionX86::REGISTRO ? numero(rm.registro) : numero(RegistroX86::RBP);
+        byte(0x48 | (reg >> 3) << 2 | (base >> 3));
+        if (opcode > 0xFF) byte(static_cast<uint8_t>(opcode >> 8));
+        byte(static_cast<uint8_t>(opcode));
+        if (rm.tipo == UbicacionX86::REGISTRO) {
+            byte(0xC0 | (reg & 7) << 3 | (base & 7));
+        } else if (rm.desplazamiento >= INT8_MIN && rm.desplazamiento <= INT8_MAX) {
+            byte(0x40 | (reg & 7) << 3 | (base & 7));
+            byte(static_cast<uint8_t>(rm.desplazamiento));
+        } else {
+            byte(0x80 | (reg & 7) << 3 | (base & 7));
+            entero32(rm.desplazamiento);
+        }
+    }
+};
+
+// Memoria ejecutable con el código de una función. Se escribe con permiso de escritura
+// y después se cambia a solo lectura y ejecución; nunca es las dos cosas a la vez.
+class CodigoEjecutable {
+public:
+    CodigoEjecutable() = default;
+    CodigoEjecutable(const CodigoEjecutable &) = delete;
+    CodigoEjecutable &operator=(const CodigoEjecutable &) = delete;
+    ~CodigoEjecutable() { liberar(); }
+
+    bool cargar(const vector<uint8_t> &bytes) {
+        liberar();
+        tamano = bytes.size();
+#ifdef _WIN32
+        memoria = VirtualAlloc(nullptr, tamano, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!memoria) return false;
+        memcpy(memoria, bytes.data(), tamano);
+        DWORD anterior;
+        if (!VirtualProtect(memoria, tamano, PAGE_EXECUTE_READ, &anterior)) return false;
+        FlushInstructionCache(GetCurrentProcess(), memoria, tamano);
+#else
+        void *vista = mmap(nullptr, tamano, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (vista == MAP_FAILED) return false;
+        memoria = vista;
+        memcpy(memoria, bytes.data(), tamano);
+        if (mprotect(memoria, tamano, PROT_READ | PROT_EXEC) != 0) return false;
+#endif
+        return true;
+    }
+
+    // Llama a la función generada; falso si terminó en un error de ejecución
+    bool llamar(int64_t &valor) const {
+        int64_t fallo = 0;
+        valor = reinterpret_cast<int64_t (*)(int64_t *)>(memoria)(&fallo);
+        return fallo == 0;
+    }
+
+private:
+    void *memoria = nullptr;
+    size_t tamano = 0;
+
+    void liberar() {
+        if (!memoria) return;
+#ifdef _WIN32
+        VirtualFree(memoria, 0, MEM_RELEASE);
+#else
+        munmap(memoria, tamano);
+#endif
+        memoria = nullptr;
+    }
+};
+
+// Imprime una expresión en una sola línea, con paréntesis explícitos
+void imprimirExpresion(ASTNode* nodo) {
+    despachar(nodo, Sobrecarga{
+        [](Literal* literal) {
+            cout << nombreDe(literal->value);
+        },
+        [](BinaryOp* binary) {
+            cout << "(";
+            imprimirExpresion(binary->left);
+            cout << " " << nombreDe(binary->op) << " ";
+            imprimirExpresion(binary->right);
+            cout << ")";
+        },
+        [](UnaryOp* unary) {
+            cout << nombreDe(unary->op);
+            imprimirExpresion(unary->operand);
+        },
+        [](ASTNode*) {}
+    });
+}
+
+// Función para imprimir el AST
+void imprimirAST(ASTNode* nodo, int nivel = 0) {
+    despachar(nodo, Sobrecarga{
+        [nivel](FunctionDef* func_def) {
+            cout << string(nivel * 2, ' ') << "FunctionDef: " << nombreDe(func_def->name) << " -> " << nombreDe(func_def->return_type) << endl;
+            for (const auto& stmt : func_def->body) {
+                imprimirAST(stmt, nivel + 1);
+            }
+        },
+        [nivel](Assign* assign) {
+            cout << string(nivel * 2, ' ') << "Assign: " << nombreDe(assign->target) << " = ";
+            imprimirAST(assign->value, 0);
+        },
+        [](Literal* literal) {
+            cout << nombreDe(literal->value) << " (" << nombreDe(literal->type) << ")" << endl;
+        },
+        [](BinaryOp* binary) {
+            imprimirExpresion(binary);
+            cout << endl;
+        },
+        [](UnaryOp* unary) {
+            imprimirExpresion(unary);
+            cout << endl;
+        },
+        [nivel](Return* return_stmt) {
+            cout << string(nivel * 2, ' ') << "Return: ";
+            imprimirAST(return_stmt->value, 0);
+        },
+        [nivel](If* if_stmt) {
+            cout << string(nivel * 2, ' ') << "If: " << endl;
+            cout << string((nivel + 1) * 2, ' ') << "Condition: ";
+            imprimirAST(if_stmt->condition, 0);
+            cout << string((nivel + 1) * 2, ' ') << "Then: " << endl;
+            for (const auto& stmt : if_stmt->then_body) {
+                imprimirAST(stmt, nivel + 2);
+            }
+            if (!if_stmt->else_body.empty()) {
+                cout << string((nivel + 1) * 2, ' ') << "Else: " << endl;
+                for (const auto& stmt : if_stmt->else_body) {
+                    imprimirAST(stmt, nivel + 2);
+                }
+            }
+        },
+        [nivel](While* while_stmt) {
+            cout << string(nivel * 2, ' ') << "While: " << endl;
+            cout << string((nivel + 1) * 2, ' ') << "Condition: ";
+            imprimirAST(while_stmt->condition, 0);
+            cout << string((nivel + 1) * 2, ' ') << "Body: " << endl;
+            for (const auto& stmt : while_stmt->body) {
+                imprimirAST(stmt, nivel + 2);
+            }
+        },
+        [](ASTNode*) {}
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Plegado de constantes y simplificación algebraica sobre el AST
+// ---------------------------------------------------------------------------
+
+// Reescribe las expresiones del AST en su lugar según el nivel de optimización:
+//   -O0  no toca nada
+//   -O1  pliega operaciones cuyos operandos son todos constantes enteras
+//   -O2  además aplica identidades (x+0, x*1, x*0, --x, 0&&x, 1||x) y cambia x*2^k por x<<k
+// El único efecto de una expresión es fallar: con una cadena, o al dividir por cero. Por
+// eso las identidades solo se aplican si x es siempre un entero, y x*0 además exige que
+// evaluar x no pueda fallar.
+class SimplificadorAST {
+public:
+    SimplificadorAST(Arena& arena, int nivel) : arena(arena), nivel(nivel) {}
+
+    // Número de nodos reemplazados hasta ahora
+    size_t cambios = 0;
+
+    void simplificar(ASTNode* nodo) {
+        if (nivel == 0) {
+            return;
+        }
+        despachar(nodo, Sobrecarga{
+            [this](FunctionDef* func_def) {
+                deducirEnteros(func_def);
+                simplificarBloque(func_def->body);
+            },
+            [this](Assign* assign) {
+                assign->value = expresion(assign->value);
+            },
+            [this](Return* return_stmt) {
+                return_stmt->value = expresion(return_stmt->value);
+            },
+            [this](If* if_stmt) {
+                if_stmt->condition = expresion(if_stmt->condition);
+                simplificarBloque(if_stmt->then_body);
+                simplificarBloque(if_stmt->else_body);
+            },
+            [this](While* while_stmt) {
+                while_stmt->condition = expresion(while_stmt->condition);
+                simplificarBloque(while_stmt->body);
+            },
+            [](ASTNode*) {}
+        });
+    }
+
+private:
+    Arena& arena;
+    int nivel;
+    unordered_set<IdNombre> noEnteros;   // nombres que pueden guardar algo que no es un entero
+
+    void simplificarBloque(ListaNodos cuerpo) {
+        for (ASTNode* stmt : cuerpo) {
+            simplificar(stmt);
+        }
+    }
+
+    // Se parte de que todo nombre guarda siempre un entero (una variable sin asignar vale
+    // 0) y se descartan los que reciben un valor que puede no serlo, hasta que nada cambia.
+    // No distingue ámbitos: un nombre es entero solo si lo son todas las variables que lo usan.
+    void deducirEnteros(FunctionDef* func_def) {
+        noEnteros.clear();
+        noEnteros.insert(func_def->args.begin(), func_def->args.end());
+        while (descartarNoEnteros(func_def->body)) {
+        }
+    }
+
+    // Verdadero si descartó algún nombre
+    bool descartarNoEnteros(ListaNodos cuerpo) {
+        bool cambio = false;
+        for (ASTNode* stmt : cuerpo) {
+            cambio |= despachar(stmt, Sobrecarga{
+                [this](Assign* assign) {
+                    return !esEntera(assign->value) && noEnteros.insert(assign->target).second;
+                },
+                [this](If* if_stmt) {
+                    bool entonces = descartarNoEnteros(if_stmt->then_body);
+                    return descartarNoEnteros(if_stmt->else_body) || entonces;
+                },
+                [this](While* while_stmt) {
+                    return descartarNoEnteros(while_stmt->body);
+                },
+                [](ASTNode*) {
+                    return false;
+                }
+            });
+        }
+        return cambio;
+    }
+
+    // Verdadero si el valor de la expresión, cuando no falla, es siempre un entero. Solo la
+    // suma puede dar una cadena; las demás operaciones dan un entero o fallan.
+    bool esEntera(ASTNode* nodo) const {
+        return despachar(nodo, Sobrecarga{
+            [this](Literal* literal) {
+                string_view texto = nombreDe(literal->value);
+                int64_t valor;
+                if (leerEntero(texto, valor)) {
+                    return true;
+                }
+                return !texto.empty() && texto[0] != '"' && noEnteros.count(literal->value) == 0;
+            },
+            [this](BinaryOp* binary) {
+                return binary->op != N_MAS || (esEntera(binary->left) && esEntera(binary->right));
+            },
+            [](UnaryOp*) {
+                return true;
+            },
+            [](ASTNode*) {
+                return false;
+            }
+        });
+    }
+
+    // Valor de un literal entero; falso si el nodo no es una constante
+    static bool valorConstante(ASTNode* nodo, int64_t& valor) {
+        auto literal = nodoComo<Literal>(nodo);
+        return literal && leerEntero(nombreDe(literal->value), valor);
+    }
+
+    static bool esConstante(ASTNode* nodo, int64_t valor) {
+        int64_t v;
+        return valorConstante(nodo, v) && v == valor;
+    }
+
+    ASTNode* constante(int64_t valor) {
+        cambios++;
+        return arena.crear<Literal>(internar(to_string(valor)), N_INT);
+    }
+
+    ASTNode* reemplazo(ASTNode* nodo) {
+        cambios++;
+        return nodo;
+    }
+
+    // Resultado de `a op b` si se puede calcular sin desbordamiento ni división por cero
+    static bool plegar(IdNombre op, int64_t a, int64_t b, int64_t& r) {
+        switch (op) {
+            case N_MAS: return !__builtin_add_overflow(a, b, &r);
+            case N_MENOS: return !__builtin_sub_overflow(a, b, &r);
+            case N_POR: return !__builtin_mul_overflow(a, b, &r);
+            case N_ENTRE:
+            case N_MODULO:
+                if (b == 0 || (a == INT64_MIN && b == -1)) {
+                    return false;
+                }
+                r = op == N_ENTRE ? a / b : a % b;
+                return true;
+            case N_MENOR: r = a < b; return true;
+            case N_MENOR_IGUAL: r = a <= b; return true;
+            case N_MAYOR: r = a > b; return true;
+            case N_MAYOR_IGUAL: r = a >= b; return true;
+            case N_IGUAL: r = a == b; return true;
+            case N_DISTINTO: r = a != b; return true;
+            case N_Y: r = a != 0 && b != 0; return true;
+            case N_O: r = a != 0 || b != 0; return true;
+            default: return false;
+        }
+    }
+
+    // Verdadero si evaluar la expresión puede terminar en error de ejecución: una división
+    // o módulo cuyo divisor no es una constante distinta de 0 y de -1
+    static bool puedeFallar(ASTNode* nodo) {
+        return despachar(nodo, Sobrecarga{
+            [](BinaryOp* binary) {
+                int64_t divisor;
+                if ((binary->op == N_ENTRE || binary->op == N_MODULO) &&
+                    !(valorConstante(binary->right, divisor) && divisor != 0 && divisor != -1)) {
+                    return true;
+                }
+                return puedeFallar(binary->left) || puedeFallar(binary->right);
+            },
+            [](UnaryOp* unary) {
+                return puedeFallar(unary->operand);
+            },
+            [](ASTNode*) {
+                return false;
+            }
+        });
+    }
+
+    // Exponente k si valor == 2^k con k >= 1, o -1
+    static int potenciaDeDos(int64_t valor) {
+        if (valor < 2 || (valor & (valor - 1)) != 0) {
+            return -1;
+        }
+        return __builtin_ctzll(static_cast<unsigned long long>(valor));
+    }
+
+    ASTNode* expresion(ASTNode* nodo) {
+        return despachar(nodo, Sobrecarga{
+            [this](BinaryOp* binary) {
+                binary->left = expresion(binary->left);
+                binary->right = expresion(binary->right);
+                return binario(binary);
+            },
+            [this](UnaryOp* unary) {
+                unary->operand = expresion(unary->operand);
+                int64_t v;
+                if (unary->op == N_MENOS && valorConstante(unary->operand, v) && v != INT64_MIN) {
+                    return constante(-v);
+                }
+                if (unary->op == N_NO && valorConstante(unary->operand, v)) {
+                    return constante(v == 0);
+                }
+                if (nivel >= 2) {
+                    // La doble negación aritmética se cancela
+                    auto interno = nodoComo<UnaryOp>(unary->operand);
+                    if (unary->op == N_MENOS && interno && interno->op == N_MENOS && esEntera(interno->operand)) {
+                        return reemplazo(interno->operand);
+                    }
+                }
+                return static_cast<ASTNode*>(unary);
+            },
+            [](ASTNode* otro) {
+                return otro;
+            }
+        });
+    }
+
+    ASTNode* binario(BinaryOp* binary) {
+        int64_t a = 0, b = 0, r;
+        bool izquierdoConstante = valorConstante(binary->left, a);
+        bool derechoConstante = valorConstante(binary->right, b);
+        if (izquierdoConstante && derechoConstante && plegar(binary->op, a, b, r)) {
+            return constante(r);
+        }
+        if (nivel < 2) {
+            return binary;
+        }
+
+        ASTNode* x = binary->left;
+        ASTNode* y = binary->right;
+        // Con una cadena la operación falla; reemplazarla por el operando la haría funcionar
+        bool xEntera = esEntera(x);
+        bool yEntera = esEntera(y);
+        switch (binary->op) {
+            case N_MAS:
+                if (esConstante(y, 0) && xEntera) return reemplazo(x);
+                if (esConstante(x, 0) && yEntera) return reemplazo(y);
+                break;
+            case N_MENOS:
+                if (esConstante(y, 0) && xEntera) return reemplazo(x);
+                break;
+            case N_POR: {
+                if (esConstante(y, 1) && xEntera) return reemplazo(x);
+                if (esConstante(x, 1) && yEntera) return reemplazo(y);
+                // El factor descartado tiene que evaluarse si puede fallar, como en -O0
+                if ((esConstante(x, 0) && yEntera && !puedeFallar(y)) || (esConstante(y, 0) && xEntera && !puedeFallar(x))) return constante(0);
+                // Reducción de fuerza: multiplicar por 2^k es desplazar k bits
+                int k = derechoConstante && xEntera ? potenciaDeDos(b) : -1;
+                if (k < 0 && izquierdoConstante && yEntera) {
+                    k = potenciaDeDos(a);
+                    swap(x, y);
+                }
+                if (k > 0) {
+                    cambios++;
+                    return arena.crear<BinaryOp>(N_DESPLAZAR, x, arena.crear<Literal>(internar(to_string(k)), N_INT));
+                }
+                break;
+            }
+            case N_ENTRE:
+                if (esConstante(y, 1) && xEntera) return reemplazo(x);
+                break;
+            case N_Y:
+                if (esConstante(x, 0)) return constante(0);
+                break;
+            case N_O:
+                if (izquierdoConstante && a != 0) return constante(1);
+                break;
+            default:
+                break;
+        }
+        return binary;
+    }
+};
+
+
+// Estructuras para el analizador semántico
+struct Simbolo {
+    IdNombre variable;
+    IdNombre tipo;
+    IdNombre ambito;
+    IdNombre ranura;   // nombre de la variable en el TAC; distinto del original si oculta a otra
+};
+
+struct Funcion {
+    IdNombre nombre;
+    IdNombre tipo;
+};
+
+// ---------------------------------------------------------------------------
+// Tabla de símbolos: un mapa hash por ámbito y una pila de ámbitos
+// ---------------------------------------------------------------------------
+
+// Mapa de un ámbito: id de nombre -> índice del símbolo, con direccionamiento abierto
+class MapaAmbito {
+public:
+    static constexpr uint32_t NINGUNO = UINT32_MAX;
+
+    uint32_t buscar(IdNombre nombre) const {
+        if (ocupadas == 0) {
+            return NINGUNO;
+        }
+        size_t mascara = ranuras.size() - 1;
+        for (size_t i = posicion(nombre);; i = (i + 1) & mascara) {
+            if (ranuras[i].nombre == nombre) {
+                return ranuras[i].simbolo;
+            }
+            if (ranuras[i].nombre == NINGUNO) {
+                return NINGUNO;
+            }
+        }
+    }
+
+    // El nombre no debe estar ya en el mapa
+    void insertar(IdNombre nombre, uint32_t simbolo) {
+        if ((ocupadas + 1) * 4 > ranuras.size() * 3) {
+            crecer();
+        }
+        size_t mascara = ranuras.size() - 1;
+        size_t i = posicion(nombre);
+        while (ranuras[i].nombre != NINGUNO) {
+            i = (i + 1) & mascara;
+        }
+        ranuras[i] = {nombre, simbolo};
+        ocupadas++;
+    }
+
+    // Deja el mapa vacío conservando su capacidad, para reutilizarlo en el siguiente ámbito
+    void vaciar() {
+        if (ocupadas > 0) {
+            fill(ranuras.begin(), ranuras.end(), Entrada{NINGUNO, NINGUNO});
+            ocupadas = 0;
+        }
+    }
+
+private:
+    struct Entrada {
+        IdNombre nombre;
+        uint32_t simbolo;
+    };
+
+    vector<Entrada> ranuras;
+    size_t ocupadas = 0;
+    unsigned bits = 0;
+
+    // Hash multiplicativo: los ids son consecutivos, así que se mezclan con la razón áurea
+    size_t posicion(IdNombre nombre) const {
+        return (nombre * 0x9E3779B1u) >> (32 - bits);
+    }
+
+    void crecer() {
+        vector<Entrada> anteriores = move(ranuras);
+        bits = max(4u, bits + 1);
+        ranuras.assign(size_t(1) << bits, Entrada{NINGUNO, NINGUNO});
+        ocupadas = 0;
+        for (const Entrada &entrada : anteriores) {
+            if (entrada.nombre != NINGUNO) {
+                insertar(entrada.nombre, entrada.simbolo);
+            }
+        }
+    }
+};
+
+// Pila de ámbitos sobre una lista de símbolos en orden de declaración. Buscar recorre los
+// ámbitos de dentro hacia fuera, así que una declaración interna oculta a la externa.
+class TablaSimbolos {
+public:
+    TablaSimbolos() {
+        abrirAmbito(N_GLOBAL);
+    }
+
+    void abrirAmbito(IdNombre nombre) {
+        if (profundidad == ambitos.size()) {
+            ambitos.emplace_back();
+            nombresAmbito.emplace_back();
+        }
+        nombresAmbito[profundidad] = nombre;
+        profundidad++;
+    }
+
+    void cerrarAmbito() {
+        profundidad--;
+        ambitos[profundidad].vaciar();
+    }
+
+    // Nombre del ámbito actual (los bloques heredan el de la función que los contiene)
+    IdNombre ambitoActual() const {
+        return nombresAmbito[profundidad - 1];
+    }
+
+    // Declara el nombre en el ámbito actual; si ya estaba declarado ahí, actualiza su tipo.
+    // La primera declaración de un nombre usa el nombre como ranura; las siguientes, en
+    // otros ámbitos, reciben una propia (x@1, x@2...) para no pisar a la que ocultan.
+    Simbolo &declarar(IdNombre nombre, IdNombre tipo) {
+        MapaAmbito &ambito = ambitos[profundidad - 1];
+        uint32_t existente = ambito.buscar(nombre);
+        if (existente != MapaAmbito::NINGUNO) {
+            simbolos[existente].tipo = tipo;
+            return simbolos[existente];
+        }
+        uint32_t anteriores = declaraciones[nombre]++;
+        IdNombre ranura = anteriores == 0 ? nombre : internar(string(nombreDe(nombre)) + "@" + to_string(anteriores));
+        ambito.insertar(nombre, static_cast<uint32_t>(simbolos.size()));
+        simbolos.push_back({nombre, tipo, ambitoActual(), ranura});
+        return simbolos.back();
+    }
+
+    // Símbolo visible con ese nombre, o nullptr si no está declarado en ningún ámbito abierto
+    Simbolo *buscar(IdNombre nombre) {
+        for (size_t i = profundidad; i-- > 0;) {
+            uint32_t simbolo = ambitos[i].buscar(nombre);
+            if (simbolo != MapaAmbito::NINGUNO) {
+                return &simbolos[simbolo];
+            }
+        }
+        return nullptr;
+    }
+
+    const vector<Simbolo> &todos() const { return simbolos; }
+
+private:
+    vector<Simbolo> simbolos;
+    vector<MapaAmbito> ambitos;        // se reutilizan al volver a abrir un ámbito
+    vector<IdNombre> nombresAmbito;
+    size_t profundidad = 0;
+    unordered_map<IdNombre, uint32_t> declaraciones;   // cuántas veces se declaró cada nombre
+};
+
+void imprimirTablaSimbolos(const vector<Simbolo> &simbolos, const vector<Funcion> &funciones) {
+    cout << "------- Tabla de Símbolos ----------" << endl;
+    for (const auto& simbolo : simbolos) {
+        cout << "|   Variable:   | " << nombreDe(simbolo.variable) << "   |    Tipo:   |   " << nombreDe(simbolo.tipo) << "|     Ámbito:      |" << nombreDe(simbolo.ambito) << endl;
+    }
+    cout << "------- Funciones --------" << endl;
+    for (const auto& funcion : funciones) {
+        cout << "|     Función:      |" << nombreDe(funcion.nombre) << "|      Tipo de Retorno:      |" << nombreDe(funcion.tipo) << endl;
+    }
+}
+
+class AnalizadorSemantic {
+private:
+    TablaSimbolos tabla;
+    vector<Funcion> funciones;
+
+public:
+    void analizar(ASTNode* arbol) {
+        visit(arbol);
+        imprimir_tabla_simbolos();
+    }
+
+    const vector<Simbolo> &simbolos() const { return tabla.todos(); }
+    const vector<Funcion> &funcionesDeclaradas() const { return funciones; }
+
+    void visit(ASTNode* nodo) {
+        despachar(nodo, Sobrecarga{
+            [this](FunctionDef* func_def) {
+                tabla.abrirAmbito(func_def->name);
+                for (const auto& arg : func_def->args) {
+                    agregar_variable(arg, N_DESCONOCIDO); // Tipo desconocido por ahora
+                }
+
+                for (const auto& statement : func_def->body) {
+                    visit(statement);
+                }
+                tabla.cerrarAmbito();
+
+                funciones.push_back({func_def->name, func_def->return_type});
+            },
+            [this](Assign* assign) {
+                if (assign->declared_type != N_VACIO) {
+                    // Declaración: crea la variable en el ámbito actual, ocultando las externas
+                    agregar_variable(assign->target, assign->declared_type);
+                } else if (!tabla.buscar(assign->target)) {
+                    // Asignación a una variable no declarada: se declara con el tipo del valor
+                    agregar_variable(assign->target, obtener_tipo_dato(assign->value));
+                }
+            },
+            [this](Return* return_stmt) {
+                // Analizar el valor de retorno
+                visit(return_stmt->value);
+            },
+            [this](If* if_stmt) {
+                // Analizar la condición
+                visit(if_stmt->condition);
+                // Analizar el cuerpo del bloque "then"
+                visitarBloque(if_stmt->then_body);
+                // Analizar el cuerpo del bloque "else"
+                visitarBloque(if_stmt->else_body);
+            },
+            [this](While* while_stmt) {
+                // Analizar la condición
+                visit(while_stmt->condition);
+                // Analizar el cuerpo del bucle
+                visitarBloque(while_stmt->body);
+            },
+            [](ASTNode*) {}
+        });
+    }
+
+    // Cada bloque abre su propio ámbito, que se descarta al salir
+    void visitarBloque(ListaNodos cuerpo) {
+        tabla.abrirAmbito(tabla.ambitoActual());
+        for (const auto& stmt : cuerpo) {
+            visit(stmt);
+        }
+        tabla.cerrarAmbito();
+    }
+
+    void agregar_variable(IdNombre variable, IdNombre tipo) {
+        tabla.declarar(variable, tipo);
+    }
+
+    IdNombre obtener_tipo_dato(ASTNode* nodo) {
+        if (auto literal = nodoComo<Literal>(nodo)) {
+            return literal->type;
+        }
+        return N_DESCONOCIDO;
+    }
+
+    void imprimir_tabla_simbolos() {
+        imprimirTablaSimbolos(tabla.todos(), funciones);
+    }
+};
+
+// Generador de TAC. Baja el AST en una sola pasada: cada expresión se evalúa en
+// temporales nuevos y las condiciones se traducen a saltos con cortocircuito. Los
+// nombres se resuelven con los mismos ámbitos que el análisis semántico, así que una
+// declaración que oculta a otra escribe en su propia ranura.
+class TACGenerator {
+private:
+    CodigoTAC codigo;
+    TablaSimbolos tabla;
+
+public:
+    CodigoTAC generate(ASTNode* nodo) {
+        visit(nodo);
+        return move(codigo);
+    }
+
+    void visit(ASTNode* nodo) {
+        despachar(nodo, Sobrecarga{
+            [this](FunctionDef* func_def) {
+                tabla.abrirAmbito(func_def->name);
+                for (const auto& arg : func_def->args) {
+                    tabla.declarar(arg, N_DESCONOCIDO);
+                }
+                for (const auto& stmt : func_def->body) {
+                    visit(stmt);
+                }
+                tabla.cerrarAmbito();
+            },
+            [this](Assign* assign) {
+                // Como en C, la variable declarada es visible ya en su propio inicializador.
+                // El resultado se escribe directamente en la variable, sin temporal intermedio.
+                Simbolo* simbolo = assign->declared_type != N_VACIO ? nullptr : tabla.buscar(assign->target);
+                if (!simbolo) {
+                    simbolo = &tabla.declarar(assign->target, assign->declared_type);
+                }
+                obtener_valor(assign->value, Operando::variable(simbolo->ranura));
+            },
+            [this](Return* return_stmt) {
+                codigo.emitir(OpTAC::RETORNAR, {}, obtener_valor(return_stmt->value));
+            },
+            [this](If* if_stmt) {
+                Operando label_else = codigo.nuevaEtiqueta();
+                saltar_si_falso(if_stmt->condition, label_else);
+                visitarBloque(if_stmt->then_body);
+                if (if_stmt->else_body.empty()) {
+                    codigo.emitir(OpTAC::ETIQUETA, label_else);
+                    return;
+                }
+                Operando label_end = codigo.nuevaEtiqueta();
+                codigo.emitir(OpTAC::SALTAR, label_end);
+                codigo.emitir(OpTAC::ETIQUETA, label_else);
+                visitarBloque(if_stmt->else_body);
+                codigo.emitir(OpTAC::ETIQUETA, label_end);
+            },
+            [this](While* while_stmt) {
+                Operando label_start = codigo.nuevaEtiqueta();
+                Operando label_end = codigo.nuevaEtiqueta();
+                codigo.emitir(OpTAC::ETIQUETA, label_start);
+                saltar_si_falso(while_stmt->condition, label_end);
+                visitarBloque(while_stmt->body);
+                codigo.emitir(OpTAC::SALTAR, label_start);
+                codigo.emitir(OpTAC::ETIQUETA, label_end);
+            },
+            [](ASTNode*) {}
+        });
+    }
+
+    // Cada bloque abre su propio ámbito, como en el análisis semántico
+    void visitarBloque(ListaNodos cuerpo) {
+        tabla.abrirAmbito(tabla.ambitoActual());
+        for (const auto& stmt : cuerpo) {
+            visit(stmt);
+        }
+        tabla.cerrarAmbito();
+    }
+
+    // Evalúa la expresión y devuelve el operando con su valor. Si se pasa un destino, la
+    // última instrucción escribe ahí en lugar de en un temporal nuevo.
+    Operando obtener_valor(ASTNode* nodo, Operando destino = {}) {
+        return despachar(nodo, Sobrecarga{
+            [&](Literal* literal) {
+                return mover(operando_literal(literal), destino);
+            },
+            [&](BinaryOp* binary) {
+                if (binary->op == N_Y || binary->op == N_O) {
+                    // Valor 0/1 de una condición lógica, calculado con saltos
+                    Operando resultado = destino.vacio() ? codigo.nuevoTemporal() : destino;
+                    Operando label_falso = codigo.nuevaEtiqueta();
+                    Operando label_fin = codigo.nuevaEtiqueta();
+                    saltar_si_falso(binary, label_falso);
+                    codigo.emitir(OpTAC::ASIGNAR, resultado, codigo.constanteEntera(1));
+                    codigo.emitir(OpTAC::SALTAR, label_fin);
+                    codigo.emitir(OpTAC::ETIQUETA, label_falso);
+                    codigo.emitir(OpTAC::ASIGNAR, resultado, codigo.constanteEntera(0));
+                    codigo.emitir(OpTAC::ETIQUETA, label_fin);
+                    return resultado;
+                }
+                Operando izquierdo = obtener_valor(binary->left);
+                Operando derecho = obtener_valor(binary->right);
+                Operando resultado = destino.vacio() ? codigo.nuevoTemporal() : destino;
+                codigo.emitir(operacion_binaria(binary->op), resultado, izquierdo, derecho);
+                return resultado;
+            },
+            [&](UnaryOp* unary) {
+                Operando operando = obtener_valor(unary->operand);
+                Operando resultado = destino.vacio() ? codigo.nuevoTemporal() : destino;
+                codigo.emitir(unary->op == N_NO ? OpTAC::NO : OpTAC::NEGAR, resultado, operando);
+                return resultado;
+            },
+            [&](ASTNode*) {
+                return mover(Operando::variable(N_DESCONOCIDO), destino);
+            }
+        });
+    }
+
+    // Salta a `destino` si la condición es falsa y sigue de largo si es verdadera
+    void saltar_si_falso(ASTNode* condicion, Operando etiqueta) {
+        if (auto binary = nodoComo<BinaryOp>(condicion)) {
+            if (binary->op == N_Y) {
+                saltar_si_falso(binary->left, etiqueta);
+                saltar_si_falso(binary->right, etiqueta);
+                return;
+            }
+            if (binary->op == N_O) {
+                Operando label_verdadero = codigo.nuevaEtiqueta();
+                saltar_si_verdadero(binary->left, label_verdadero);
+                saltar_si_falso(binary->right, etiqueta);
+                codigo.emitir(OpTAC::ETIQUETA, label_verdadero);
+                return;
+            }
+        } else if (auto unary = nodoComo<UnaryOp>(condicion); unary && unary->op == N_NO) {
+            saltar_si_verdadero(unary->operand, etiqueta);
+            return;
+        }
+        codigo.emitir(OpTAC::SALTAR_SI_NO, etiqueta, obtener_valor(condicion));
+    }
+
+    // Salta a `destino` si la condición es verdadera y sigue de largo si es falsa
+    void saltar_si_verdadero(ASTNode* condicion, Operando etiqueta) {
+        if (auto binary = nodoComo<BinaryOp>(condicion)) {
+            if (binary->op == N_O) {
+                saltar_si_verdadero(binary->left, etiqueta);
+                saltar_si_verdadero(binary->right, etiqueta);
+                return;
+            }
+            if (binary->op == N_Y) {
+                Operando label_falso = codigo.nuevaEtiqueta();
+                saltar_si_falso(binary->left, label_falso);
+                saltar_si_verdadero(binary->right, etiqueta);
+                codigo.emitir(OpTAC::ETIQUETA, label_falso);
+                return;
+            }
+        } else if (auto unary = nodoComo<UnaryOp>(condicion); unary && unary->op == N_NO) {
+            saltar_si_falso(unary->operand, etiqueta);
+            return;
+        }
+        codigo.emitir(OpTAC::SALTAR_SI, etiqueta, obtener_valor(condicion));
+    }
+
+    // Los números van a la tabla de constantes, las cadenas también y el resto son variables.
+    // El plegado de constantes puede dejar literales negativos ("-4").
+    Operando operando_literal(Literal* literal) {
+        string_view texto = nombreDe(literal->value);
+        int64_t valor;
+        if (leerEntero(texto, valor)) {
+            return codigo.constanteEntera(valor);
+        }
+        if (!texto.empty() && texto[0] == '"') {
+            return codigo.constanteCadena(literal->value);
+        }
+        // Un nombre sin declaración visible usa su propio nombre, como su primera declaración
+        Simbolo* simbolo = tabla.buscar(literal->value);
+        return Operando::variable(simbolo ? simbolo->ranura : literal->value);
+    }
+
+    // Copia el valor al destino pedido, si hay uno
+    Operando mover(Operando valor, Operando destino) {
+        if (destino.vacio() || destino == valor) {
+            return valor;
+        }
+        codigo.emitir(OpTAC::ASIGNAR, destino, valor);
+        return destino;
+    }
+
+    static OpTAC operacion_binaria(IdNombre op) {
+        switch (op) {
+            case N_MAS: return OpTAC::SUMAR;
+            case N_MENOS: return OpTAC::RESTAR;
+            case N_POR: return OpTAC::MULTIPLICAR;
+            case N_ENTRE: return OpTAC::DIVIDIR;
+            case N_MODULO: return OpTAC::MODULO;
+            case N_DESPLAZAR: return OpTAC::DESPLAZAR;
+            case N_MENOR: return OpTAC::MENOR;
+            case N_MENOR_IGUAL: return OpTAC::MENOR_IGUAL;
+            case N_MAYOR: return OpTAC::MAYOR;
+            case N_MAYOR_IGUAL: return OpTAC::MAYOR_IGUAL;
+            case N_IGUAL: return OpTAC::IGUAL;
+            case N_DISTINTO: return OpTAC::DISTINTO;
+            default: return OpTAC::ASIGNAR;
+        }
+    }
+};
+// Analizador sintáctico descendente recursivo: construye el AST en la arena. Pide los
+// tokens al cursor léxico a medida que avanza y guarda solo los próximos en un anillo,
+// así que el léxico y el análisis se intercalan y nunca existe la lista completa.
+class Parser {
+public:
+    Parser(const Fuente& fuente, Arena& arena) : fuente(fuente), cursor(fuente), arena(arena) {
+        while (disponibles < ANTICIPACION && cursor.siguiente(anillo[disponibles])) {
+            disponibles++;
+        }
+    }
+
+    ASTNode* parse() {
+        return parseFunction();
+    }
+
+    // Posición del último token examinado, para los mensajes de error
+    const Token& tokenActual() const {
+        return actual();
+    }
+
+    size_t tokensLeidos() const { return leidos; }
+
+    // Verdadero si el análisis se detuvo en un literal entero que no cabe en 64 bits
+    bool literalFueraDeRango() const { return fueraDeRango; }
+
+private:
+    static constexpr size_t ANTICIPACION = 4;   // potencia de dos
+
+    const Fuente& fuente;
+    CursorLexico cursor;
+    Arena& arena;
+    array<Token, ANTICIPACION> anillo;
+    size_t cabeza = 0;        // posición del token actual en el anillo
+    size_t disponibles = 0;   // tokens leídos del cursor que todavía no se consumieron
+    size_t leidos = 0;
+    bool fueraDeRango = false;
+    vector<ASTNode*> pendientes; // Pila de sentencias de los bloques abiertos, antes de copiarlas a la arena
+    vector<pair<IdNombre, IdNombre>> declaradas; // Nombre y tipo de las variables visibles, la más interna al final
+
+    // Token actual; al pasar el final se devuelve un token vacío que no coincide con nada
+    const Token& actual() const {
+        static const Token fin{0, 0, 0, 0, TokenType::UNKNOWN};
+        return disponibles > 0 ? anillo[cabeza] : fin;
+    }
+
+    bool alFinal() const { return disponibles == 0; }
+
+    // Consume el token actual. Mientras el cursor tenga tokens el anillo está lleno, así
+    // que el hueco que deja el actual es justo donde va el siguiente.
+    void avanzar() {
+        if (disponibles == 0) {
+            return;
+        }
+        leidos++;
+        if (!cursor.siguiente(anillo[cabeza])) {
+            disponibles--;
+        }
+        cabeza = (cabeza + 1) % ANTICIPACION;
+    }
+
+    string_view valorActual() const {
+        return fuente.lexema(actual());
+    }
+
+    bool esSimbolo(string_view simbolo) const {
+        return actual().type == TokenType::SYMBOL && valorActual() == simbolo;
+    }
+
+    bool esClave(string_view clave) const {
+        return actual().type == TokenType::KEYWORD && valorActual() == clave;
+    }
+
+    // Analiza declaraciones hasta la llave de cierre; falla si alguna no es válida
+    // Las variables declaradas dentro dejan de ser visibles al salir
+    bool parseBloque(ListaNodos& cuerpo) {
+        size_t inicio = pendientes.size();
+        size_t visibles = declaradas.size();
+        while (!alFinal() && !esSimbolo("}")) {
+            auto stmt = parseStatement();
+            if (!stmt) {
+                pendientes.resize(inicio);
+                declaradas.resize(visibles);
+                return false;
+            }
+            pendientes.push_back(stmt);
+        }
+        declaradas.resize(visibles);
+        if (!esSimbolo("}")) {
+            pendientes.resize(inicio);
+            return false;
+        }
+        avanzar();
+        cuerpo = arena.copiar(pendientes.data() + inicio, pendientes.size() - inicio);
+        pendientes.resize(inicio);
+        return true;
+    }
+
+    // Tipo declarado de la variable visible con ese nombre, o desconocido si no hay ninguna
+    IdNombre tipoDeclarado(IdNombre nombre) const {
+        for (auto it = declaradas.rbegin(); it != declaradas.rend(); ++it) {
+            if (it->first == nombre) {
+                return it->second;
+            }
+        }
+        return N_DESCONOCIDO;
+    }
+
+    ASTNode* parseFunction() {
+        if (esClave("int")) {
+            avanzar();
+            if (actual().type == TokenType::IDENTIFIER) {
+                IdNombre funcName = internar(valorActual());
+                avanzar();
+                if (esSimbolo("(")) {
+                    avanzar();
+                    // Ignorar argumentos por simplicidad
+                    if (esSimbolo(")")) {
+                        avanzar();
+                        if (esSimbolo("{")) {
+                            avanzar();
+                            ListaNodos body;
+                            if (parseBloque(body)) {
+                                return arena.crear<FunctionDef>(funcName, Lista<IdNombre>{}, body, N_INT);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    ASTNode* parseStatement() {
+        if (esClave("int") || esClave("string")) {
+            return parseDeclaration();
+        } else if (esClave("if")) {
+            return parseIf();
+        } else if (esClave("while")) {
+            return parseWhile();
+        } else if (esClave("return")) {
+            return parseReturn();
+        } else {
+            return parseAssignment();
+        }
+    }
+
+    ASTNode* parseDeclaration() {
+        IdNombre tipo = internar(valorActual());
+        avanzar();
+        if (actual().type == TokenType::IDENTIFIER) {
+            IdNombre varName = internar(valorActual());
+            avanzar();
+            if (esSimbolo("=")) {
+                avanzar();
+                // Como en C, la variable ya es visible en su propio inicializador
+                declaradas.push_back({varName, tipo});
+                auto value = parseExpression();
+                if (value && esSimbolo(";")) {
+                    avanzar();
+                    return arena.crear<Assign>(varName, value, tipo);
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    ASTNode* parseIf() {
+        avanzar();
+        if (esSimbolo("(")) {
+            avanzar();
+            auto condition = parseExpression();
+            if (condition && esSimbolo(")")) {
+                avanzar();
+                if (esSimbolo("{")) {
+                    avanzar();
+                    ListaNodos thenBody;
+                    if (!parseBloque(thenBody)) {
+                        return nullptr;
+                    }
+                    ListaNodos elseBody;
+                    if (esClave("else")) {
+                        avanzar();
+                        if (!esSimbolo("{")) {
+                            return nullptr;
+                        }
+                        avanzar();
+                        if (!parseBloque(elseBody)) {
+                            return nullptr;
+                        }
+                    }
+                    return arena.crear<If>(condition, thenBody, elseBody);
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    ASTNode* parseWhile() {
+        avanzar();
+        if (esSimbolo("(")) {
+            avanzar();
+            auto condition = parseExpression();
+            if (condition && esSimbolo(")")) {
+                avanzar();
+                if (esSimbolo("{")) {
+                    avanzar();
+                    ListaNodos body;
+                    if (parseBloque(body)) {
+                        return arena.crear<While>(condition, body);
+                    }
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    ASTNode* parseReturn() {
+        avanzar();
+        auto value = parseExpression();
+        if (value && esSimbolo(";")) {
+            avanzar();
+            return arena.crear<Return>(value);
+        }
+        return nullptr;
+    }
+
+    ASTNode* parseAssignment() {
+        if (actual().type == TokenType::IDENTIFIER) {
+            IdNombre varName = internar(valorActual());
+            avanzar();
+            if (esSimbolo("=")) {
+                avanzar();
+                auto value = parseExpression();
+                if (value && esSimbolo(";")) {
+                    avanzar();
+                    return arena.crear<Assign>(varName, value);
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    ASTNode* parseExpression() {
+        return parseBinaryOp(1);
+    }
+
+    // Precedencia por escalada: solo continúa mientras el token actual sea un operador binario
+    ASTNode* parseBinaryOp(int minPrecedence) {
+        auto left = parseUnary();
+        while (left && actual().type == TokenType::SYMBOL) {
+            int precedence = getPrecedence(valorActual());
+            if (precedence == 0 || precedence < minPrecedence) {
+                break;
+            }
+            IdNombre op = internar(valorActual());
+            avanzar();
+            auto right = parseBinaryOp(precedence + 1);
+            if (!right) {
+                return nullptr;
+            }
+            left = arena.crear<BinaryOp>(op, left, right);
+        }
+        return left;
+    }
+
+    ASTNode* parseUnary() {
+        if (esSimbolo("-")) {
+            avanzar();
+            auto node = parsePrimary();
+            if (!node) {
+                return nullptr;
+            }
+            return arena.crear<UnaryOp>(N_MENOS, node);
+        }
+        return parsePrimary();
+    }
+
+    ASTNode* parsePrimary() {
+        if (actual().type == TokenType::NUMBER) {
+            int64_t valor;
+            if (!leerEntero(valorActual(), valor)) {
+                fueraDeRango = true;
+                return nullptr;
+            }
+            IdNombre value = internar(valorActual());
+            avanzar();
+            return arena.crear<Literal>(value, N_INT);
+        } else if (actual().type == TokenType::IDENTIFIER) {
+            // Una cadena entre comillas llega como identificador; un nombre toma el tipo de su declaración
+            IdNombre value = internar(valorActual());
+            IdNombre tipo = valorActual().front() == '"' ? N_STRING : tipoDeclarado(value);
+            avanzar();
+            return arena.crear<Literal>(value, tipo);
+        } else if (esSimbolo("(")) {
+            avanzar();
+            auto node = parseExpression();
+            if (node && esSimbolo(")")) {
+                avanzar();
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    int getPrecedence(string_view op) const {
+        if (op == "||") return 1;
+        if (op == "&&") return 2;
+        if (op == "==" || op == "!=") return 3;
+        if (op == "<" || op == ">" || op == "<=" || op == ">=") return 4;
+        if (op == "+" || op == "-") return 5;
+        if (op == "*" || op == "/" || op == "%") return 6;
+        return 0;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Objeto compilado: formato binario que se proyecta en memoria sin analizarlo
+// ---------------------------------------------------------------------------
+
+// Diseño del archivo, todo en el orden de bytes de la máquina y alineado a 8:
+//   cabecera | cadenas | constantes | símbolos | bytecode | código máquina
+// La cabecera dice dónde empieza y cuánto mide cada sección; cada sección es un
+// arreglo de estructuras de tamaño fijo que se usa tal cual desde la proyección.
+
+// Texto dentro de la sección de cadenas
+struct CadenaObjeto {
+    uint32_t desplazamiento;
+    uint32_t longitud;
+};
+
+// Valor inicial de un registro de la máquina virtual; sin cadena, desplazamiento es NINGUNA
+struct ConstanteObjeto {
+    static constexpr uint32_t NINGUNA = UINT32_MAX;
+
+    int64_t entero;
+    CadenaObjeto cadena;
+};
+
+struct SimboloObjeto {
+    CadenaObjeto nombre;
+    CadenaObjeto tipo;
+    CadenaObjeto ambito;
+    uint32_t registro;     // registro de la máquina virtual, o NINGUNO si la variable desapareció
+    uint32_t esFuncion;
+
+    static constexpr uint32_t NINGUNO = UINT32_MAX;
+};
+
+enum class SeccionObjeto : uint8_t { CADENAS, CONSTANTES, SIMBOLOS, BYTECODE, MAQUINA, CANTIDAD };
+
+struct CabeceraObjeto {
+    static constexpr char MAGIA[4] = {'C', 'M', 'P', 'O'};
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint8_t DEVUELVE_CADENA = 1;   // el código máquina devuelve un índice de constante
+
+    char magia[4];
+    uint16_t version;
+    uint8_t nivel;       // nivel de optimización con que se compiló
+    uint8_t banderas;
+    struct {
+        uint64_t desplazamiento;
+        uint64_t bytes;
+    } secciones[static_cast<size_t>(SeccionObjeto::CANTIDAD)];
+};
+
+static_assert(sizeof(ConstanteObjeto) == 16 && sizeof(SimboloObjeto) == 32 && sizeof(CabeceraObjeto) == 88,
+              "Las estructuras del objeto no deben tener relleno que dependa del compilador");
+
+// Arma el objeto completo en un solo búfer para escribirlo de una vez
+vector<char> serializarObjeto(const ProgramaVM &programa, const vector<Simbolo> &simbolos, const vector<Funcion> &funciones,
+                              const vector<uint8_t> &maquina, int nivel, bool devuelveCadena) {
+    // Cada texto se guarda una sola vez
+    string cadenas;
+    unordered_map<IdNombre, CadenaObjeto> guardadas;
+    auto cadena = [&](IdNombre id) {
+        auto [it, nueva] = guardadas.try_emplace(id);
+        if (nueva) {
+            string_view texto = nombreDe(id);
+            it->second = {static_cast<uint32_t>(cadenas.size()), static_cast<uint32_t>(texto.size())};
+            cadenas.append(texto);
+        }
+        return it->second;
+    };
+
+    vector<ConstanteObjeto> constantes;
+    constantes.reserve(programa.registrosIniciales.size());
+    for (const Constante &c : programa.registrosIniciales) {
+        constantes.push_back({c.entero, c.cadena != N_VACIO ? cadena(c.cadena) : CadenaObjeto{ConstanteObjeto::NINGUNA, 0}});
+    }
+
+    unordered_map<IdNombre, uint32_t> registroDe(programa.variables.begin(), programa.variables.end());
+    vector<SimboloObjeto> tabla;
+    tabla.reserve(simbolos.size() + funciones.size());
+    for (const Simbolo &s : simbolos) {
+        auto it = registroDe.find(s.ranura);
+        tabla.push_back({cadena(s.variable), cadena(s.tipo), cadena(s.ambito), it != registroDe.end() ? it->second : SimboloObjeto::NINGUNO, 0});
+    }
+    for (const Funcion &f : funciones) {
+        tabla.push_back({cadena(f.nombre), cadena(f.tipo), cadena(N_GLOBAL), SimboloObjeto::NINGUNO, 1});
+    }
+
+    CabeceraObjeto cabecera{};
+    memcpy(cabecera.magia, CabeceraObjeto::MAGIA, sizeof cabecera.magia);
+    cabecera.version = CabeceraObjeto::VERSION;
+    cabecera.nivel = static_cast<uint8_t>(nivel);
+    cabecera.banderas = devuelveCadena ? CabeceraObjeto::DEVUELVE_CADENA : 0;
+
+    const pair<const void *, size_t> contenidos[] = {
+        {cadenas.data(), cadenas.size()},
+        {constantes.data(), constantes.size() * sizeof(ConstanteObjeto)},
+        {tabla.data(), tabla.size() * sizeof(SimboloObjeto)},
+        {programa.codigo.data(), programa.codigo.size() * sizeof(InstruccionVM)},
+        {maquina.data(), maquina.size()},
+    };
+    size_t total = sizeof(CabeceraObjeto);
+    for (size_t s = 0; s < size(contenidos); s++) {
+        total = (total + 7) & ~size_t{7};
+        cabecera.secciones[s] = {total, contenidos[s].second};
+        total += contenidos[s].second;
+    }
+
+    vector<char> bufer(total, 0);
+    memcpy(bufer.data(), &cabecera, sizeof cabecera);
+    for (size_t s = 0; s < size(contenidos); s++) {
+        if (contenidos[s].second > 0) memcpy(bufer.data() + cabecera.secciones[s].desplazamiento, contenidos[s].first, contenidos[s].second);
+    }
+    return bufer;
+}
+
+// Objeto abierto para leer. El archivo se proyecta en memoria y las secciones se
+// usan en el lugar; abrir solo verifica la cabecera y que las secciones quepan.
+class ObjetoCompilado {
+public:
+    // Devuelve false si el archivo no existe, no es un objeto de esta versión o alguna de
+    // sus referencias (cadenas, registros, saltos) cae fuera de su sección
+    bool abrir(const string &ruta) {
+        if (!fuente.abrir(ruta)) {
+            return false;
+        }
+        string_view datos = fuente.contenido();
+        if (datos.size() < sizeof(CabeceraObjeto)) {
+            return false;
+        }
+        cabecera = reinterpret_cast<const CabeceraObjeto *>(datos.data());
+        if (memcmp(cabecera->magia, CabeceraObjeto::MAGIA, sizeof cabecera->magia) != 0 || cabecera->version != CabeceraObjeto::VERSION) {
+            return false;
+        }
+        for (const auto &seccion : cabecera->secciones) {
+            if (seccion.desplazamiento % 8 != 0 || seccion.desplazamiento > datos.size() || seccion.bytes > datos.size() - seccion.desplazamiento) {
+                return false;
+            }
+        }
+        return validar();
+    }
+
+    int nivel() const { return cabecera->nivel; }
+    bool devuelveCadena() const { return cabecera->banderas & CabeceraObjeto::DEVUELVE_CADENA; }
+    size_t bytes() const { return fuente.contenido().size(); }
+
+    template <typename T>
+    pair<const T *, size_t> seccion(SeccionObjeto s) const {
+        const auto &entrada = cabecera->secciones[static_cast<size_t>(s)];
+        return {reinterpret_cast<const T *>(fuente.contenido().data() + entrada.desplazamiento), entrada.bytes / sizeof(T)};
+    }
+
+    string_view texto(CadenaObjeto c) const {
+        auto [cadenas, tamano] = seccion<char>(SeccionObjeto::CADENAS);
+        return string_view(cadenas, tamano).substr(c.desplazamiento, c.longitud);
+    }
+
+    // Registros iniciales para la máquina virtual. Las cadenas se internan aquí porque
+    // los ids de nombre solo valen dentro de un proceso; los enteros se copian tal cual.
+    vector<Constante> registrosIniciales() const {
+        auto [constantes, cantidad] = seccion<ConstanteObjeto>(SeccionObjeto::CONSTANTES);
+        vector<Constante> registros(cantidad);
+        for (size_t i = 0; i < cantidad; i++) {
+            const ConstanteObjeto &c = constantes[i];
+            registros[i] = {c.entero, c.cadena.desplazamiento == ConstanteObjeto::NINGUNA ? N_VACIO : internar(texto(c.cadena))};
+        }
+        return registros;
+    }
+
+private:
+    Fuente fuente;
+    const CabeceraObjeto *cabecera = nullptr;
+
+    // Se revisa una sola vez al abrir, para que la máquina virtual y texto() puedan
+    // confiar en los índices sin comprobarlos en cada uso
+    bool validar() const {
+        size_t bytesCadenas = cabecera->secciones[static_cast<size_t>(SeccionObjeto::CADENAS)].bytes;
+        auto cadenaValida = [&](CadenaObjeto c) {
+            return c.desplazamiento <= bytesCadenas && c.longitud <= bytesCadenas - c.desplazamiento;
+        };
+        auto [constantes, registros] = seccion<ConstanteObjeto>(SeccionObjeto::CONSTANTES);
+        for (size_t i = 0; i < registros; i++) {
+            if (constantes[i].cadena.desplazamiento != ConstanteObjeto::NINGUNA && !cadenaValida(constantes[i].cadena)) {
+                return false;
+            }
+        }
+        auto [simbolos, cantidadSimbolos] = seccion<SimboloObjeto>(SeccionObjeto::SIMBOLOS);
+        for (size_t i = 0; i < cantidadSimbolos; i++) {
+            const SimboloObjeto &simbolo = simbolos[i];
+            if (!cadenaValida(simbolo.nombre) || !cadenaValida(simbolo.tipo) || !cadenaValida(simbolo.ambito) ||
+                (simbolo.registro != SimboloObjeto::NINGUNO && simbolo.registro >= registros)) {
+                return false;
+            }
+        }
+
+        // Cada registro existe, cada salto cae en una instrucción y la última es FIN, así
+        // que la ejecución nunca sale del bytecode
+        auto [codigo, instrucciones] = seccion<InstruccionVM>(SeccionObjeto::BYTECODE);
+        if (instrucciones > 0 && codigo[instrucciones - 1].op != OpVM::FIN) {
+            return false;
+        }
+        for (size_t i = 0; i < instrucciones; i++) {
+            const InstruccionVM &instruccion = codigo[i];
+            if (instruccion.op > OpVM::FIN) {
+                return false;
+            }
+            bool salta = instruccion.op >= OpVM::SALTAR && instruccion.op <= OpVM::SALTAR_DISTINTO;
+            if ((salta ? instruccion.a >= instrucciones : instruccion.a >= registros) || instruccion.b >= registros || instruccion.c >= registros) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Escribe el objeto con una sola llamada; devuelve los bytes escritos o 0 si falló
+size_t escribirObjeto(const string &ruta, const vector<char> &bufer) {
+    ofstream archivo(ruta, ios::binary | ios::trunc);
+    if (!archivo.is_open() || !archivo.write(bufer.data(), static_cast<streamsize>(bufer.size()))) {
+        return 0;
+    }
+    return bufer.size();
+}
+
+// ---------------------------------------------------------------------------
+// Caché de compilación: tabla de símbolos y TAC de las fuentes ya compiladas
+// ---------------------------------------------------------------------------
+
+// Tamaño máximo de la caché si no se indica otro con --cache-max
+constexpr uint64_t LIMITE_CACHE = 64ull << 20;
+
+// Identifica la compilación del compilador que escribió una entrada. Cambia cada vez que
+// se vuelve a compilar el compilador, así que nunca se usa un TAC de otra versión.
+constexpr string_view VERSION_COMPILADOR = "compilador " __DATE__ " " __TIME__;
+
+// Hash de 64 bits que avanza ocho bytes por paso. No es criptográfico: solo tiene que
+// distinguir una versión de un archivo de otra.
+inline uint64_t hashContenido(string_view texto, uint64_t semilla = 0) {
+    constexpr uint64_t K1 = 0x9E3779B97F4A7C15ull, K2 = 0xC2B2AE3D27D4EB4Full;
+    auto mezclar = [&](uint64_t h, uint64_t palabra) {
+        h ^= palabra * K2;
+        return ((h << 31) | (h >> 33)) * K1;
+    };
+    uint64_t h = semilla ^ (texto.size() * K1);
+    size_t i = 0;
+    for (; i + 8 <= texto.size(); i += 8) {
+        uint64_t palabra;
+        memcpy(&palabra, texto.data() + i, 8);
+        h = mezclar(h, palabra);
+    }
+    uint64_t resto = 0;
+    memcpy(&resto, texto.data() + i, texto.size() - i);
+    h = mezclar(h, resto);
+    // Mezcla final: cualquier bit de la entrada afecta a todos los de la salida
+    h ^= h >> 33;
+    h *= K2;
+    h ^= h >> 29;
+    h *= K1;
+    return h ^ (h >> 32);
+}
+
+// Diseño de una entrada, alineada a 8 como el objeto compilado:
+//   cabecera | nombres | texto de los nombres | símbolos | funciones | ops | destinos | args1 | args2 | constantes
+// Los ids de nombre solo valen dentro de un proceso, así que símbolos, variables y
+// constantes de cadena guardan posiciones en la tabla de nombres de la entrada.
+struct CabeceraCache {
+    static constexpr char MAGIA[4] = {'C', 'M', 'P', 'C'};
+    static constexpr uint16_t VERSION = 2;
+
+    char magia[4];
+    uint16_t version;
+    uint8_t nivel;
+    uint8_t relleno;
+    uint64_t clave;
+    uint64_t bytesFuente;
+    uint64_t tokens;
+    uint32_t nombres;
+    uint32_t bytesNombres;
+    uint32_t simbolos;
+    uint32_t funciones;
+    uint32_t instrucciones;
+    uint32_t constantes;
+    uint32_t temporales;
+    uint32_t etiquetas;
+};
+
+struct ConstanteCache {
+    int64_t entero;
+    uint32_t cadena;   // posición en la tabla de nombres, o NINGUNA
+    uint32_t relleno;
+
+    static constexpr uint32_t NINGUNA = UINT32_MAX;
+};
+
+static_assert(sizeof(CabeceraCache) == 64 && sizeof(ConstanteCache) == 16,
+              "Las estructuras de la caché no deben tener relleno que dependa del compilador");
+
+// Lo que guarda la caché de una fuente: lo necesario para seguir desde el TAC sin
+// volver a leer, analizar ni generar
+struct EntradaCache {
+    size_t tokens = 0;
+    vector<Simbolo> simbolos;
+    vector<Funcion> funciones;
+    CodigoTAC tac;
+};
+
+// Caché en disco con un archivo por entrada, llamado como su clave. La clave combina el
+// contenido de la fuente, la versión del compilador y el nivel de optimización. Cuando los
+// archivos pasan del límite de bytes se borran los usados hace más tiempo; el uso se anota
+// en la fecha de modificación, así que el orden se conserva entre ejecuciones. Se puede
+// usar desde varios hilos a la vez: cada entrada se escribe en un temporal y se renombra.
+class CacheCompilacion {
+public:
+    struct Estadisticas {
+        size_t aciertos = 0;
+        size_t fallos = 0;
+        size_t guardadas = 0;
+        size_t desalojadas = 0;
+    };
+
+    CacheCompilacion(string directorio, uint64_t limiteBytes) : directorio(move(directorio)), limite(limiteBytes) {
+        error_code error;
+        filesystem::create_directories(this->directorio, error);
+        // Las entradas existentes entran al índice de la más vieja a la más reciente
+        vector<pair<filesystem::file_time_type, uint64_t>> existentes;
+        for (const auto &archivo : filesystem::directory_iterator(this->directorio, error)) {
+            const filesystem::path &ruta = archivo.path();
+            if (ruta.extension() != ".cache" || !archivo.is_regular_file(error)) {
+                continue;
+            }
+            uint64_t clave = strtoull(ruta.stem().string().c_str(), nullptr, 16);
+            existentes.push_back({archivo.last_write_time(error), clave});
+            indice[clave].bytes = archivo.file_size(error);
+            ocupados += indice[clave].bytes;
+        }
+        sort(existentes.begin(), existentes.end());
+        for (auto [fecha, clave] : existentes) {
+            usar(clave);
+        }
+        // El límite pudo haber bajado desde la ejecución anterior
+        desalojar();
+    }
+
+    static uint64_t clave(string_view fuente, int nivel) {
+        return hashContenido(fuente, hashContenido(VERSION_COMPILADOR) + static_cast<uint64_t>(nivel));
+    }
+
+    // Carga la entrada de esa fuente; devuelve false si no está o no es válida
+    bool buscar(uint64_t clave, size_t bytesFuente, int nivel, EntradaCache &entrada) {
+        Fuente archivo;
+        bool ok = archivo.abrir(rutaDe(clave)) && leer(archivo.contenido(), clave, bytesFuente, nivel, entrada);
+        lock_guard<mutex> guardia(candado);
+        if (!ok) {
+            cuentas.fallos++;
+            return false;
+        }
+        cuentas.aciertos++;
+        usar(clave);
+        error_code error;
+        filesystem::last_write_time(rutaDe(clave), filesystem::file_time_type::clock::now(), error);
+        return true;
+    }
+
+    void guardar(uint64_t clave, size_t bytesFuente, int nivel, const EntradaCache &entrada) {
+        vector<char> bufer = serializar(clave, bytesFuente, nivel, entrada);
+        string ruta = rutaDe(clave);
+        // Único por proceso e hilo: otro compilador puede estar guardando la misma clave
+#ifdef _WIN32
+        uint64_t proceso = GetCurrentProcessId();
+#else
+        uint64_t proceso = static_cast<uint64_t>(getpid());
+#endif
+        string temporal = ruta + "." + to_string(proceso) + "." + to_string(hash<thread::id>{}(this_thread::get_id())) + ".tmp";
+        error_code error;
+        if (escribirObjeto(temporal, bufer) == 0) {
+            filesystem::remove(temporal, error);
+            return;
+        }
+        filesystem::rename(temporal, ruta, error);
+        if (error) {
+            filesystem::remove(temporal, error);
+            return;
+        }
+        lock_guard<mutex> guardia(candado);
+        Archivo &registro = indice[clave];
+        ocupados += bufer.size() - registro.bytes;
+        registro.bytes = bufer.size();
+        usar(clave);
+        cuentas.guardadas++;
+        desalojar();
+    }
+
+    void imprimirEstadisticas(ostream &salida) const {
+        lock_guard<mutex> guardia(candado);
+        salida << "Caché '" << directorio << "': " << cuentas.aciertos << " aciertos, " << cuentas.fallos << " fallos, "
+               << cuentas.guardadas << " guardadas, " << cuentas.desalojadas << " desalojadas; " << indice.size()
+               << " entradas, " << ocupados << " de " << limite << " bytes" << endl;
+    }
+
+private:
+    struct Archivo {
+        uint64_t bytes = 0;
+        uint64_t uso = 0;   // momento del último uso; 0 si todavía no se usó
+    };
+
+    string directorio;
+    uint64_t limite;
+    mutable mutex candado;
+    unordered_map<uint64_t, Archivo> indice;
+    map<uint64_t, uint64_t> porUso;   // momento del último uso -> clave, del más viejo al más nuevo
+    uint64_t reloj = 0;
+    uint64_t ocupados = 0;
+    Estadisticas cuentas;
+
+    string rutaDe(uint64_t clave) const {
+        char nombre[24];
+        snprintf(nombre, sizeof nombre, "%016llx.cache", static_cast<unsigned long long>(clave));
+        return (filesystem::path(directorio) / nombre).string();
+    }
+
+    void usar(uint64_t clave) {
+        Archivo &registro = indice[clave];
+        if (registro.uso != 0) {
+            porUso.erase(registro.uso);
+        }
+        registro.uso = ++reloj;
+        porUso[registro.uso] = clave;
+    }
+
+    // Borra las entradas menos usadas hasta volver a estar dentro del límite
+    void desalojar() {
+        while (ocupados > limite && !porUso.empty()) {
+            uint64_t clave = porUso.begin()->second;
+            porUso.erase(porUso.begin());
+            ocupados -= indice[clave].bytes;
+            indice.erase(clave);
+            error_code error;
+            filesystem::remove(rutaDe(clave), error);
+            cuentas.desalojadas++;
+        }
+    }
+
+    static vector<char> serializar(uint64_t clave, size_t bytesFuente, int nivel, const EntradaCache &entrada) {
+        // Cada nombre se guarda una sola vez
+        vector<CadenaObjeto> nombres;
+        string texto;
+        unordered_map<IdNombre, uint32_t> posicion;
+        auto nombre = [&](IdNombre id) {
+            auto [it, nuevo] = posicion.try_emplace(id, static_cast<uint32_t>(nombres.size()));
+            if (nuevo) {
+                string_view valor = nombreDe(id);
+                nombres.push_back({static_cast<uint32_t>(texto.size()), static_cast<uint32_t>(valor.size())});
+                texto.append(valor);
+            }
+            return it->second;
+        };
+
+        const CodigoTAC &tac = entrada.tac;
+        vector<uint32_t> simbolos, funciones;
+        for (const Simbolo &s : entrada.simbolos) {
+            simbolos.insert(simbolos.end(), {nombre(s.variable), nombre(s.tipo), nombre(s.ambito), nombre(s.ranura)});
+        }
+        for (const Funcion &f : entrada.funciones) {
+            funciones.insert(funciones.end(), {nombre(f.nombre), nombre(f.tipo)});
+        }
+        auto conNombres = [&](const vector<Operando> &operandos) {
+            vector<Operando> resultado(operandos);
+            for (Operando &o : resultado) {
+                if (!o.vacio() && o.clase() == Operando::VARIABLE) {
+                    o = Operando::crear(Operando::VARIABLE, nombre(o.indice()));
+                }
+            }
+            return resultado;
+        };
+        vector<Operando> destinos = conNombres(tac.destinos), args1 = conNombres(tac.args1), args2 = conNombres(tac.args2);
+        vector<ConstanteCache> constantes;
+        for (const Constante &c : tac.constantes) {
+            constantes.push_back({c.entero, c.cadena != N_VACIO ? nombre(c.cadena) : ConstanteCache::NINGUNA, 0});
+        }
+
+        CabeceraCache cabecera{};
+        memcpy(cabecera.magia, CabeceraCache::MAGIA, sizeof cabecera.magia);
+        cabecera.version = CabeceraCache::VERSION;
+        cabecera.nivel = static_cast<uint8_t>(nivel);
+        cabecera.clave = clave;
+        cabecera.bytesFuente = bytesFuente;
+        cabecera.tokens = entrada.tokens;
+        cabecera.nombres = static_cast<uint32_t>(nombres.size());
+        cabecera.bytesNombres = static_cast<uint32_t>(texto.size());
+        cabecera.simbolos = static_cast<uint32_t>(entrada.simbolos.size());
+        cabecera.funciones = static_cast<uint32_t>(entrada.funciones.size());
+        cabecera.instrucciones = static_cast<uint32_t>(tac.size());
+        cabecera.constantes = static_cast<uint32_t>(constantes.size());
+        cabecera.temporales = tac.temporales;
+        cabecera.etiquetas = tac.etiquetas;
+
+        vector<char> bufer;
+        auto agregar = [&](const void *datos, size_t bytes) {
+            const char *inicio = static_cast<const char *>(datos);
+            bufer.insert(bufer.end(), inicio, inicio + bytes);
+            bufer.resize((bufer.size() + 7) & ~size_t{7}, 0);
+        };
+        agregar(&cabecera, sizeof cabecera);
+        agregar(nombres.data(), nombres.size() * sizeof(CadenaObjeto));
+        agregar(texto.data(), texto.size());
+        agregar(simbolos.data(), simbolos.size() * sizeof(uint32_t));
+        agregar(funciones.data(), funciones.size() * sizeof(uint32_t));
+        agregar(tac.ops.data(), tac.ops.size() * sizeof(OpTAC));
+        agregar(destinos.data(), destinos.size() * sizeof(Operando));
+        agregar(args1.data(), args1.size() * sizeof(Operando));
+        agregar(args2.data(), args2.size() * sizeof(Operando));
+        agregar(constantes.data(), constantes.size() * sizeof(ConstanteCache));
+        return bufer;
+    }
+
+    // Reconstruye la entrada; descarta archivos truncados, de otra versión, de otra fuente
+    // o con índices que no apuntan a nada. Una entrada dañada nunca llega a las pasadas.
+    static bool leer(string_view datos, uint64_t clave, size_t bytesFuente, int nivel, EntradaCache &entrada) {
+        if (datos.size() < sizeof(CabeceraCache)) {
+            return false;
+        }
+        CabeceraCache cabecera;
+        memcpy(&cabecera, datos.data(), sizeof cabecera);
+        if (memcmp(cabecera.magia, CabeceraCache::MAGIA, sizeof cabecera.magia) != 0 || cabecera.version != CabeceraCache::VERSION ||
+            cabecera.clave != clave || cabecera.bytesFuente != bytesFuente || cabecera.nivel != nivel) {
+            return false;
+        }
+
+        size_t posicion = sizeof(CabeceraCache);
+        bool completo = true;
+        auto seccion = [&](auto *destino, size_t cantidad) {
+            size_t bytes = cantidad * sizeof(*destino);
+            if (!completo || bytes > datos.size() - posicion) {
+                completo = false;
+                return;
+            }
+            if (bytes > 0) memcpy(destino, datos.data() + posicion, bytes);
+            posicion = min(datos.size(), (posicion + bytes + 7) & ~size_t{7});
+        };
+        // Las cantidades de la cabecera no reservan memoria hasta saber que sus bytes están
+        auto alineado = [](uint64_t bytes) { return (bytes + 7) & ~uint64_t{7}; };
+        uint64_t necesarios = alineado(uint64_t{cabecera.nombres} * sizeof(CadenaObjeto)) + alineado(cabecera.bytesNombres) +
+                              alineado(uint64_t{cabecera.simbolos} * 4 * sizeof(uint32_t)) + alineado(uint64_t{cabecera.funciones} * 2 * sizeof(uint32_t)) +
+                              alineado(uint64_t{cabecera.instrucciones} * sizeof(OpTAC)) + 3 * alineado(uint64_t{cabecera.instrucciones} * sizeof(Operando)) +
+                              alineado(uint64_t{cabecera.constantes} * sizeof(ConstanteCache));
+        if (necesarios > datos.size() - posicion) {
+            return false;
+        }
+        // El TAC guardado es el del generador: cada temporal y cada etiqueta nace con una
+        // instrucción, y las pasadas reservan memoria según estas dos cantidades
+        if (cabecera.temporales > cabecera.instrucciones || cabecera.etiquetas > cabecera.instrucciones) {
+            return false;
+        }
+        vector<CadenaObjeto> nombres(cabecera.nombres);
+        string texto(cabecera.bytesNombres, '\0');
+        vector<uint32_t> simbolos(size_t{4} * cabecera.simbolos), funciones(size_t{2} * cabecera.funciones);
+        CodigoTAC &tac = entrada.tac;
+        tac = CodigoTAC();
+        tac.ops.resize(cabecera.instrucciones);
+        tac.destinos.resize(cabecera.instrucciones);
+        tac.args1.resize(cabecera.instrucciones);
+        tac.args2.resize(cabecera.instrucciones);
+        vector<ConstanteCache> constantes(cabecera.constantes);
+        seccion(nombres.data(), nombres.size());
+        seccion(texto.data(), texto.size());
+        seccion(simbolos.data(), simbolos.size());
+        seccion(funciones.data(), funciones.size());
+        seccion(tac.ops.data(), tac.ops.size());
+        seccion(tac.destinos.data(), tac.destinos.size());
+        seccion(tac.args1.data(), tac.args1.size());
+        seccion(tac.args2.data(), tac.args2.size());
+        seccion(constantes.data(), constantes.size());
+        if (!completo) {
+            return false;
+        }
+
+        // Cada operación existe y cada operando cae dentro de lo que declara la cabecera; las
+        // etiquetas solo aparecen como destino de ETIQUETA y de los saltos
+        for (size_t i = 0; i < tac.size(); i++) {
+            OpTAC op = tac.ops[i];
+            if (op > OpTAC::RETORNAR) {
+                return false;
+            }
+            bool conEtiqueta = op == OpTAC::ETIQUETA || op == OpTAC::SALTAR || op == OpTAC::SALTAR_SI || op == OpTAC::SALTAR_SI_NO;
+            auto esEtiqueta = [](Operando o) { return !o.vacio() && o.clase() == Operando::ETIQUETA; };
+            if (conEtiqueta != esEtiqueta(tac.destinos[i]) || esEtiqueta(tac.args1[i]) || esEtiqueta(tac.args2[i])) {
+                return false;
+            }
+            for (Operando o : {tac.destinos[i], tac.args1[i], tac.args2[i]}) {
+                if (o.vacio()) continue;
+                uint64_t limite = o.clase() == Operando::TEMPORAL ? cabecera.temporales
+                                : o.clase() == Operando::VARIABLE ? nombres.size()
+                                : o.clase() == Operando::CONSTANTE ? constantes.size()
+                                : cabecera.etiquetas;
+                if (o.indice() >= limite) {
+                    return false;
+                }
+            }
+        }
+        // Cada etiqueta se define una sola vez y cada salto va a una definida
+        vector<uint8_t> definida(cabecera.etiquetas, 0);
+        for (size_t i = 0; i < tac.size(); i++) {
+            if (tac.ops[i] == OpTAC::ETIQUETA && definida[tac.destinos[i].indice()]++) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < tac.size(); i++) {
+            if (tac.ops[i] != OpTAC::ETIQUETA && !tac.destinos[i].vacio() && tac.destinos[i].clase() == Operando::ETIQUETA &&
+                !definida[tac.destinos[i].indice()]) {
+                return false;
+            }
+        }
+        auto nombreValido = [&](uint32_t i) { return i < nombres.size(); };
+        if (!all_of(simbolos.begin(), simbolos.end(), nombreValido) || !all_of(funciones.begin(), funciones.end(), nombreValido)) {
+            return false;
+        }
+        for (const ConstanteCache &c : constantes) {
+            if (c.cadena != ConstanteCache::NINGUNA && !nombreValido(c.cadena)) {
+                return false;
+            }
+        }
+
+        // Los nombres se vuelven a internar en este proceso
+        vector<IdNombre> ids;
+        ids.reserve(nombres.size());
+        for (const CadenaObjeto &c : nombres) {
+            if (c.desplazamiento > texto.size() || c.longitud > texto.size() - c.desplazamiento) {
+                return false;
+            }
+            ids.push_back(internar(string_view(texto).substr(c.desplazamiento, c.longitud)));
+        }
+        auto id = [&](uint32_t i) { return ids[i]; };   // índices ya validados
+        entrada.tokens = cabecera.tokens;
+        entrada.simbolos.clear();
+        for (size_t i = 0; i < simbolos.size(); i += 4) {
+            entrada.simbolos.push_back({id(simbolos[i]), id(simbolos[i + 1]), id(simbolos[i + 2]), id(simbolos[i + 3])});
+        }
+        entrada.funciones.clear();
+        for (size_t i = 0; i < funciones.size(); i += 2) {
+            entrada.funciones.push_back({id(funciones[i]), id(funciones[i + 1])});
+        }
+        for (vector<Operando> *operandos : {&tac.destinos, &tac.args1, &tac.args2}) {
+            for (Operando &o : *operandos) {
+                if (!o.vacio() && o.clase() == Operando::VARIABLE) {
+                    o = Operando::variable(id(o.indice()));
+                }
+            }
+        }
+        // Las constantes se agregan en el mismo orden para que conserven su posición
+        for (const ConstanteCache &c : constantes) {
+            if (c.cadena != ConstanteCache::NINGUNA) {
+                tac.constanteCadena(id(c.cadena));
+            } else {
+                tac.constanteEntera(c.entero);
+            }
+        }
+        tac.temporales = cabecera.temporales;
+        tac.etiquetas = cabecera.etiquetas;
+        return tac.constantes.size() == constantes.size();
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Informe de fases (--stats): cuánto tardó cada fase y cuánto produjo
+// ---------------------------------------------------------------------------
 
-    // Verificar si es un símbolo
-    if (word.size() == 1 && string("+-*/%(){}=;").find(word) != string::npos) {
-        return TokenType::SYMBOL;
-    }
+constexpr size_t CANTIDAD_TIPOS_NODO = static_cast<size_t>(TipoNodo::UnaryOp) + 1;
 
-    // Por default, es un identificador
-    return TokenType::IDENTIFIER;
+// Nombre de cada clase de nodo, indexado por TipoNodo
+constexpr string_view NOMBRES_TIPO_NODO[CANTIDAD_TIPOS_NODO] = {
+    "FunctionDef", "Assign", "Literal", "Return", "If", "While", "BinaryOp", "UnaryOp"};
+
+// Suma los nodos del árbol según su clase
+void contarNodos(ASTNode *nodo, array<uint64_t, CANTIDAD_TIPOS_NODO> &cuentas) {
+    cuentas[static_cast<size_t>(nodo->tipo)]++;
+    auto bloque = [&cuentas](ListaNodos cuerpo) {
+        for (ASTNode *stmt : cuerpo) {
+            contarNodos(stmt, cuentas);
+        }
+    };
+    despachar(nodo, Sobrecarga{
+        [&](FunctionDef *func_def) { bloque(func_def->body); },
+        [&](Assign *assign) { contarNodos(assign->value, cuentas); },
+        [&](Return *return_stmt) { contarNodos(return_stmt->value, cuentas); },
+        [&](If *if_stmt) {
+            contarNodos(if_stmt->condition, cuentas);
+            bloque(if_stmt->then_body);
+            bloque(if_stmt->else_body);
+        },
+        [&](While *while_stmt) {
+            contarNodos(while_stmt->condition, cuentas);
+            bloque(while_stmt->body);
+        },
+        [&](BinaryOp *binary) {
+            contarNodos(binary->left, cuentas);
+            contarNodos(binary->right, cuentas);
+        },
+        [&](UnaryOp *unary) { contarNodos(unary->operand, cuentas); },
+        [](ASTNode *) {}
+    });
 }
 
-// Función para separar tokens considerando símbolos individuales
-vector<Token> tokenize(const string &line) {
-    vector<Token> tokens;
-    string word;
-    for (char ch : line) {
-        if (isspace(ch)) {
-            if (!word.empty()) {
-                tokens.push_back({identifyToken(word), word});
-                word.clear();
-            }
-        } else if (string("+-*/%(){}=;").find(ch) != string::npos) {
-            if (!word.empty()) {
-                tokens.push_back({identifyToken(word), word});
-                word.clear();
-            }
-            tokens.push_back({TokenType::SYMBOL, string(1, ch)});
+// Texto entre comillas con los escapes de JSON
+void escribirCadenaJSON(ostream &salida, string_view texto) {
+    salida << '"';
+    for (unsigned char c : texto) {
+        if (c == '"' || c == '\\') {
+            salida << '\\' << c;
+        } else if (c < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof escape, "\\u%04x", c);
+            salida << escape;
         } else {
-            word += ch;
+            salida << c;
         }
     }
-    if (!word.empty()) {
-        tokens.push_back({identifyToken(word), word});
-    }
-    return tokens;
+    salida << '"';
 }
 
-// Definición de clases del AST
-class ASTNode {
-public:
-    virtual ~ASTNode() = default;
-};
-
-class FunctionDef : public ASTNode {
+// Tiempos de las fases de una compilación, en el orden en que corrieron, y cuentas de
+// lo que produjeron. Medir cuesta dos lecturas del reloj por fase, así que se mide
+// siempre y solo se imprime si se pide. Cada cuenta tiene una clave para el JSON y una
+// descripción para la tabla.
+class InformeFases {
 public:
-    string name;
-    vector<string> args;
-    vector<shared_ptr<ASTNode>> body;
-    string return_type;
+    string archivo;
+    int nivel = 0;
 
-    FunctionDef(const string& name, const vector<string>& args, const vector<shared_ptr<ASTNode>>& body, const string& return_type)
-        : name(name), args(args), body(body), return_type(return_type) {}
-};
+    void empezar(string_view fase) {
+        actual = fase;
+        inicio = chrono::steady_clock::now();
+    }
 
-class Assign : public ASTNode {
-public:
-    string target;
-    shared_ptr<ASTNode> value;
+    // Cierra la fase abierta; devuelve lo que tardó en microsegundos
+    double terminar() {
+        double microsegundos = chrono::duration<double, micro>(chrono::steady_clock::now() - inicio).count();
+        fases.push_back({string(actual), microsegundos});
+        return microsegundos;
+    }
 
-    Assign(const string& target, shared_ptr<ASTNode> value) : target(target), value(value) {}
-};
+    void contar(string_view clave, string_view descripcion, uint64_t valor) {
+        cuentas.push_back({string(clave), string(descripcion), valor});
+    }
 
-class Literal : public ASTNode {
-public:
-    string value;
-    string type;
+    void contarNodosAST(ASTNode *ast) {
+        nodos.fill(0);
+        contarNodos(ast, nodos);
+        hayNodos = true;
+    }
 
-    Literal(const string& value, const string& type) : value(value), type(type) {}
-};
+    void imprimirTabla(ostream &salida) const {
+        double total = 0;
+        for (const Fase &f : fases) total += f.microsegundos;
+        salida << left << setw(34) << "Fase" << right << setw(14) << "µs" << setw(9) << "%" << '\n';
+        salida << fixed << setprecision(1);
+        for (const Fase &f : fases) {
+            // setw cuenta bytes: se compensan los de las letras acentuadas
+            salida << left << setw(34 + extraUTF8(f.nombre)) << f.nombre << right << setw(13) << f.microsegundos
+                   << setw(9) << (total > 0 ? 100 * f.microsegundos / total : 0) << '\n';
+        }
+        salida << left << setw(34) << "total" << right << setw(13) << total << setw(9) << 100.0 << '\n';
+        salida << defaultfloat;
 
-class Return : public ASTNode {
-public:
-    shared_ptr<ASTNode> value;
+        salida << left << setw(34) << "Cuenta" << right << setw(13) << "Valor" << '\n';
+        for (const Cuenta &c : cuentas) {
+            salida << left << setw(34 + extraUTF8(c.descripcion)) << c.descripcion << right << setw(13) << c.valor << '\n';
+        }
+        if (hayNodos) {
+            salida << left << setw(34) << "nodos del AST" << right << setw(13) << totalNodos() << '\n';
+            for (size_t k = 0; k < CANTIDAD_TIPOS_NODO; k++) {
+                salida << "  " << left << setw(32) << NOMBRES_TIPO_NODO[k] << right << setw(13) << nodos[k] << '\n';
+            }
+        }
+    }
 
-    Return(shared_ptr<ASTNode> value) : value(value) {}
-};
+    void imprimirJSON(ostream &salida) const {
+        double total = 0;
+        for (const Fase &f : fases) total += f.microsegundos;
+        salida << "{\n  \"archivo\": ";
+        escribirCadenaJSON(salida, archivo);
+        salida << ",\n  \"nivel\": " << nivel << ",\n  \"fases\": [";
+        salida << fixed << setprecision(1);
+        for (size_t i = 0; i < fases.size(); i++) {
+            salida << (i ? ",\n" : "\n") << "    {\"nombre\": ";
+            escribirCadenaJSON(salida, fases[i].nombre);
+            salida << ", \"microsegundos\": " << fases[i].microsegundos << "}";
+        }
+        salida << "\n  ],\n  \"total_microsegundos\": " << total << ",\n  \"cuentas\": {";
+        salida << defaultfloat;
+        for (size_t i = 0; i < cuentas.size(); i++) {
+            salida << (i ? ",\n" : "\n") << "    ";
+            escribirCadenaJSON(salida, cuentas[i].clave);
+            salida << ": " << cuentas[i].valor;
+        }
+        if (hayNodos) {
+            salida << (cuentas.empty() ? "\n" : ",\n") << "    \"nodos_ast\": {";
+            for (size_t k = 0; k < CANTIDAD_TIPOS_NODO; k++) {
+                salida << (k ? ", " : "");
+                escribirCadenaJSON(salida, NOMBRES_TIPO_NODO[k]);
+                salida << ": " << nodos[k];
+            }
+            salida << "}";
+        }
+        salida << "\n  }\n}\n";
+    }
 
-class If : public ASTNode {
-public:
-    shared_ptr<ASTNode> condition;
-    vector<shared_ptr<ASTNode>> then_body;
-    vector<shared_ptr<ASTNode>> else_body;
+private:
+    struct Fase {
+        string nombre;
+        double microsegundos;
+    };
+    struct Cuenta {
+        string clave;
+        string descripcion;
+        uint64_t valor;
+    };
 
-    If(shared_ptr<ASTNode> condition, const vector<shared_ptr<ASTNode>>& then_body, const vector<shared_ptr<ASTNode>>& else_body)
-        : condition(condition), then_body(then_body), else_body(else_body) {}
-};
+    vector<Fase> fases;
+    vector<Cuenta> cuentas;
+    array<uint64_t, CANTIDAD_TIPOS_NODO> nodos{};
+    bool hayNodos = false;
+    string_view actual;
+    chrono::steady_clock::time_point inicio;
 
-class While : public ASTNode {
-public:
-    shared_ptr<ASTNode> condition;
-    vector<shared_ptr<ASTNode>> body;
+    uint64_t totalNodos() const {
+        uint64_t total = 0;
+        for (uint64_t n : nodos) total += n;
+        return total;
+    }
 
-    While(shared_ptr<ASTNode> condition, const vector<shared_ptr<ASTNode>>& body)
-        : condition(condition), body(body) {}
+    // Bytes de más que ocupan los caracteres de varios bytes
+    static int extraUTF8(string_view texto) {
+        return static_cast<int>(count_if(texto.begin(), texto.end(), [](char c) { return (c & 0xC0) == 0x80; }));
+    }
 };
 
-// Estructura para representar instrucciones de TAC
-struct TAC {
-    string op;
-    string arg1;
-    string arg2;
-    string result;
-};
+// ---------------------------------------------------------------------------
+// Microbenchmark: tabla hash perfecta contra el recorrido lineal de un vector
+// ---------------------------------------------------------------------------
 
-// Función para imprimir el AST
-void imprimirAST(shared_ptr<ASTNode> nodo, int nivel = 0) {
-    if (auto func_def = dynamic_pointer_cast<FunctionDef>(nodo)) {
-        cout << string(nivel * 2, ' ') << "FunctionDef: " << func_def->name << " -> " << func_def->return_type << endl;
-        for (const auto& stmt : func_def->body) {
-            imprimirAST(stmt, nivel + 1);
-        }
-    } else if (auto assign = dynamic_pointer_cast<Assign>(nodo)) {
-        cout << string(nivel * 2, ' ') << "Assign: " << assign->target << " = ";
-        imprimirAST(assign->value, 0);
-    } else if (auto literal = dynamic_pointer_cast<Literal>(nodo)) {
-        cout << literal->value << " (" << literal->type << ")" << endl;
-    } else if (auto return_stmt = dynamic_pointer_cast<Return>(nodo)) {
-        cout << string(nivel * 2, ' ') << "Return: ";
-        imprimirAST(return_stmt->value, 0);
-    } else if (auto if_stmt = dynamic_pointer_cast<If>(nodo)) {
-        cout << string(nivel * 2, ' ') << "If: " << endl;
-        cout << string((nivel + 1) * 2, ' ') << "Condition: ";
-        imprimirAST(if_stmt->condition, 0);
-        cout << string((nivel + 1) * 2, ' ') << "Then: " << endl;
-        for (const auto& stmt : if_stmt->then_body) {
-            imprimirAST(stmt, nivel + 2);
-        }
-        if (!if_stmt->else_body.empty()) {
-            cout << string((nivel + 1) * 2, ' ') << "Else: " << endl;
-            for (const auto& stmt : if_stmt->else_body) {
-                imprimirAST(stmt, nivel + 2);
+// Versión anterior de la búsqueda: construye el vector en cada llamada y lo recorre
+bool esPalabraClaveLineal(const string &word) {
+    const vector<string> keywords(begin(PALABRAS_CLAVE), end(PALABRAS_CLAVE));
+    return find(keywords.begin(), keywords.end(), word) != keywords.end();
+}
+
+void benchmarkPalabrasClave(size_t cantidad) {
+    // Corpus determinista: ~20% palabras clave y el resto identificadores de longitud similar
+    mt19937 generador(12345);
+    uniform_int_distribution<size_t> elegirClave(0, size(PALABRAS_CLAVE) - 1);
+    uniform_int_distribution<int> longitud(1, 12);
+    uniform_int_distribution<int> letra(0, 26);
+    uniform_int_distribution<int> porcentaje(0, 99);
+    vector<string> corpus;
+    corpus.reserve(cantidad);
+    for (size_t i = 0; i < cantidad; i++) {
+        if (porcentaje(generador) < 20) {
+            corpus.emplace_back(PALABRAS_CLAVE[elegirClave(generador)]);
+        } else {
+            string palabra;
+            int n = longitud(generador);
+            for (int j = 0; j < n; j++) {
+                int c = letra(generador);
+                palabra += c == 26 ? '_' : static_cast<char>('a' + c);
             }
+            corpus.push_back(move(palabra));
         }
-    } else if (auto while_stmt = dynamic_pointer_cast<While>(nodo)) {
-        cout << string(nivel * 2, ' ') << "While: " << endl;
-        cout << string((nivel + 1) * 2, ' ') << "Condition: ";
-        imprimirAST(while_stmt->condition, 0);
-        cout << string((nivel + 1) * 2, ' ') << "Body: " << endl;
-        for (const auto& stmt : while_stmt->body) {
-            imprimirAST(stmt, nivel + 2);
+    }
+
+    auto medir = [&](auto &&esClave, size_t &encontradas) {
+        auto inicio = chrono::steady_clock::now();
+        encontradas = 0;
+        for (const string &palabra : corpus) {
+            encontradas += esClave(palabra);
         }
+        return chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    };
+
+    size_t clavesLineal = 0, clavesHash = 0;
+    double tiempoLineal = medir([](const string &p) { return esPalabraClaveLineal(p); }, clavesLineal);
+    double tiempoHash = medir([](const string &p) { return esPalabraClave(p); }, clavesHash);
+
+    cout << "Corpus: " << cantidad << " identificadores (" << clavesHash << " palabras clave)" << endl;
+    cout << fixed << setprecision(2);
+    cout << "Vector + búsqueda lineal: " << tiempoLineal * 1e9 / cantidad << " ns/palabra (" << tiempoLineal << " s)" << endl;
+    cout << "Hash perfecto:            " << tiempoHash * 1e9 / cantidad << " ns/palabra (" << tiempoHash << " s)" << endl;
+    cout << "Aceleración: " << tiempoLineal / tiempoHash << "x" << endl;
+    if (clavesLineal != clavesHash) {
+        cerr << "Error: las dos búsquedas no coinciden (" << clavesLineal << " != " << clavesHash << ")" << endl;
     }
 }
 
-// Estructuras para el analizador semántico
-struct Simbolo {
-    string variable;
-    string tipo;
-    string ambito;
-};
+// ---------------------------------------------------------------------------
+// Benchmark del analizador léxico: rendimiento en GB/s de cada juego de núcleos
+// ---------------------------------------------------------------------------
 
-struct Funcion {
-    string nombre;
-    string tipo;
-};
+// Genera un programa sintético de al menos el tamaño pedido, parecido al código generado que
+// se compila en producción: bloques anidados con sangría profunda, nombres largos, números y cadenas
+string generarFuenteSintetica(size_t bytes) {
+    string texto;
+    texto.reserve(bytes + 4096);
+    mt19937 generador(2024);
+    uniform_int_distribution<int> numero(0, 1000000);
+    size_t funcion = 0;
+    while (texto.size() < bytes) {
+        texto += "int funcion_generada_" + to_string(funcion++) + "() {\n";
+        for (int i = 0; i < 64; i++) {
+            string sangria(4 * (1 + i % 6), ' ');
+            string variable = "variable_temporal_generada_" + to_string(i);
+            texto += sangria + "int " + variable + " = " + to_string(numero(generador)) + " + contador_global_del_modulo * 2;\n";
+            texto += sangria + "string mensaje_generado_" + to_string(i) + " = \"mensaje de prueba numero " + to_string(i) + "\";\n";
+            texto += sangria + "if (" + variable + " >= 100 && " + variable + " != 7) {\n";
+            texto += sangria + "    " + variable + " = " + variable + " - 1;\n";
+            texto += sangria + "}\n";
+        }
+        texto += "    return 0;\n}\n\n";
+    }
+    return texto;
+}
 
-class AnalizadorSemantic {
-private:
-    vector<Simbolo> tabla_simbolos;
-    vector<Funcion> funciones;
+void benchmarkLexico(size_t megabytes) {
+    Fuente fuente(generarFuenteSintetica(megabytes * 1024 * 1024));
+    const double bytes = static_cast<double>(fuente.contenido().size());
+    cout << "Fuente sintética: " << fixed << setprecision(1) << bytes / (1024 * 1024) << " MB" << endl;
 
-public:
-    void analizar(shared_ptr<ASTNode> arbol) {
-        visit(arbol, "global");
-        imprimir_tabla_simbolos();
+    size_t tokensReferencia = 0;
+    uint64_t sumaReferencia = 0;
+    for (const NucleosLexicos *nucleos : nucleosDisponibles()) {
+        double mejor = 1e30;
+        size_t cantidad = 0;
+        uint64_t suma = 0;
+        for (int repeticion = 0; repeticion < 3; repeticion++) {
+            auto inicio = chrono::steady_clock::now();
+            vector<Token> tokens = tokenize(fuente, *nucleos);
+            mejor = min(mejor, chrono::duration<double>(chrono::steady_clock::now() - inicio).count());
+            cantidad = tokens.size();
+            suma = 0;
+            for (const Token &token : tokens) {
+                suma += token.offset * 31u + token.length * 7u + token.line + token.column + static_cast<uint8_t>(token.type);
+            }
+        }
+        cout << setw(8) << nucleos->nombre << ": " << setprecision(3) << bytes / mejor / 1e9 << " GB/s  ("
+             << cantidad << " tokens, " << setprecision(1) << mejor * 1000 << " ms)" << endl;
+        if (tokensReferencia == 0) {
+            tokensReferencia = cantidad;
+            sumaReferencia = suma;
+        } else if (cantidad != tokensReferencia || suma != sumaReferencia) {
+            cerr << "Error: el núcleo " << nucleos->nombre << " produce tokens distintos al escalar" << endl;
+        }
     }
+}
 
-     void visit(shared_ptr<ASTNode> nodo, const string& ambito) {
-        if (auto func_def = dynamic_pointer_cast<FunctionDef>(nodo)) {
-            for (const auto& arg : func_def->args) {
-                agregar_variable(arg, "desconocido", func_def->name); // Tipo desconocido por ahora
-            }
+// ---------------------------------------------------------------------------
+// Benchmark del recorrido del AST: despacho por etiqueta frente a cadenas de dynamic_cast
+// ---------------------------------------------------------------------------
 
-            for (const auto& statement : func_def->body) {
-                visit(statement, func_def->name);
-            }
+// Construye una función con la mezcla de sentencias de un programa real hasta tener al
+// menos `nodos` nodos: asignaciones, if/else, bucles y returns.
+ASTNode *construirASTSintetico(Arena &arena, size_t nodos, size_t &creados) {
+    static constexpr string_view VARIABLES[] = {"x", "y", "total", "contador", "indice", "suma", "limite", "paso"};
+    IdNombre x = internar("x");
+    auto literal = [&](string_view texto) { return arena.crear<Literal>(internar(texto), N_INT); };
+    auto binario = [&](IdNombre op, string_view izquierdo, string_view derecho) {
+        return arena.crear<BinaryOp>(op, literal(izquierdo), literal(derecho));
+    };
+    vector<ASTNode *> cuerpo;
+    creados = 1;
+    for (size_t i = 0; creados < nodos; i++) {
+        IdNombre variable = internar(VARIABLES[i % size(VARIABLES)]);
+        switch (i % 4) {
+            case 0:
+                cuerpo.push_back(arena.crear<Assign>(variable, literal("21")));
+                creados += 2;
+                break;
+            case 1:
+                cuerpo.push_back(arena.crear<If>(
+                    binario(N_MAYOR, "x", "10"),
+                    arena.copiar<ASTNode *>({arena.crear<Assign>(variable, binario(N_MAS, "x", "1"))}),
+                    arena.copiar<ASTNode *>({arena.crear<Assign>(variable, binario(N_MENOS, "x", "1"))})));
+                creados += 12;
+                break;
+            case 2:
+                cuerpo.push_back(arena.crear<While>(
+                    binario(N_MENOR, "x", "30"),
+                    arena.copiar<ASTNode *>({arena.crear<Assign>(variable, binario(N_MAS, "x", "2")),
+                                             arena.crear<Assign>(x, arena.crear<UnaryOp>(N_MENOS, literal("x")))})));
+                creados += 11;
+                break;
+            default:
+                cuerpo.push_back(arena.crear<Return>(arena.crear<Literal>(variable, N_INT)));
+                creados += 2;
+                break;
+        }
+    }
+    return arena.crear<FunctionDef>(internar("main"), Lista<IdNombre>{}, arena.copiar(cuerpo.data(), cuerpo.size()), N_INT);
+}
 
-            funciones.push_back({func_def->name, func_def->return_type});
-        } else if (auto assign = dynamic_pointer_cast<Assign>(nodo)) {
-            string tipo_dato = obtener_tipo_dato(assign->value);
-            agregar_variable(assign->target, tipo_dato, ambito);
-        } else if (auto return_stmt = dynamic_pointer_cast<Return>(nodo)) {
-            // Analizar el valor de retorno
-            visit(return_stmt->value, ambito);
-        } else if (auto if_stmt = dynamic_pointer_cast<If>(nodo)) {
-            // Analizar la condición
-            visit(if_stmt->condition, ambito);
-            // Analizar el cuerpo del bloque "then"
-            for (const auto& stmt : if_stmt->then_body) {
-                visit(stmt, ambito);
+// Recorrido de referencia con el despacho anterior: prueba dynamic_cast contra cada clase
+uint64_t recorrerConRTTI(ASTNode *nodo) {
+    uint64_t suma = 1;
+    if (auto func_def = dynamic_cast<FunctionDef *>(nodo)) {
+        for (ASTNode *stmt : func_def->body) {
+            suma += recorrerConRTTI(stmt);
+        }
+    } else if (auto assign = dynamic_cast<Assign *>(nodo)) {
+        suma += assign->target + recorrerConRTTI(assign->value);
+    } else if (auto literal = dynamic_cast<Literal *>(nodo)) {
+        suma += literal->value;
+    } else if (auto return_stmt = dynamic_cast<Return *>(nodo)) {
+        suma += recorrerConRTTI(return_stmt->value);
+    } else if (auto if_stmt = dynamic_cast<If *>(nodo)) {
+        suma += recorrerConRTTI(if_stmt->condition);
+        for (ASTNode *stmt : if_stmt->then_body) {
+            suma += recorrerConRTTI(stmt);
+        }
+        for (ASTNode *stmt : if_stmt->else_body) {
+            suma += recorrerConRTTI(stmt);
+        }
+    } else if (auto while_stmt = dynamic_cast<While *>(nodo)) {
+        suma += recorrerConRTTI(while_stmt->condition);
+        for (ASTNode *stmt : while_stmt->body) {
+            suma += recorrerConRTTI(stmt);
+        }
+    } else if (auto binary = dynamic_cast<BinaryOp *>(nodo)) {
+        suma += binary->op + recorrerConRTTI(binary->left) + recorrerConRTTI(binary->right);
+    } else if (auto unary = dynamic_cast<UnaryOp *>(nodo)) {
+        suma += unary->op + recorrerConRTTI(unary->operand);
+    }
+    return suma;
+}
+
+// El mismo recorrido con despachar(): un switch sobre la etiqueta del nodo
+uint64_t recorrerConEtiquetas(ASTNode *nodo) {
+    return 1 + despachar(nodo, Sobrecarga{
+        [](FunctionDef *func_def) {
+            uint64_t suma = 0;
+            for (ASTNode *stmt : func_def->body) {
+                suma += recorrerConEtiquetas(stmt);
             }
-            // Analizar el cuerpo del bloque "else"
-            for (const auto& stmt : if_stmt->else_body) {
-                visit(stmt, ambito);
+            return suma;
+        },
+        [](Assign *assign) {
+            return assign->target + recorrerConEtiquetas(assign->value);
+        },
+        [](Literal *literal) {
+            return static_cast<uint64_t>(literal->value);
+        },
+        [](Return *return_stmt) {
+            return recorrerConEtiquetas(return_stmt->value);
+        },
+        [](If *if_stmt) {
+            uint64_t suma = recorrerConEtiquetas(if_stmt->condition);
+            for (ASTNode *stmt : if_stmt->then_body) {
+                suma += recorrerConEtiquetas(stmt);
             }
-        } else if (auto while_stmt = dynamic_pointer_cast<While>(nodo)) {
-            // Analizar la condición
-            visit(while_stmt->condition, ambito);
-            // Analizar el cuerpo del bucle
-            for (const auto& stmt : while_stmt->body) {
-                visit(stmt, ambito);
+            for (ASTNode *stmt : if_stmt->else_body) {
+                suma += recorrerConEtiquetas(stmt);
             }
+            return suma;
+        },
+        [](While *while_stmt) {
+            uint64_t suma = recorrerConEtiquetas(while_stmt->condition);
+            for (ASTNode *stmt : while_stmt->body) {
+                suma += recorrerConEtiquetas(stmt);
+            }
+            return suma;
+        },
+        [](BinaryOp *binary) {
+            return binary->op + recorrerConEtiquetas(binary->left) + recorrerConEtiquetas(binary->right);
+        },
+        [](UnaryOp *unary) {
+            return unary->op + recorrerConEtiquetas(unary->operand);
+        },
+        [](ASTNode *) {
+            return uint64_t{0};
+        }
+    });
+}
+
+void benchmarkRecorrido(size_t nodos) {
+    Arena arena;
+    size_t creados = 0;
+    ASTNode *ast = construirASTSintetico(arena, nodos, creados);
+    cout << "AST sintético: " << creados << " nodos (" << arena.bytesUsados() / 1024 << " KB en la arena)" << endl;
+
+    // Mejor de cinco repeticiones para cada recorrido
+    auto medir = [&](auto &&recorrer, uint64_t &suma) {
+        double mejor = 1e30;
+        for (int repeticion = 0; repeticion < 5; repeticion++) {
+            auto inicio = chrono::steady_clock::now();
+            suma = recorrer(ast);
+            mejor = min(mejor, chrono::duration<double>(chrono::steady_clock::now() - inicio).count());
         }
+        return mejor;
+    };
+
+    uint64_t sumaRTTI = 0, sumaEtiquetas = 0;
+    double tiempoRTTI = medir(recorrerConRTTI, sumaRTTI);
+    double tiempoEtiquetas = medir(recorrerConEtiquetas, sumaEtiquetas);
+
+    cout << fixed << setprecision(2);
+    cout << "Cadena de dynamic_cast: " << tiempoRTTI * 1e9 / creados << " ns/nodo (" << tiempoRTTI * 1000 << " ms)" << endl;
+    cout << "Etiqueta + switch:      " << tiempoEtiquetas * 1e9 / creados << " ns/nodo (" << tiempoEtiquetas * 1000 << " ms)" << endl;
+    cout << "Aceleración: " << tiempoRTTI / tiempoEtiquetas << "x" << endl;
+    if (sumaRTTI != sumaEtiquetas) {
+        cerr << "Error: los dos recorridos no coinciden (" << sumaRTTI << " != " << sumaEtiquetas << ")" << endl;
     }
 
-    void agregar_variable(const string& variable, const string& tipo, const string& ambito) {
-        tabla_simbolos.push_back({variable, tipo, ambito});
+    // Pasadas reales del compilador sobre el mismo árbol
+    auto inicio = chrono::steady_clock::now();
+    AnalizadorSemantic analizador;
+    analizador.visit(ast);
+    double tiempoSemantico = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+    inicio = chrono::steady_clock::now();
+    TACGenerator generador;
+    size_t instrucciones = generador.generate(ast).size();
+    double tiempoTAC = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+    cout << "Análisis semántico:     " << tiempoSemantico * 1000 << " ms" << endl;
+    cout << "Generación de TAC:      " << tiempoTAC * 1000 << " ms (" << instrucciones << " instrucciones)" << endl;
+}
+
+// Compila un archivo sin imprimir nada: TAC optimizado según el nivel. Si se pide,
+// deja en `generadas` las instrucciones del TAC antes de las pasadas.
+bool compilarArchivo(const string &ruta, int nivel, CodigoTAC &salida, size_t *generadas = nullptr) {
+    Fuente fuente;
+    if (!fuente.abrir(ruta)) {
+        cerr << "No se pudo abrir " << ruta << endl;
+        return false;
+    }
+    Arena arena;
+    Parser parser(fuente, arena);
+    ASTNode *ast = parser.parse();
+    if (!ast) {
+        cerr << ruta << (parser.literalFueraDeRango() ? ": literal entero fuera de rango" : ": error de sintaxis") << endl;
+        return false;
+    }
+    SimplificadorAST simplificador(arena, nivel);
+    simplificador.simplificar(ast);
+    TACGenerator generador;
+    CodigoTAC tac = generador.generate(ast);
+    if (generadas) {
+        *generadas = contarInstrucciones(tac);
     }
 
-    string obtener_tipo_dato(shared_ptr<ASTNode> nodo) {
-        if (auto literal = dynamic_pointer_cast<Literal>(nodo)) {
-            return literal->type;
+    CFG cfg = CFG::construir(move(tac));
+    AdministradorPasadas pasadas;
+    registrarPasadas(pasadas, nivel);
+    pasadas.ejecutar(cfg);
+    salida = cfg.linearizar();
+    return true;
+}
+
+// Corpus de pruebas: para cada programa compara las instrucciones del TAC recién
+// generado con las que quedan después de las pasadas sobre el CFG
+void reportarReduccion(int argc, char *argv[], int primero, int nivel) {
+    cout << left << setw(32) << "Programa" << right << setw(8) << "TAC" << setw(12) << "Optimizado" << endl;
+    size_t totalAntes = 0, totalDespues = 0;
+    for (int a = primero; a < argc; a++) {
+        CodigoTAC optimizado;
+        size_t antes;
+        if (!compilarArchivo(argv[a], nivel, optimizado, &antes)) {
+            continue;
         }
-        return "desconocido";
+        size_t despues = contarInstrucciones(optimizado);
+        cout << left << setw(32) << argv[a] << right << setw(8) << antes << setw(12) << despues << endl;
+        totalAntes += antes;
+        totalDespues += despues;
+    }
+    cout << left << setw(32) << "Total" << right << setw(8) << totalAntes << setw(12) << totalDespues << endl;
+}
+
+// Ejecuta el main() de un programa en la máquina virtual hasta juntar medio segundo
+// y reporta cuántas instrucciones de bytecode por segundo despacha
+void benchmarkMaquinaVirtual(const string &ruta, int nivel) {
+    CodigoTAC tac;
+    if (!compilarArchivo(ruta, nivel, tac)) {
+        return;
+    }
+    ProgramaVM programa = ProgramaVM::compilar(tac);
+    MaquinaVirtual maquina(programa);
+    ResultadoVM contado = maquina.ejecutarContando();
+    if (!contado.ok) {
+        cerr << "Error de ejecución: " << contado.error << endl;
+        return;
     }
 
-    void imprimir_tabla_simbolos() {
-        cout << "------- Tabla de Símbolos ----------" << endl;
-        for (const auto& simbolo : tabla_simbolos) {
-            cout << "|   Variable:   | " << simbolo.variable << "   |    Tipo:   |   " << simbolo.tipo << "|     Ámbito:      |" << simbolo.ambito << endl;
+    size_t repeticiones = 0;
+    double total = 0, mejor = 1e30;
+    while (total < 0.5 || repeticiones < 3) {
+        auto inicio = chrono::steady_clock::now();
+        maquina.ejecutar();
+        double tiempo = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        total += tiempo;
+        mejor = min(mejor, tiempo);
+        repeticiones++;
+    }
+
+    cout << "Programa: " << ruta << " (-O" << nivel << ", " << programa.codigo.size() << " instrucciones de bytecode, "
+         << programa.registrosIniciales.size() << " registros)" << endl;
+    cout << "main() devolvió ";
+    imprimirValor(cout, contado.valor);
+    cout << endl;
+    cout << fixed << setprecision(2);
+    cout << "Instrucciones ejecutadas por corrida: " << contado.instrucciones << endl;
+    cout << "Mejor de " << repeticiones << " corridas: " << mejor * 1e6 << " µs" << endl;
+    cout << "Velocidad: " << contado.instrucciones / mejor / 1e6 << " millones de instrucciones por segundo" << endl;
+}
+
+// Compila cada programa a código máquina en memoria y lo llama, sin escribir archivos
+// ni pasar por el enlazador. La latencia va desde abrir el archivo hasta tener el
+// valor de main(), desglosada por etapa.
+void ejecutarJIT(int argc, char *argv[], int primero, int nivel) {
+#if defined(__x86_64__) || defined(_M_X64)
+    cout << left << setw(32) << "Programa" << right << setw(16) << "Resultado" << setw(12) << "Total µs"
+         << setw(12) << "Compilar" << setw(12) << "Máquina" << setw(10) << "Cargar" << setw(12) << "Ejecutar" << setw(8) << "Bytes" << endl;
+    cout << fixed << setprecision(1);
+    for (int a = primero; a < argc; a++) {
+        using reloj = chrono::steady_clock;
+        auto microsegundos = [](reloj::time_point desde, reloj::time_point hasta) {
+            return chrono::duration<double, micro>(hasta - desde).count();
+        };
+        auto inicio = reloj::now();
+        CodigoTAC tac;
+        if (!compilarArchivo(argv[a], nivel, tac)) {
+            continue;
         }
-        cout << "------- Funciones --------" << endl;
-        for (const auto& funcion : funciones) {
-            cout << "|     Función:      |" << funcion.nombre << "|      Tipo de Retorno:      |" << funcion.tipo << endl;
+        auto compilado = reloj::now();
+        EmisorBinario emisor;
+        GeneradorX86 generador(tac);
+        if (!generador.generar(emisor)) {
+            cerr << argv[a] << ": no se pudo generar código x86-64: " << generador.error << endl;
+            continue;
+        }
+        emisor.resolverSaltos();
+        auto generado = reloj::now();
+        CodigoEjecutable codigo;
+        if (!codigo.cargar(emisor.bytes)) {
+            cerr << argv[a] << ": no se pudo reservar memoria ejecutable" << endl;
+            continue;
+        }
+        auto cargado = reloj::now();
+        int64_t valor;
+        bool correcto = codigo.llamar(valor);
+        auto fin = reloj::now();
+        if (!correcto) {
+            cerr << argv[a] << ": error de ejecución: " << ERROR_DIVISION << endl;
+            continue;
         }
-    }
-};
 
-// Generador de TAC
-class TACGenerator {
-private:
-    vector<TAC> instrucciones;
-    int temp_count = 0;
-    int label_count = 0;
+        // Una cadena vuelve como su posición en la tabla de constantes más uno
+        if (generador.devuelveCadena &&
+            (valor < 1 || static_cast<uint64_t>(valor - 1) >= tac.constantes.size() ||
+             tac.constantes[static_cast<size_t>(valor - 1)].cadena == N_VACIO)) {
+            cerr << argv[a] << ": el código nativo devolvió una cadena que no está en la tabla de constantes" << endl;
+            continue;
+        }
+        ostringstream resultado;
+        imprimirValor(resultado, generador.devuelveCadena ? tac.constantes[static_cast<size_t>(valor - 1)] : Constante{valor, N_VACIO});
+        cout << left << setw(32) << argv[a] << right << setw(16) << resultado.str() << setw(12) << microsegundos(inicio, fin)
+             << setw(12) << microsegundos(inicio, compilado) << setw(12) << microsegundos(compilado, generado)
+             << setw(10) << microsegundos(generado, cargado) << setw(12) << microsegundos(cargado, fin) << setw(8) << emisor.bytes.size() << endl;
+    }
+#else
+    (void)argc; (void)argv; (void)primero; (void)nivel;
+    cerr << "El modo --jit necesita un procesador x86-64." << endl;
+#endif
+}
 
+// Reparto de tareas entre hilos con robo de trabajo. Cada hilo tiene su propia cola:
+// saca de la punta trasera de la suya y, cuando se vacía, roba de la delantera de las
+// demás. Las tareas son los índices 0..n-1, repartidos en tramos contiguos al empezar;
+// como ninguna tarea crea otras, un hilo termina cuando todas las colas están vacías.
+class RepartidorTareas {
 public:
-    vector<TAC> generate(shared_ptr<ASTNode> nodo) {
-        visit(nodo);
-        return instrucciones;
-    }
+    explicit RepartidorTareas(size_t hilos) : colas(max<size_t>(1, hilos)) {}
 
-    void visit(shared_ptr<ASTNode> nodo) {
-        if (auto func_def = dynamic_pointer_cast<FunctionDef>(nodo)) {
-            for (const auto& stmt : func_def->body) {
-                visit(stmt);
-            }
-        } else if (auto assign = dynamic_pointer_cast<Assign>(nodo)) {
-            string result = assign->target;
-            string value = obtener_valor(assign->value);
-            instrucciones.push_back({"=", value, "", result});
-        } else if (auto return_stmt = dynamic_pointer_cast<Return>(nodo)) {
-            string value = obtener_valor(return_stmt->value);
-            instrucciones.push_back({"return", value, "", ""});
-        } else if (auto if_stmt = dynamic_pointer_cast<If>(nodo)) {
-            string condition = obtener_valor(if_stmt->condition);
-            string label_then = generar_etiqueta();
-            string label_else = generar_etiqueta();
-            instrucciones.push_back({"if", condition, "goto", label_then});
-            for (const auto& stmt : if_stmt->else_body) {
-                visit(stmt);
-            }
-            instrucciones.push_back({"goto", "", "", label_else});
-            instrucciones.push_back({label_then + ":", "", "", ""});
-            for (const auto& stmt : if_stmt->then_body) {
-                visit(stmt);
-            }
-            instrucciones.push_back({label_else + ":", "", "", ""});
-        } else if (auto while_stmt = dynamic_pointer_cast<While>(nodo)) {
-            string label_start = generar_etiqueta();
-            string label_end = generar_etiqueta();
-            instrucciones.push_back({label_start + ":", "", "", ""});
-            string condition = obtener_valor(while_stmt->condition);
-            instrucciones.push_back({"if", condition, "goto", label_end});
-            for (const auto& stmt : while_stmt->body) {
-                visit(stmt);
+    size_t hilos() const { return colas.size(); }
+
+    // Llama a tarea(i) para cada i en [0, n) y vuelve cuando terminaron todas
+    template <typename F>
+    void ejecutar(size_t n, F tarea) {
+        size_t total = colas.size();
+        for (size_t h = 0; h < total; h++) {
+            for (size_t i = n * h / total; i < n * (h + 1) / total; i++) {
+                colas[h].tareas.push_back(i);
             }
-            instrucciones.push_back({"goto", "", "", label_start});
-            instrucciones.push_back({label_end + ":", "", "", ""});
+        }
+        vector<thread> trabajadores;
+        for (size_t h = 1; h < total; h++) {
+            trabajadores.emplace_back([this, h, &tarea] { trabajar(h, tarea); });
+        }
+        trabajar(0, tarea);
+        for (thread &t : trabajadores) {
+            t.join();
         }
     }
 
-    string obtener_valor(shared_ptr<ASTNode> nodo) {
-        if (auto literal = dynamic_pointer_cast<Literal>(nodo)) {
-            return literal->value;
+private:
+    struct Cola {
+        mutex candado;
+        deque<size_t> tareas;
+    };
+    vector<Cola> colas;
+
+    bool tomar(size_t h, size_t &tarea) {
+        {
+            lock_guard<mutex> guardia(colas[h].candado);
+            if (!colas[h].tareas.empty()) {
+                tarea = colas[h].tareas.back();
+                colas[h].tareas.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < colas.size(); k++) {
+            Cola &victima = colas[(h + k) % colas.size()];
+            lock_guard<mutex> guardia(victima.candado);
+            if (!victima.tareas.empty()) {
+                tarea = victima.tareas.front();
+                victima.tareas.pop_front();
+                return true;
+            }
         }
-        return "desconocido";
+        return false;
     }
 
-    string generar_etiqueta() {
-        return "t" + to_string(label_count++);
+    template <typename F>
+    void trabajar(size_t h, F &tarea) {
+        size_t i;
+        while (tomar(h, i)) {
+            tarea(i);
+        }
     }
 };
-// Funciones para el analizador sintáctico
-bool parseExpression(const vector<Token> &tokens, size_t &pos); // Analiza y evalúa expresiones matemáticas complejas con múltiples términos y operadores.
-bool parseTerm(const vector<Token> &tokens, size_t &pos); //Analiza y evalúa términos individuales en una expresión, generalmente implicando multiplicación o división.
-bool parseFactor(const vector<Token> &tokens, size_t &pos); //Analiza y evalúa factores dentro de un término, que pueden ser operandos simples o subexpresiones dentro de paréntesis.
-bool parseUnary(const vector<Token> &tokens, size_t &pos);// Analiza valores binarios
 
+// Resultado de compilar un archivo del lote. Solo guarda textos y cuentas: los ids de
+// nombre son del internador del hilo que lo compiló.
+struct ResultadoLote {
+    bool ok = false;
+    string diagnostico;
+    size_t tokens = 0;
+    size_t simbolos = 0;
+    size_t instruccionesTAC = 0;
+    size_t instruccionesOptimizado = 0;
+};
 
-bool parseExpression(const vector<Token> &tokens) {
-    size_t pos = 0;
-    bool status = parseExpression(tokens, pos) && pos == tokens.size();
-    if (!status && pos < tokens.size()) {
-        cout << "Error sintáctico cerca de: " << tokens[pos].value << endl;
+// Tubería completa sin imprimir: léxico, sintaxis, análisis semántico, TAC y pasadas.
+// Con caché, una fuente que no cambió empieza directamente en las pasadas.
+ResultadoLote compilarParaLote(const string &ruta, int nivel, CacheCompilacion *cache) {
+    ResultadoLote resultado;
+    Fuente fuente;
+    if (!fuente.abrir(ruta)) {
+        resultado.diagnostico = "no se pudo abrir el archivo";
+        return resultado;
+    }
+    EntradaCache compilado;
+    uint64_t clave = cache ? CacheCompilacion::clave(fuente.contenido(), nivel) : 0;
+    if (!cache || !cache->buscar(clave, fuente.contenido().size(), nivel, compilado)) {
+        Arena arena;
+        Parser parser(fuente, arena);
+        ASTNode *ast = parser.parse();
+        resultado.tokens = parser.tokensLeidos();
+        if (!ast) {
+            const Token &error = parser.tokenActual();
+            resultado.diagnostico = string(parser.literalFueraDeRango() ? "literal entero fuera de rango" : "error de sintaxis") +
+                                    " (línea " + to_string(error.line) + ", columna " + to_string(error.column) + ")";
+            return resultado;
+        }
+        SimplificadorAST simplificador(arena, nivel);
+        simplificador.simplificar(ast);
+        AnalizadorSemantic analizador;
+        analizador.visit(ast);
+        compilado.tokens = resultado.tokens;
+        compilado.simbolos = analizador.simbolos();
+        compilado.funciones = analizador.funcionesDeclaradas();
+        TACGenerator generador;
+        compilado.tac = generador.generate(ast);
+        if (cache) {
+            cache->guardar(clave, fuente.contenido().size(), nivel, compilado);
+        }
     }
-    return status;
+    resultado.tokens = compilado.tokens;
+    resultado.simbolos = compilado.simbolos.size();
+    resultado.instruccionesTAC = contarInstrucciones(compilado.tac);
+
+    CFG cfg = CFG::construir(move(compilado.tac));
+    AdministradorPasadas pasadas;
+    registrarPasadas(pasadas, nivel);
+    pasadas.ejecutar(cfg);
+    resultado.instruccionesOptimizado = contarInstrucciones(cfg.linearizar());
+    resultado.ok = true;
+    return resultado;
 }
 
-bool parseExpression(const vector<Token> &tokens, size_t &pos) {
-    if (!parseTerm(tokens, pos))
-        return false;
-    while (pos < tokens.size() && (tokens[pos].value == "+" || tokens[pos].value == "-")) {
-        pos++;
-        if (!parseTerm(tokens, pos))
-            return false;
+// Archivos del lote: los nombrados en la línea de órdenes, en ese orden, y los .txt
+// de cada directorio (recursivamente) en orden alfabético
+vector<string> reunirArchivos(const vector<string> &rutas) {
+    vector<string> archivos;
+    for (const string &ruta : rutas) {
+        error_code error;
+        if (!filesystem::is_directory(ruta, error)) {
+            archivos.push_back(ruta);
+            continue;
+        }
+        vector<string> encontrados;
+        for (const auto &entrada : filesystem::recursive_directory_iterator(ruta, error)) {
+            if (entrada.is_regular_file(error) && entrada.path().extension() == ".txt") {
+                encontrados.push_back(entrada.path().string());
+            }
+        }
+        sort(encontrados.begin(), encontrados.end());
+        archivos.insert(archivos.end(), encontrados.begin(), encontrados.end());
     }
-    return true;
+    return archivos;
 }
 
-bool parseTerm(const vector<Token> &tokens, size_t &pos) {
-    if (!parseUnary(tokens, pos))
-        return false;
-    while (pos < tokens.size() && (tokens[pos].value == "*" || tokens[pos].value == "/")) {
-        pos++;
-        if (!parseUnary(tokens, pos))
-            return false;
+// Compila muchos archivos en paralelo. Los resultados se guardan por posición y se
+// imprimen al final, así que la salida no depende de qué hilo terminó primero.
+void compilarLote(const vector<string> &rutas, int nivel, size_t hilos, CacheCompilacion *cache) {
+    vector<string> archivos = reunirArchivos(rutas);
+    vector<ResultadoLote> resultados(archivos.size());
+    RepartidorTareas repartidor(min(hilos, max<size_t>(1, archivos.size())));
+
+    auto inicio = chrono::steady_clock::now();
+    repartidor.ejecutar(archivos.size(), [&](size_t i) {
+        resultados[i] = compilarParaLote(archivos[i], nivel, cache);
+    });
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+    size_t errores = 0, tokens = 0, antes = 0, despues = 0;
+    for (size_t i = 0; i < archivos.size(); i++) {
+        const ResultadoLote &r = resultados[i];
+        if (!r.ok) {
+            cout << archivos[i] << ": " << r.diagnostico << endl;
+            errores++;
+            continue;
+        }
+        cout << archivos[i] << ": " << r.tokens << " tokens, " << r.simbolos << " símbolos, TAC " << r.instruccionesTAC
+             << " -> " << r.instruccionesOptimizado << " instrucciones" << endl;
+        tokens += r.tokens;
+        antes += r.instruccionesTAC;
+        despues += r.instruccionesOptimizado;
+    }
+    cout << fixed << setprecision(1);
+    cout << archivos.size() << " archivos (" << errores << " con errores) en " << segundos * 1000 << " ms con "
+         << repartidor.hilos() << (repartidor.hilos() == 1 ? " hilo" : " hilos") << ": "
+         << (segundos > 0 ? archivos.size() / segundos : 0) << " archivos/s, " << tokens << " tokens, TAC "
+         << antes << " -> " << despues << " instrucciones" << endl;
+    if (cache) {
+        cache->imprimirEstadisticas(cout);
     }
-    return true;
 }
 
-bool parseUnary(const vector<Token> &tokens, size_t &pos) {
-    if (pos < tokens.size() && tokens[pos].value == "-") {
-        pos++;
+// Abre un objeto compilado proyectándolo en memoria y ejecuta su bytecode en el lugar;
+// si trae código máquina y el procesador es x86-64, lo ejecuta también
+void ejecutarObjeto(const string &ruta) {
+    auto inicio = chrono::steady_clock::now();
+    ObjetoCompilado objeto;
+    if (!objeto.abrir(ruta)) {
+        cerr << ruta << ": no es un objeto compilado válido" << endl;
+        return;
+    }
+    auto [codigo, instrucciones] = objeto.seccion<InstruccionVM>(SeccionObjeto::BYTECODE);
+    if (instrucciones == 0) {
+        cerr << ruta << ": el objeto no trae bytecode" << endl;
+        return;
+    }
+    MaquinaVirtual maquina(codigo, objeto.registrosIniciales());
+    double microsegundos = chrono::duration<double, micro>(chrono::steady_clock::now() - inicio).count();
+
+    auto [simbolos, cantidadSimbolos] = objeto.seccion<SimboloObjeto>(SeccionObjeto::SIMBOLOS);
+    auto [maquinaNativa, bytesMaquina] = objeto.seccion<uint8_t>(SeccionObjeto::MAQUINA);
+    cout << "Objeto: " << ruta << " (-O" << objeto.nivel() << ", " << objeto.bytes() << " bytes, " << instrucciones
+         << " instrucciones de bytecode, " << bytesMaquina << " bytes de código máquina), abierto en "
+         << fixed << setprecision(1) << microsegundos << " µs" << endl;
+    for (size_t i = 0; i < cantidadSimbolos; i++) {
+        const SimboloObjeto &simbolo = simbolos[i];
+        cout << "|   " << (simbolo.esFuncion ? "Función:" : "Variable:") << "   | " << objeto.texto(simbolo.nombre)
+             << "   |    Tipo:   |   " << objeto.texto(simbolo.tipo) << "|     Ámbito:      |" << objeto.texto(simbolo.ambito);
+        if (simbolo.registro != SimboloObjeto::NINGUNO) cout << "   |   Registro: r" << simbolo.registro;
+        cout << endl;
+    }
+
+    ResultadoVM resultado = maquina.ejecutar();
+    if (!resultado.ok) {
+        cout << "Error de ejecución: " << resultado.error << endl;
+        return;
+    }
+    cout << "Máquina virtual: main() devolvió ";
+    imprimirValor(cout, resultado.valor);
+    cout << endl;
+
+#if defined(__x86_64__) || defined(_M_X64)
+    if (bytesMaquina > 0) {
+        CodigoEjecutable ejecutable;
+        if (!ejecutable.cargar(vector<uint8_t>(maquinaNativa, maquinaNativa + bytesMaquina))) {
+            cerr << "No se pudo reservar memoria ejecutable" << endl;
+            return;
+        }
+        int64_t valor;
+        if (!ejecutable.llamar(valor)) {
+            cout << "Código nativo: error de ejecución: " << ERROR_DIVISION << endl;
+            return;
+        }
+        if (!objeto.devuelveCadena()) {
+            cout << "Código nativo: main() devolvió " << valor << endl;
+            return;
+        }
+        // Una cadena vuelve como su registro más uno; el código máquina no se valida al abrir
+        auto [constantes, cantidad] = objeto.seccion<ConstanteObjeto>(SeccionObjeto::CONSTANTES);
+        if (valor < 1 || static_cast<uint64_t>(valor - 1) >= cantidad || constantes[valor - 1].cadena.desplazamiento == ConstanteObjeto::NINGUNA) {
+            cerr << ruta << ": el código nativo devolvió una cadena que no está en el objeto" << endl;
+            return;
+        }
+        cout << "Código nativo: main() devolvió " << objeto.texto(constantes[valor - 1].cadena) << endl;
     }
-    return parseFactor(tokens, pos);
+#endif
 }
 
-bool parseFactor(const vector<Token> &tokens, size_t &pos) {
-    if (pos < tokens.size() && tokens[pos].type == TokenType::NUMBER) {
-        pos++;
+// Número de una opción de la línea de órdenes, entre 1 y maximo. Si no lo es, avisa
+// en cerr y devuelve falso.
+bool leerCantidad(const char *opcion, string_view texto, uint64_t &valor, uint64_t maximo = UINT64_MAX) {
+    const char *fin = texto.data() + texto.size();
+    auto [ultimo, error] = from_chars(texto.data(), fin, valor);
+    if (error == errc() && ultimo == fin && valor >= 1 && valor <= maximo) {
         return true;
-    } else if (pos < tokens.size() && tokens[pos].value == "(") {
-        pos++;
-        if (!parseExpression(tokens, pos))
-            return false;
-        if (pos < tokens.size() && tokens[pos].value == ")") {
-            pos++;
-            return true;
-        }
-        return false;
     }
+    cerr << opcion << " espera un número entre 1 y " << maximo << ", no '" << texto << "'" << endl;
     return false;
 }
-//Función para convertir texto a binario
-string textToBinary(const string& text) {
-    string binaryString;
-    for (char ch : text) {
-        for (int i = 7; i >= 0; --i) {
-            binaryString.push_back((ch & (1 << i)) ? '1' : '0');
+
+int main(int argc, char *argv[]) {
+    // Modo benchmark: compilador --bench-palabras-clave [cantidad]
+    if (argc >= 2 && string(argv[1]) == "--bench-palabras-clave") {
+        uint64_t cantidad = 5000000;
+        if (argc >= 3 && !leerCantidad(argv[1], argv[2], cantidad, UINT32_MAX)) {
+            return 1;
         }
-        binaryString.push_back(' '); // Separador opcional entre bytes
+        benchmarkPalabrasClave(cantidad);
+        return 0;
     }
-    return binaryString;
-}
-int main() {
-    ifstream file("prueba.txt");
 
-    // Verificar si el archivo se abrió correctamente
-    if (!file.is_open()) {
-        cerr << "No se pudo abrir el archivo." << endl;
+    // Modo benchmark: compilador --bench-lexico [megabytes]
+    if (argc >= 2 && string(argv[1]) == "--bench-lexico") {
+        uint64_t megabytes = 64;
+        if (argc >= 3 && !leerCantidad(argv[1], argv[2], megabytes, 1u << 16)) {
+            return 1;
+        }
+        benchmarkLexico(megabytes);
         return 0;
     }
 
-    // Leer el contenido del archivo
-    string line;
-    string content;
-    vector<Token> tokens;
-    while (getline(file, line)) {
-        content += line + '\n';
-        vector<Token> line_tokens = tokenize(line);
-        tokens.insert(tokens.end(), line_tokens.begin(), line_tokens.end());
+    // Modo benchmark: compilador --bench-recorrido [nodos]
+    if (argc >= 2 && string(argv[1]) == "--bench-recorrido") {
+        uint64_t nodos = 1000000;
+        if (argc >= 3 && !leerCantidad(argv[1], argv[2], nodos, UINT32_MAX)) {
+            return 1;
+        }
+        benchmarkRecorrido(nodos);
+        return 0;
     }
-    file.close();
 
-    // Convertir el contenido a binario
-    string binaryContent = textToBinary(content);
+    // Modo corpus: compilador --reduccion [-O0|-O1|-O2] archivo...
+    if (argc >= 2 && string(argv[1]) == "--reduccion") {
+        int primero = 2, nivel = 1;
+        string opcion = argc >= 3 ? argv[2] : "";
+        if (opcion.size() == 3 && opcion.compare(0, 2, "-O") == 0 && opcion[2] >= '0' && opcion[2] <= '2') {
+            nivel = argv[2][2] - '0';
+            primero = 3;
+        }
+        reportarReduccion(argc, argv, primero, nivel);
+        return 0;
+    }
 
-    // Escribir el contenido binario en un nuevo archivo
-    ofstream outputFile("Codigo_en_Binario.bin");
-    if (!outputFile.is_open()) {
-        cerr << "No se pudo crear el archivo de salida." << endl;
+    // Modo lote: compilador --lote [-O0|-O1|-O2] [-j hilos] [--cache directorio [--cache-max MB]] archivo|directorio...
+    if (argc >= 2 && string(argv[1]) == "--lote") {
+        int nivel = 1;
+        size_t hilos = max(1u, thread::hardware_concurrency());
+        string rutaCache;
+        uint64_t limiteCache = LIMITE_CACHE;
+        vector<string> rutas;
+        for (int i = 2; i < argc; i++) {
+            string argumento = argv[i];
+            if (argumento.size() == 3 && argumento.compare(0, 2, "-O") == 0 && argumento[2] >= '0' && argumento[2] <= '2') {
+                nivel = argumento[2] - '0';
+            } else if (argumento == "-j" && i + 1 < argc) {
+                uint64_t cantidad;
+                if (!leerCantidad("-j", argv[++i], cantidad, 1024)) {
+                    return 1;
+                }
+                hilos = cantidad;
+            } else if (argumento == "--cache" && i + 1 < argc) {
+                rutaCache = argv[++i];
+            } else if (argumento == "--cache-max" && i + 1 < argc) {
+                if (!leerCantidad("--cache-max", argv[++i], limiteCache, UINT64_MAX >> 20)) {
+                    return 1;
+                }
+                limiteCache <<= 20;
+            } else {
+                rutas.push_back(argumento);
+            }
+        }
+        unique_ptr<CacheCompilacion> cache;
+        if (!rutaCache.empty()) {
+            cache = make_unique<CacheCompilacion>(rutaCache, limiteCache);
+        }
+        compilarLote(rutas, nivel, hilos, cache.get());
         return 0;
     }
-    outputFile << binaryContent;
-    outputFile.close();
 
-    cout << "El contenido ha sido convertido a binario y guardado en 'output.bin'." << endl;
+    // Modo objeto: compilador --objeto archivo.bin
+    if (argc >= 3 && string(argv[1]) == "--objeto") {
+        ejecutarObjeto(argv[2]);
+        return 0;
+    }
 
-    // Imprimir tokens
-    for (const auto& token : tokens) {
-        cout << "Token: " << token.value << ", Tipo: ";
-        switch (token.type) {
-            case TokenType::KEYWORD: cout << "Palabra clave"; break;
-            case TokenType::IDENTIFIER: cout << "Identificador"; break;
-            case TokenType::NUMBER: cout << "Número"; break;
-            case TokenType::SYMBOL: cout << "Símbolo"; break;
-            case TokenType::UNKNOWN: cout << "Desconocido"; break;
+    // Modo JIT: compilador --jit [-O0|-O1|-O2] archivo...
+    if (argc >= 2 && string(argv[1]) == "--jit") {
+        int primero = 2, nivel = 1;
+        string opcion = argc >= 3 ? argv[2] : "";
+        if (opcion.size() == 3 && opcion.compare(0, 2, "-O") == 0 && opcion[2] >= '0' && opcion[2] <= '2') {
+            nivel = argv[2][2] - '0';
+            primero = 3;
         }
-        cout << endl;
+        ejecutarJIT(argc, argv, primero, nivel);
+        return 0;
     }
 
-    // Analizar sintácticamente la secuencia de tokens
-    bool isSyntacticallyCorrect = parseExpression(tokens);
+    // Modo benchmark: compilador --bench-vm [-O0|-O1|-O2] [archivo]
+    if (argc >= 2 && string(argv[1]) == "--bench-vm") {
+        int nivel = 1;
+        string ruta = "prueba.txt";
+        for (int i = 2; i < argc; i++) {
+            string argumento = argv[i];
+            if (argumento.size() == 3 && argumento.compare(0, 2, "-O") == 0 && argumento[2] >= '0' && argumento[2] <= '2') {
+                nivel = argumento[2] - '0';
+            } else {
+                ruta = argumento;
+            }
+        }
+        benchmarkMaquinaVirtual(ruta, nivel);
+        return 0;
+    }
 
-    // Imprimir el resultado del análisis sintáctico
-    if (isSyntacticallyCorrect) {
-        cout << "La secuencia de tokens es sintácticamente correcta." << endl;
-    } else {
-        cout << "La secuencia de tokens no es sintácticamente correcta." << endl;
+    // Argumentos: [-O0|-O1|-O2] [-o objeto] [-S salida.s] [--cache directorio [--cache-max MB]]
+    //            [--stats] [--stats-json archivo|-] [archivo]; por defecto -O1 y prueba.txt
+    int nivelOptimizacion = 1;
+    string ruta = "prueba.txt";
+    string rutaObjeto = "Codigo_en_Binario.bin";
+    string rutaEnsamblador;
+    string rutaCache;
+    uint64_t limiteCache = LIMITE_CACHE;
+    bool mostrarInforme = false;
+    string rutaInformeJSON;
+    for (int i = 1; i < argc; i++) {
+        string argumento = argv[i];
+        if (argumento.size() == 3 && argumento.compare(0, 2, "-O") == 0 && argumento[2] >= '0' && argumento[2] <= '2') {
+            nivelOptimizacion = argumento[2] - '0';
+        } else if (argumento == "-S" && i + 1 < argc) {
+            rutaEnsamblador = argv[++i];
+        } else if (argumento == "-o" && i + 1 < argc) {
+            rutaObjeto = argv[++i];
+        } else if (argumento == "--cache" && i + 1 < argc) {
+            rutaCache = argv[++i];
+        } else if (argumento == "--cache-max" && i + 1 < argc) {
+            if (!leerCantidad("--cache-max", argv[++i], limiteCache, UINT64_MAX >> 20)) {
+                return 1;
+            }
+            limiteCache <<= 20;
+        } else if (argumento == "--stats") {
+            mostrarInforme = true;
+        } else if (argumento == "--stats-json" && i + 1 < argc) {
+            rutaInformeJSON = argv[++i];
+        } else {
+            ruta = argumento;
+        }
     }
 
-    // Crear un árbol de sintaxis abstracta (AST) de ejemplo
-    auto ast = make_shared<FunctionDef>("main", vector<string>{}, vector<shared_ptr<ASTNode>>{
-        make_shared<Assign>("x", make_shared<Literal>("21", "int")),
-        make_shared<Assign>("y", make_shared<Literal>("\"Diego\"", "string")),
-        make_shared<If>(
-            make_shared<Literal>("x > 10", "condition"),
-            vector<shared_ptr<ASTNode>>{
-                make_shared<Assign>("x", make_shared<Literal>("x + 1", "int"))
-            },
-            vector<shared_ptr<ASTNode>>{
-                make_shared<Assign>("x", make_shared<Literal>("x - 1", "int"))
+    // Proyectar el archivo completo en memoria y verificar que se abrió correctamente
+    InformeFases informe;
+    informe.archivo = ruta;
+    informe.nivel = nivelOptimizacion;
+    informe.empezar("lectura de la fuente");
+    Fuente fuente;
+    if (!fuente.abrir(ruta)) {
+        cerr << "No se pudo abrir el archivo." << endl;
+        return 0;
+    }
+    informe.terminar();
+    informe.contar("bytes_fuente", "bytes de la fuente", fuente.contenido().size());
+
+    // Con caché, una fuente que no cambió salta directo a la tabla de símbolos y el TAC
+    unique_ptr<CacheCompilacion> cache;
+    uint64_t claveCache = 0;
+    EntradaCache compilado;
+    bool enCache = false;
+    if (!rutaCache.empty()) {
+        informe.empezar("búsqueda en la caché");
+        cache = make_unique<CacheCompilacion>(rutaCache, limiteCache);
+        claveCache = CacheCompilacion::clave(fuente.contenido(), nivelOptimizacion);
+        enCache = cache->buscar(claveCache, fuente.contenido().size(), nivelOptimizacion, compilado);
+        informe.terminar();
+    }
+
+    Arena arena;
+    if (enCache) {
+        cout << "Se reutiliza la compilación guardada en la caché (" << compilado.tokens << " tokens)." << endl;
+        imprimirTablaSimbolos(compilado.simbolos, compilado.funciones);
+    } else {
+        // Imprimir tokens a medida que el cursor los produce
+        informe.empezar("léxico e impresión de tokens");
+        CursorLexico cursor(fuente);
+        Token token;
+        while (cursor.siguiente(token)) {
+            cout << "Token: " << fuente.lexema(token) << ", Tipo: ";
+            switch (token.type) {
+                case TokenType::KEYWORD: cout << "Palabra clave"; break;
+                case TokenType::IDENTIFIER: cout << "Identificador"; break;
+                case TokenType::NUMBER: cout << "Número"; break;
+                case TokenType::SYMBOL: cout << "Símbolo"; break;
+                case TokenType::UNKNOWN: cout << "Desconocido"; break;
             }
-        ),
-        make_shared<While>(
-            make_shared<Literal>("x < 30", "condition"),
-            vector<shared_ptr<ASTNode>>{
-                make_shared<Assign>("x", make_shared<Literal>("x + 2", "int"))
+            cout << endl;
+            compilado.tokens++;
+        }
+        informe.terminar();
+
+        // Analizar sintácticamente la secuencia de tokens; todo el AST vive en la arena
+        informe.empezar("análisis sintáctico");
+        Parser parser(fuente, arena);
+        ASTNode* ast = parser.parse();
+        informe.terminar();
+
+        // Imprimir el resultado del análisis sintáctico
+        if (ast) {
+            cout << "La secuencia de tokens es sintácticamente correcta." << endl;
+        } else {
+            const Token& error = parser.tokenActual();
+            if (parser.literalFueraDeRango()) {
+                cout << "El literal entero no cabe en 64 bits (línea " << error.line << ", columna " << error.column << ")." << endl;
+                return 1;
             }
-        ),
-        make_shared<Return>(make_shared<Literal>("x", "int"))
-    }, "int"); // Agregar el tipo de retorno aquí
+            cout << "La secuencia de tokens no es sintácticamente correcta (línea " << error.line
+                 << ", columna " << error.column << ")." << endl;
+            return 1;
+        }
 
-    // Imprimir el AST
-    cout << "Árbol de Sintaxis Abstracta (AST):" << endl;
-    imprimirAST(ast);
+        // Plegar constantes y simplificar expresiones según el nivel de optimización
+        informe.empezar("simplificación del AST");
+        SimplificadorAST simplificador(arena, nivelOptimizacion);
+        simplificador.simplificar(ast);
+        informe.terminar();
+        informe.contarNodosAST(ast);
 
-    // Realizar análisis semántico
-    AnalizadorSemantic analizador;
-    analizador.analizar(ast);
+        // Imprimir el AST
+        informe.empezar("impresión del AST");
+        cout << "Árbol de Sintaxis Abstracta (AST):" << endl;
+        imprimirAST(ast);
+        informe.terminar();
+
+        // Realizar análisis semántico
+        informe.empezar("análisis semántico");
+        AnalizadorSemantic analizador;
+        analizador.analizar(ast);
+        compilado.simbolos = analizador.simbolos();
+        compilado.funciones = analizador.funcionesDeclaradas();
+        informe.terminar();
 
-    // Generar código intermedio (TAC)
-    TACGenerator tacGen;
-    vector<TAC> tac = tacGen.generate(ast);
+        // Generar código intermedio (TAC)
+        informe.empezar("generación de TAC");
+        TACGenerator tacGen;
+        compilado.tac = tacGen.generate(ast);
+        informe.terminar();
+        if (cache) {
+            informe.empezar("guardado en la caché");
+            cache->guardar(claveCache, fuente.contenido().size(), nivelOptimizacion, compilado);
+            informe.terminar();
+        }
+    }
+    if (cache) {
+        cache->imprimirEstadisticas(cout);
+    }
+    informe.contar("tokens", "tokens", compilado.tokens);
+    informe.contar("simbolos", "símbolos", compilado.simbolos.size());
+    informe.contar("funciones", "funciones", compilado.funciones.size());
+    CodigoTAC &tac = compilado.tac;
 
     // Imprimir el código intermedio (TAC)
+    informe.empezar("impresión del TAC");
     cout << "Código Intermedio (TAC):" << endl;
-    for (const auto& instr : tac) {
-        cout << instr.op << " " << instr.arg1 << " " << instr.arg2 << " " << instr.result << endl;
+    imprimirTAC(cout, tac);
+    informe.terminar();
+
+    // Partir el TAC en bloques básicos y correr las pasadas sobre el CFG
+    informe.empezar("pasadas sobre el CFG");
+    size_t instruccionesTAC = contarInstrucciones(tac);
+    CFG cfg = CFG::construir(move(tac));
+    AdministradorPasadas pasadas;
+    registrarPasadas(pasadas, nivelOptimizacion);
+    pasadas.ejecutar(cfg);
+    informe.terminar();
+    informe.contar("instrucciones_tac", "instrucciones TAC", instruccionesTAC);
+    informe.contar("bloques_basicos", "bloques básicos", cfg.bloquesAlcanzables());
+
+    informe.empezar("impresión del CFG");
+    cout << "Grafo de flujo de control:" << endl;
+    cfg.imprimir(cout);
+
+    if (pasadas.size() > 0) {
+        cout << "Estadísticas de las pasadas:" << endl;
+        pasadas.imprimirEstadisticas(cout);
+    }
+    informe.terminar();
+
+    informe.empezar("linealización e impresión");
+    CodigoTAC optimizado = cfg.linearizar();
+    cout << "Código optimizado (" << instruccionesTAC << " -> " << contarInstrucciones(optimizado) << " instrucciones):" << endl;
+    imprimirTAC(cout, optimizado);
+    informe.terminar();
+    informe.contar("instrucciones_tac_optimizado", "instrucciones TAC optimizado", contarInstrucciones(optimizado));
+
+    // Objeto compilado: bytecode, código máquina si se pudo generar, constantes y símbolos
+    informe.empezar("bytecode");
+    ProgramaVM programa = ProgramaVM::compilar(optimizado);
+    informe.terminar();
+    informe.contar("instrucciones_bytecode", "instrucciones de bytecode", programa.codigo.size());
+    {
+        informe.empezar("código máquina");
+        EmisorBinario emisorMaquina(programa.registroDeConstante);
+        GeneradorX86 generadorMaquina(optimizado);
+        bool conMaquina = generadorMaquina.generar(emisorMaquina);
+        if (conMaquina) {
+            emisorMaquina.resolverSaltos();
+        }
+        informe.terminar();
+        informe.contar("bytes_codigo_maquina", "bytes de código máquina", conMaquina ? emisorMaquina.bytes.size() : 0);
+
+        informe.empezar("escritura del objeto");
+        vector<char> objeto = serializarObjeto(programa, compilado.simbolos, compilado.funciones,
+                                               conMaquina ? emisorMaquina.bytes : vector<uint8_t>{}, nivelOptimizacion, generadorMaquina.devuelveCadena);
+        size_t escritos = escribirObjeto(rutaObjeto, objeto);
+        double microsegundosObjeto = informe.terminar();
+        if (escritos == 0) {
+            cerr << "No se pudo crear el archivo de salida." << endl;
+            return 1;
+        }
+        informe.contar("bytes_escritos", "bytes escritos", escritos);
+        cout << "Objeto compilado guardado en '" << rutaObjeto << "': " << escritos << " bytes (fuente de " << fuente.contenido().size()
+             << " bytes), " << programa.codigo.size() << " instrucciones de bytecode, " << (conMaquina ? emisorMaquina.bytes.size() : 0)
+             << " bytes de código máquina, escrito en " << fixed << setprecision(1) << microsegundosObjeto << " µs" << endl;
+    }
+
+    // Ejecutar main() en la máquina virtual
+    MaquinaVirtual maquina(programa);
+    informe.empezar("ejecución");
+    ResultadoVM resultado = maquina.ejecutarContando();
+    double microsegundos = informe.terminar();
+    if (!resultado.ok) {
+        cout << "Error de ejecución: " << resultado.error << endl;
+        return 1;
+    }
+    informe.contar("instrucciones_ejecutadas", "instrucciones ejecutadas", resultado.instrucciones);
+    cout << "Ejecución: main() devolvió ";
+    imprimirValor(cout, resultado.valor);
+    cout << " (" << resultado.instrucciones << " instrucciones de bytecode en " << fixed << setprecision(1) << microsegundos << " µs)" << endl;
+
+    // Código nativo: un archivo de ensamblador que se enlaza con cc
+    if (!rutaEnsamblador.empty()) {
+        informe.empezar("ensamblador x86-64");
+        EmisorGAS emisor;
+        GeneradorX86 generadorX86(optimizado);
+        if (!generadorX86.generar(emisor)) {
+            cout << "No se pudo generar código x86-64: " << generadorX86.error << endl;
+            return 1;
+        }
+        ofstream archivoEnsamblador(rutaEnsamblador);
+        if (!archivoEnsamblador.is_open()) {
+            cerr << "No se pudo crear " << rutaEnsamblador << endl;
+            return 1;
+        }
+        emisor.escribir(archivoEnsamblador, optimizado, generadorX86.devuelveCadena);
+        informe.terminar();
+        cout << "Código x86-64 escrito en '" << rutaEnsamblador << "' (" << emisor.instrucciones << " instrucciones, "
+             << generadorX86.nombresEnRegistro << " nombres en registros, " << generadorX86.nombresEnPila << " en la pila)" << endl;
+        cout << "Para enlazarlo: cc " << rutaEnsamblador << " -o programa" << endl;
+    }
+
+    // Informe de fases: tabla al final de la salida y, si se pidió, JSON aparte
+    if (mostrarInforme) {
+        cout << "Informe de fases:" << endl;
+        informe.imprimirTabla(cout);
+    }
+    if (!rutaInformeJSON.empty()) {
+        if (rutaInformeJSON == "-") {
+            informe.imprimirJSON(cout);
+        } else {
+            ofstream archivoInforme(rutaInformeJSON);
+            if (!archivoInforme.is_open()) {
+                cerr << "No se pudo crear " << rutaInformeJSON << endl;
+                return 1;
+            }
+            informe.imprimirJSON(archivoInforme);
+        }
     }
 
     return 0;
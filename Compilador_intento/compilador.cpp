@@ -6,11 +6,28 @@
 #include <memory>
 #include <unordered_map>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <charconv>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
 // Definir tipos de token
-enum class TokenType {
+enum class TokenType : uint8_t {
     KEYWORD,
     IDENTIFIER,
     NUMBER,
@@ -18,36 +35,215 @@ enum class TokenType {
     UNKNOWN
 };
 
-// Estructura para representar tokens
+// Estructura para representar tokens: no copia el texto, solo guarda su posición en la fuente
 struct Token {
+    uint32_t offset; // Posición del primer carácter dentro de la fuente
+    uint32_t length; // Longitud del lexema
+    uint32_t line;   // Línea (desde 1)
+    uint16_t column; // Columna (desde 1, saturada en 65535)
     TokenType type;
-    string value;
 };
+static_assert(sizeof(Token) <= 16, "Token debe ocupar 16 bytes o menos");
 
-// Función para clasificar palabras
-TokenType identifyToken(const string &word) {
-    // Palabras clave
-    const vector<string> keywords = {
+// Texto fuente completo, de solo lectura. El archivo se proyecta en memoria (mmap o
+// MapViewOfFile) y, si no se puede, se lee con una sola lectura. Es el único dueño de los
+// caracteres; tokens y AST apuntan dentro de él. Los offsets de Token limitan la fuente a 4 GB.
+class Fuente {
+public:
+    Fuente() = default;
+    explicit Fuente(string texto) : copia(move(texto)), datos(copia.data()), tamano(copia.size()) {}
+    Fuente(const Fuente &) = delete;
+    Fuente &operator=(const Fuente &) = delete;
+    ~Fuente() { liberar(); }
+
+    // Abre el archivo indicado; devuelve false si no se puede leer
+    bool abrir(const string &ruta) {
+        liberar();
+#ifdef _WIN32
+        HANDLE archivo = CreateFileA(ruta.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                     FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (archivo != INVALID_HANDLE_VALUE) {
+            LARGE_INTEGER tam;
+            if (GetFileSizeEx(archivo, &tam) && tam.QuadPart > 0) {
+                HANDLE proyeccion = CreateFileMappingA(archivo, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (proyeccion) {
+                    void *vista = MapViewOfFile(proyeccion, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(proyeccion);
+                    if (vista) {
+                        CloseHandle(archivo);
+                        mapeo = vista;
+                        datos = static_cast<const char *>(vista);
+                        tamano = static_cast<size_t>(tam.QuadPart);
+                        return true;
+                    }
+                }
+            }
+            CloseHandle(archivo);
+        }
+#else
+        int fd = open(ruta.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+                void *vista = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (vista != MAP_FAILED) {
+                    madvise(vista, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                    close(fd);
+                    mapeo = vista;
+                    datos = static_cast<const char *>(vista);
+                    tamano = static_cast<size_t>(info.st_size);
+                    return true;
+                }
+            }
+            close(fd);
+        }
+#endif
+        // Alternativa: leer todo el archivo con una sola lectura
+        ifstream archivo(ruta, ios::binary);
+        if (!archivo.is_open()) {
+            return false;
+        }
+        archivo.seekg(0, ios::end);
+        streamoff tam = archivo.tellg();
+        if (tam < 0) {
+            // Sin tamaño conocido (p. ej. una tubería): se lee el flujo hasta el final
+            archivo.clear();
+            copia.assign(istreambuf_iterator<char>(archivo), istreambuf_iterator<char>());
+            datos = copia.data();
+            tamano = copia.size();
+            return true;
+        }
+        archivo.seekg(0, ios::beg);
+        copia.resize(static_cast<size_t>(tam));
+        if (!archivo.read(&copia[0], tam)) {
+            copia.clear();
+            return false;
+        }
+        datos = copia.data();
+        tamano = copia.size();
+        return true;
+    }
+
+    string_view contenido() const { return string_view(datos, tamano); }
+
+    // Reemplaza `borrar` bytes desde `desde` por `texto`. El texto queda en memoria propia;
+    // si venía de una proyección, se copia antes.
+    void reemplazar(size_t desde, size_t borrar, string_view texto) {
+        if (datos != copia.data()) {
+            string propio(contenido());
+            liberar();
+            copia = move(propio);
+        }
+        copia.replace(desde, borrar, texto);
+        datos = copia.data();
+        tamano = copia.size();
+    }
+
+    string_view lexema(const Token &token) const {
+        return contenido().substr(token.offset, token.length);
+    }
+
+private:
+    string copia;             // Solo se usa cuando el texto no viene de una proyección
+    const char *datos = nullptr;
+    size_t tamano = 0;
+    void *mapeo = nullptr;    // Vista proyectada, o nullptr si se usa la copia
+
+    void liberar() {
+        if (mapeo) {
+#ifdef _WIN32
+            UnmapViewOfFile(mapeo);
+#else
+            munmap(mapeo, tamano);
+#endif
+            mapeo = nullptr;
+        }
+        copia.clear();
+        datos = nullptr;
+        tamano = 0;
+    }
+};
+
+// Palabras clave del lenguaje
+constexpr string_view PALABRAS_CLAVE[] = {
         "auto", "break", "case", "catch", "class", "const", "continue", "default", "delete",
         "do", "else", "enum", "explicit", "export", "extern", "false", "for", "friend", "goto",
         "if", "inline", "mutable", "namespace", "new", "operator", "private", "protected", "public",
         "register", "reinterpret_cast", "return", "sizeof", "static", "static_cast", "struct", "switch",
         "template", "this", "throw", "true", "try", "typedef", "typeid", "typename", "union", "using",
         "virtual", "void", "volatile", "while", "int", "string"
-    };
+};
 
+// Símbolos de un solo carácter
+constexpr string_view SIMBOLOS = "+-*/%(){}=;<>";
+
+// Tabla hash perfecta de palabras clave, generada en tiempo de compilación.
+// La función hash solo mira la longitud y tres caracteres (primero, segundo y último),
+// y se busca una semilla con la que ninguna palabra clave colisione.
+constexpr int BITS_TABLA_CLAVES = 8;
+
+constexpr uint32_t hashPalabraClave(string_view palabra, uint32_t semilla) {
+    uint32_t h = (semilla ^ static_cast<uint32_t>(palabra.size())) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[0])) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[palabra.size() > 1 ? 1 : 0])) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[palabra.size() - 1])) * 0x01000193u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    return h >> (32 - BITS_TABLA_CLAVES);
+}
+
+struct TablaPalabrasClave {
+    uint32_t semilla;
+    array<string_view, 1 << BITS_TABLA_CLAVES> ranuras;
+};
+
+constexpr TablaPalabrasClave construirTablaPalabrasClave() {
+    for (uint32_t semilla = 1; semilla < 100000; semilla++) {
+        // Primero se prueba la semilla con un mapa de ranuras ocupadas
+        array<bool, 1 << BITS_TABLA_CLAVES> ocupadas{};
+        bool sinColisiones = true;
+        for (string_view palabra : PALABRAS_CLAVE) {
+            bool &ocupada = ocupadas[hashPalabraClave(palabra, semilla)];
+            if (ocupada) {
+                sinColisiones = false;
+                break;
+            }
+            ocupada = true;
+        }
+        if (!sinColisiones) continue;
+
+        TablaPalabrasClave tabla{semilla, {}};
+        for (string_view palabra : PALABRAS_CLAVE) {
+            tabla.ranuras[hashPalabraClave(palabra, semilla)] = palabra;
+        }
+        return tabla;
+    }
+    return {0, {}};
+}
+
+constexpr TablaPalabrasClave TABLA_PALABRAS_CLAVE = construirTablaPalabrasClave();
+static_assert(TABLA_PALABRAS_CLAVE.semilla != 0, "No se encontró una semilla sin colisiones para las palabras clave");
+
+// Búsqueda en O(1): una sola ranura candidata y una comparación
+inline bool esPalabraClave(string_view palabra) {
+    if (palabra.empty()) return false;
+    return TABLA_PALABRAS_CLAVE.ranuras[hashPalabraClave(palabra, TABLA_PALABRAS_CLAVE.semilla)] == palabra;
+}
+
+// Función para clasificar palabras
+TokenType identifyToken(string_view word) {
     // Verificar si es una palabra clave
-    if (find(keywords.begin(), keywords.end(), word) != keywords.end()) {
+    if (esPalabraClave(word)) {
         return TokenType::KEYWORD;
     }
 
     // Verificar si es un número (simplificación: solo enteros)
-    if (all_of(word.begin(), word.end(), ::isdigit)) {
+    if (all_of(word.begin(), word.end(), [](unsigned char c) { return isdigit(c) != 0; })) {
         return TokenType::NUMBER;
     }
 
     // Verificar si es un símbolo
-    if (word.size() == 1 && string("+-*/%(){}=;<>").find(word) != string::npos) {
+    if (word.size() == 1 && SIMBOLOS.find(word) != string::npos) {
         return TokenType::SYMBOL;
     }
 
@@ -60,130 +256,1153 @@ TokenType identifyToken(const string &word) {
     return TokenType::IDENTIFIER;
 }
 
-// Función para separar tokens considerando símbolos individuales
-vector<Token> tokenize(const string &line) {
-    vector<Token> tokens;
-    string word;
-    for (char ch : line) {
-        if (isspace(ch)) {
-            if (!word.empty()) {
-                tokens.push_back({identifyToken(word), word});
-                word.clear();
-            }
-        } else if (string("+-*/%(){}=;<>").find(ch) != string::npos) {
-            if (!word.empty()) {
-                tokens.push_back({identifyToken(word), word});
-                word.clear();
-            }
-            tokens.push_back({TokenType::SYMBOL, string(1, ch)});
-        } else {
-            word += ch;
+// ---------------------------------------------------------------------------
+// Analizador léxico basado en tablas (autómata finito determinista)
+// ---------------------------------------------------------------------------
+
+// Clases de caracteres: cada byte de la entrada se reduce a una de estas clases
+enum ClaseCaracter : uint8_t {
+    CC_OTRO,
+    CC_ESPACIO,
+    CC_SALTO,
+    CC_LETRA,
+    CC_DIGITO,
+    CC_COMILLA,
+    CC_ESCAPE,
+    CC_MAS,
+    CC_MENOS,
+    CC_IGUAL,
+    CC_MENOR,
+    CC_MAYOR,
+    CC_AMPERSAND,
+    CC_BARRA,
+    CC_EXCLAMACION,
+    CC_OPERADOR,    // * / % ^ : solo se combinan con '='
+    CC_DELIMITADOR, // ( ) { } [ ] ; , . : ? ~ #
+    NUM_CLASES
+};
+
+// Estados del autómata. Todos los estados desde E_IDENTIFICADOR son de aceptación.
+enum EstadoLexico : uint8_t {
+    E_ERROR,
+    E_INICIO,
+    E_CADENA,
+    E_CADENA_ESCAPE,
+    E_IDENTIFICADOR,
+    E_NUMERO,
+    E_CADENA_FIN,
+    E_MAS,
+    E_MENOS,
+    E_IGUAL,
+    E_MENOR,
+    E_MAYOR,
+    E_MENOR_MENOR,
+    E_MAYOR_MAYOR,
+    E_AMPERSAND,
+    E_BARRA,
+    E_EXCLAMACION,
+    E_OPERADOR,
+    E_OPERADOR_FIN,
+    E_DELIMITADOR,
+    E_DESCONOCIDO,
+    NUM_ESTADOS
+};
+
+using TablaClases = array<uint8_t, 256>;
+using TablaTransiciones = array<array<uint8_t, NUM_CLASES>, NUM_ESTADOS>;
+
+constexpr TablaClases construirTablaClases() {
+    TablaClases clases{};
+    for (int c = 0; c < 256; c++) {
+        // Los bytes >= 0x80 se tratan como letras para aceptar identificadores UTF-8
+        clases[c] = c >= 0x80 ? CC_LETRA : CC_OTRO;
+    }
+    for (int c = 'a'; c <= 'z'; c++) clases[c] = CC_LETRA;
+    for (int c = 'A'; c <= 'Z'; c++) clases[c] = CC_LETRA;
+    for (int c = '0'; c <= '9'; c++) clases[c] = CC_DIGITO;
+    clases['_'] = CC_LETRA;
+    clases[' '] = clases['\t'] = clases['\r'] = clases['\v'] = clases['\f'] = CC_ESPACIO;
+    clases['\n'] = CC_SALTO;
+    clases['"'] = CC_COMILLA;
+    clases['\\'] = CC_ESCAPE;
+    clases['+'] = CC_MAS;
+    clases['-'] = CC_MENOS;
+    clases['='] = CC_IGUAL;
+    clases['<'] = CC_MENOR;
+    clases['>'] = CC_MAYOR;
+    clases['&'] = CC_AMPERSAND;
+    clases['|'] = CC_BARRA;
+    clases['!'] = CC_EXCLAMACION;
+    clases['*'] = clases['/'] = clases['%'] = clases['^'] = CC_OPERADOR;
+    for (char c : {'(', ')', '{', '}', '[', ']', ';', ',', '.', ':', '?', '~', '#'}) {
+        clases[static_cast<unsigned char>(c)] = CC_DELIMITADOR;
+    }
+    return clases;
+}
+
+constexpr TablaTransiciones construirTablaTransiciones() {
+    TablaTransiciones t{}; // Todo lo no definido lleva a E_ERROR
+
+    t[E_INICIO][CC_OTRO] = E_DESCONOCIDO;
+    t[E_INICIO][CC_ESCAPE] = E_DESCONOCIDO;
+    t[E_INICIO][CC_LETRA] = E_IDENTIFICADOR;
+    t[E_INICIO][CC_DIGITO] = E_NUMERO;
+    t[E_INICIO][CC_COMILLA] = E_CADENA;
+    t[E_INICIO][CC_MAS] = E_MAS;
+    t[E_INICIO][CC_MENOS] = E_MENOS;
+    t[E_INICIO][CC_IGUAL] = E_IGUAL;
+    t[E_INICIO][CC_MENOR] = E_MENOR;
+    t[E_INICIO][CC_MAYOR] = E_MAYOR;
+    t[E_INICIO][CC_AMPERSAND] = E_AMPERSAND;
+    t[E_INICIO][CC_BARRA] = E_BARRA;
+    t[E_INICIO][CC_EXCLAMACION] = E_EXCLAMACION;
+    t[E_INICIO][CC_OPERADOR] = E_OPERADOR;
+    t[E_INICIO][CC_DELIMITADOR] = E_DELIMITADOR;
+
+    // Identificadores y números
+    t[E_IDENTIFICADOR][CC_LETRA] = E_IDENTIFICADOR;
+    t[E_IDENTIFICADOR][CC_DIGITO] = E_IDENTIFICADOR;
+    t[E_NUMERO][CC_DIGITO] = E_NUMERO;
+
+    // Cadenas entre comillas dobles (no pueden cruzar un salto de línea)
+    for (int c = 0; c < NUM_CLASES; c++) {
+        t[E_CADENA][c] = E_CADENA;
+        t[E_CADENA_ESCAPE][c] = E_CADENA;
+    }
+    t[E_CADENA][CC_COMILLA] = E_CADENA_FIN;
+    t[E_CADENA][CC_ESCAPE] = E_CADENA_ESCAPE;
+    t[E_CADENA][CC_SALTO] = E_ERROR;
+    t[E_CADENA_ESCAPE][CC_SALTO] = E_ERROR;
+
+    // Operadores de dos o tres caracteres: ++ += -- -= -> == <= << <<= >= >> >>= && &= || |= != *= /= %= ^=
+    t[E_MAS][CC_MAS] = E_OPERADOR_FIN;
+    t[E_MAS][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MENOS][CC_MENOS] = E_OPERADOR_FIN;
+    t[E_MENOS][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MENOS][CC_MAYOR] = E_OPERADOR_FIN;
+    t[E_IGUAL][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MENOR][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MENOR][CC_MENOR] = E_MENOR_MENOR;
+    t[E_MENOR_MENOR][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MAYOR][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_MAYOR][CC_MAYOR] = E_MAYOR_MAYOR;
+    t[E_MAYOR_MAYOR][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_AMPERSAND][CC_AMPERSAND] = E_OPERADOR_FIN;
+    t[E_AMPERSAND][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_BARRA][CC_BARRA] = E_OPERADOR_FIN;
+    t[E_BARRA][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_EXCLAMACION][CC_IGUAL] = E_OPERADOR_FIN;
+    t[E_OPERADOR][CC_IGUAL] = E_OPERADOR_FIN;
+    return t;
+}
+
+// Tablas construidas una sola vez, en tiempo de compilación
+constexpr TablaClases CLASES_CARACTER = construirTablaClases();
+constexpr TablaTransiciones TRANSICIONES = construirTablaTransiciones();
+
+// Tipo de token que produce cada estado de aceptación
+TokenType tipoPorEstado(uint8_t estado, string_view lexema) {
+    switch (estado) {
+        case E_IDENTIFICADOR: return esPalabraClave(lexema) ? TokenType::KEYWORD : TokenType::IDENTIFIER;
+        case E_NUMERO: return TokenType::NUMBER;
+        case E_CADENA_FIN: return TokenType::IDENTIFIER; // Las cadenas se tratan como identificadores
+        case E_DESCONOCIDO: return TokenType::UNKNOWN;
+        default: return TokenType::SYMBOL;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Núcleos vectoriales para el analizador léxico
+// ---------------------------------------------------------------------------
+// Las rachas de espacios, identificadores, números y el interior de las cadenas se consumen
+// en bloque, 16 (SSE2) o 32 (AVX2) bytes por iteración. La implementación se elige en tiempo
+// de ejecución según la CPU; la versión escalar sirve de respaldo y para el resto de cada bloque.
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define LEXICO_X86 1
+#include <immintrin.h>
+#endif
+
+struct NucleosLexicos {
+    const char *nombre;
+    // Salta espacios y saltos de línea; actualiza el número de línea y el inicio de la línea actual
+    size_t (*saltarEspacios)(const unsigned char *texto, size_t i, size_t n, uint32_t &linea, size_t &inicioLinea);
+    // Devuelven la primera posición que ya no pertenece a la racha
+    size_t (*finIdentificador)(const unsigned char *texto, size_t i, size_t n);
+    size_t (*finNumero)(const unsigned char *texto, size_t i, size_t n);
+    size_t (*finCadena)(const unsigned char *texto, size_t i, size_t n); // Se detiene en '"', '\\' o '\n'
+};
+
+size_t saltarEspaciosEscalar(const unsigned char *texto, size_t i, size_t n, uint32_t &linea, size_t &inicioLinea) {
+    while (i < n) {
+        uint8_t clase = CLASES_CARACTER[texto[i]];
+        if (clase == CC_SALTO) {
+            linea++;
+            inicioLinea = i + 1;
+        } else if (clase != CC_ESPACIO) {
+            break;
+        }
+        i++;
+    }
+    return i;
+}
+
+size_t finIdentificadorEscalar(const unsigned char *texto, size_t i, size_t n) {
+    while (i < n && (CLASES_CARACTER[texto[i]] == CC_LETRA || CLASES_CARACTER[texto[i]] == CC_DIGITO)) i++;
+    return i;
+}
+
+size_t finNumeroEscalar(const unsigned char *texto, size_t i, size_t n) {
+    while (i < n && CLASES_CARACTER[texto[i]] == CC_DIGITO) i++;
+    return i;
+}
+
+size_t finCadenaEscalar(const unsigned char *texto, size_t i, size_t n) {
+    while (i < n && texto[i] != '"' && texto[i] != '\\' && texto[i] != '\n') i++;
+    return i;
+}
+
+constexpr NucleosLexicos NUCLEOS_ESCALARES = {
+    "escalar", saltarEspaciosEscalar, finIdentificadorEscalar, finNumeroEscalar, finCadenaEscalar};
+
+#ifdef LEXICO_X86
+// Cada núcleo calcula una máscara con un bit por byte que sigue dentro de la racha; el primer
+// bit apagado marca el final. Las comparaciones sin signo "x <= k" se hacen con min_epu8(x, k) == x.
+
+inline __m128i enRango128(__m128i bytes, char desde, char cuantos) {
+    __m128i x = _mm_sub_epi8(bytes, _mm_set1_epi8(desde));
+    return _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(cuantos)), x);
+}
+
+inline __m128i esEspacio128(__m128i bytes) {
+    // ' ' o '\t' '\n' '\v' '\f' '\r' (9..13)
+    return _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), enRango128(bytes, 9, 4));
+}
+
+inline __m128i esDigito128(__m128i bytes) {
+    return enRango128(bytes, '0', 9);
+}
+
+inline __m128i esIdentificador128(__m128i bytes) {
+    __m128i letra = enRango128(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 25);
+    __m128i guion = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_'));
+    __m128i alto = _mm_cmplt_epi8(bytes, _mm_setzero_si128()); // Bytes >= 0x80 (UTF-8)
+    return _mm_or_si128(_mm_or_si128(letra, guion), _mm_or_si128(alto, esDigito128(bytes)));
+}
+
+inline __m128i esFinCadena128(__m128i bytes) {
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))),
+                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+}
+
+size_t saltarEspaciosSSE2(const unsigned char *texto, size_t i, size_t n, uint32_t &linea, size_t &inicioLinea) {
+    while (i + 16 <= n) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(texto + i));
+        uint32_t espacios = static_cast<uint32_t>(_mm_movemask_epi8(esEspacio128(bytes)));
+        uint32_t saltos = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))));
+        uint32_t fuera = ~espacios & 0xFFFFu;
+        int largo = fuera ? __builtin_ctz(fuera) : 16;
+        saltos &= (1u << largo) - 1;
+        if (saltos) {
+            linea += static_cast<uint32_t>(__builtin_popcount(saltos));
+            inicioLinea = i + static_cast<size_t>(31 - __builtin_clz(saltos)) + 1;
         }
+        i += static_cast<size_t>(largo);
+        if (fuera) return i;
     }
-    if (!word.empty()) {
-        tokens.push_back({identifyToken(word), word});
+    return saltarEspaciosEscalar(texto, i, n, linea, inicioLinea);
+}
+
+size_t finIdentificadorSSE2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 16 <= n) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(texto + i));
+        uint32_t fuera = ~static_cast<uint32_t>(_mm_movemask_epi8(esIdentificador128(bytes))) & 0xFFFFu;
+        if (fuera) return i + static_cast<size_t>(__builtin_ctz(fuera));
+        i += 16;
+    }
+    return finIdentificadorEscalar(texto, i, n);
+}
+
+size_t finNumeroSSE2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 16 <= n) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(texto + i));
+        uint32_t fuera = ~static_cast<uint32_t>(_mm_movemask_epi8(esDigito128(bytes))) & 0xFFFFu;
+        if (fuera) return i + static_cast<size_t>(__builtin_ctz(fuera));
+        i += 16;
+    }
+    return finNumeroEscalar(texto, i, n);
+}
+
+size_t finCadenaSSE2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 16 <= n) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(texto + i));
+        uint32_t fin = static_cast<uint32_t>(_mm_movemask_epi8(esFinCadena128(bytes)));
+        if (fin) return i + static_cast<size_t>(__builtin_ctz(fin));
+        i += 16;
+    }
+    return finCadenaEscalar(texto, i, n);
+}
+
+constexpr NucleosLexicos NUCLEOS_SSE2 = {
+    "sse2", saltarEspaciosSSE2, finIdentificadorSSE2, finNumeroSSE2, finCadenaSSE2};
+
+// Versiones AVX2: se compilan con el atributo target para no exigir -mavx2 al resto del programa
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 inline __m256i enRango256(__m256i bytes, char desde, char cuantos) {
+    __m256i x = _mm256_sub_epi8(bytes, _mm256_set1_epi8(desde));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(cuantos)), x);
+}
+
+AVX2 inline __m256i esDigito256(__m256i bytes) {
+    return enRango256(bytes, '0', 9);
+}
+
+AVX2 size_t saltarEspaciosAVX2(const unsigned char *texto, size_t i, size_t n, uint32_t &linea, size_t &inicioLinea) {
+    while (i + 32 <= n) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(texto + i));
+        __m256i espacio = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')), enRango256(bytes, 9, 4));
+        uint32_t fuera = ~static_cast<uint32_t>(_mm256_movemask_epi8(espacio));
+        uint32_t saltos = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'))));
+        int largo = fuera ? __builtin_ctz(fuera) : 32;
+        if (largo < 32) saltos &= (1u << largo) - 1;
+        if (saltos) {
+            linea += static_cast<uint32_t>(__builtin_popcount(saltos));
+            inicioLinea = i + static_cast<size_t>(31 - __builtin_clz(saltos)) + 1;
+        }
+        i += static_cast<size_t>(largo);
+        if (fuera) return i;
+    }
+    return saltarEspaciosSSE2(texto, i, n, linea, inicioLinea);
+}
+
+AVX2 size_t finIdentificadorAVX2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 32 <= n) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(texto + i));
+        __m256i letra = enRango256(_mm256_or_si256(bytes, _mm256_set1_epi8(0x20)), 'a', 25);
+        __m256i guion = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_'));
+        __m256i valido = _mm256_or_si256(_mm256_or_si256(letra, guion), esDigito256(bytes));
+        // Los bytes >= 0x80 ya tienen el bit alto encendido, que es lo que mira movemask
+        uint32_t fuera = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(valido, bytes)));
+        if (fuera) return i + static_cast<size_t>(__builtin_ctz(fuera));
+        i += 32;
+    }
+    return finIdentificadorSSE2(texto, i, n);
+}
+
+AVX2 size_t finNumeroAVX2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 32 <= n) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(texto + i));
+        uint32_t fuera = ~static_cast<uint32_t>(_mm256_movemask_epi8(esDigito256(bytes)));
+        if (fuera) return i + static_cast<size_t>(__builtin_ctz(fuera));
+        i += 32;
+    }
+    return finNumeroSSE2(texto, i, n);
+}
+
+AVX2 size_t finCadenaAVX2(const unsigned char *texto, size_t i, size_t n) {
+    while (i + 32 <= n) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(texto + i));
+        __m256i fin = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')),
+                                                      _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'))),
+                                      _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+        uint32_t mascara = static_cast<uint32_t>(_mm256_movemask_epi8(fin));
+        if (mascara) return i + static_cast<size_t>(__builtin_ctz(mascara));
+        i += 32;
+    }
+    return finCadenaSSE2(texto, i, n);
+}
+
+#undef AVX2
+
+constexpr NucleosLexicos NUCLEOS_AVX2 = {
+    "avx2", saltarEspaciosAVX2, finIdentificadorAVX2, finNumeroAVX2, finCadenaAVX2};
+#endif
+
+// Núcleos disponibles en esta CPU, del más lento al más rápido
+vector<const NucleosLexicos *> nucleosDisponibles() {
+    vector<const NucleosLexicos *> disponibles = {&NUCLEOS_ESCALARES};
+#ifdef LEXICO_X86
+    disponibles.push_back(&NUCLEOS_SSE2);
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        disponibles.push_back(&NUCLEOS_AVX2);
+    }
+#endif
+    return disponibles;
+}
+
+// Se elige una sola vez el mejor núcleo que soporta la CPU
+const NucleosLexicos &nucleosLexicos() {
+    static const NucleosLexicos *elegidos = nucleosDisponibles().back();
+    return *elegidos;
+}
+
+// Cursor léxico: entrega un token por llamada, en orden, aplicando la regla del lexema
+// más largo. Solo guarda la posición, así que puede empezar en cualquier inicio de línea:
+// ningún token cruza un salto de línea.
+class CursorLexico {
+public:
+    explicit CursorLexico(const Fuente &fuente, const NucleosLexicos &nucleos = nucleosLexicos())
+        : CursorLexico(fuente, 0, 1, 0, nucleos) {}
+
+    // Empieza en `posicion`, que está en la línea `linea` y esa línea empieza en `inicioLinea`
+    CursorLexico(const Fuente &fuente, size_t posicion, uint32_t linea, size_t inicioLinea,
+                 const NucleosLexicos &nucleos = nucleosLexicos())
+        : contenido(fuente.contenido()), texto(reinterpret_cast<const unsigned char *>(contenido.data())),
+          n(contenido.size()), nucleos(nucleos), i(posicion), linea(linea), inicioLinea(inicioLinea) {}
+
+    // Deja el siguiente token en `token`; devuelve false al llegar al final del texto
+    bool siguiente(Token &token) {
+        while (i < n) {
+            uint8_t clase = CLASES_CARACTER[texto[i]];
+            if (clase == CC_ESPACIO || clase == CC_SALTO) {
+                // Un espacio suelto entre tokens es lo más común: no vale la pena llamar al núcleo
+                if (clase == CC_ESPACIO && i + 1 < n) {
+                    uint8_t siguiente = CLASES_CARACTER[texto[i + 1]];
+                    if (siguiente != CC_ESPACIO && siguiente != CC_SALTO) {
+                        i++;
+                        continue;
+                    }
+                }
+                i = nucleos.saltarEspacios(texto, i, n, linea, inicioLinea);
+                continue;
+            }
+
+            size_t inicio = i;
+            uint8_t aceptado = E_ERROR;
+            size_t fin = inicio;
+            if (clase == CC_LETRA) {
+                // Identificadores y números solo se repiten sobre sí mismos: se consume la racha entera
+                aceptado = E_IDENTIFICADOR;
+                fin = nucleos.finIdentificador(texto, i + 1, n);
+            } else if (clase == CC_DIGITO) {
+                aceptado = E_NUMERO;
+                fin = nucleos.finNumero(texto, i + 1, n);
+            } else {
+                uint8_t estado = E_INICIO;
+                while (i < n) {
+                    estado = TRANSICIONES[estado][CLASES_CARACTER[texto[i]]];
+                    if (estado == E_ERROR) break;
+                    i++;
+                    if (estado == E_CADENA) {
+                        i = nucleos.finCadena(texto, i, n);
+                    }
+                    if (estado >= E_IDENTIFICADOR) {
+                        aceptado = estado;
+                        fin = i;
+                    }
+                }
+            }
+
+            // Sin estado de aceptación (p. ej. una comilla sin cerrar): se emite un solo carácter
+            if (aceptado == E_ERROR) {
+                aceptado = E_DESCONOCIDO;
+                fin = inicio + 1;
+            }
+            i = fin;
+
+            string_view lexema(contenido.data() + inicio, fin - inicio);
+            token = {static_cast<uint32_t>(inicio), static_cast<uint32_t>(fin - inicio), linea,
+                     columnaDe(inicio), tipoPorEstado(aceptado, lexema)};
+            return true;
+        }
+        return false;
+    }
+
+    // Columna de una posición de la línea en que está el cursor
+    uint16_t columnaDe(size_t posicion) const {
+        return static_cast<uint16_t>(min<size_t>(posicion - inicioLinea + 1, UINT16_MAX));
+    }
+
+private:
+    string_view contenido;
+    const unsigned char *texto;
+    size_t n;
+    const NucleosLexicos &nucleos;
+    size_t i;
+    uint32_t linea;
+    size_t inicioLinea;
+};
+
+// Todos los tokens del texto de una vez
+vector<Token> tokenize(const Fuente &fuente, const NucleosLexicos &nucleos = nucleosLexicos()) {
+    vector<Token> tokens;
+    tokens.reserve(fuente.contenido().size() / 6 + 16); // Estimación: en el código típico hay un token cada 6-8 bytes
+    CursorLexico cursor(fuente, nucleos);
+    Token token;
+    while (cursor.siguiente(token)) {
+        tokens.push_back(token);
     }
     return tokens;
 }
 
-// Definición de clases del AST
+// ---------------------------------------------------------------------------
+// Internador global: cada nombre distinto (identificador, tipo, ámbito, operador) se
+// guarda una sola vez y se representa con un id de 32 bits. Las fases comparan ids.
+// ---------------------------------------------------------------------------
+
+using IdNombre = uint32_t;
+
+// FNV-1a de 32 bits sobre el texto del nombre
+inline uint32_t hashNombre(string_view texto) {
+    uint32_t h = 0x811C9DC5u;
+    for (unsigned char c : texto) {
+        h = (h ^ c) * 0x01000193u;
+    }
+    return h;
+}
+
+// Asigna a cada nombre distinto un número consecutivo. Después de internar, dos nombres
+// son iguales si y solo si sus números lo son. Guarda su propia copia de cada texto.
+class Internador {
+public:
+    static constexpr IdNombre NINGUNO = UINT32_MAX;
+
+    IdNombre internar(string_view texto) {
+        if ((textos.size() + 1) * 2 > ranuras.size()) {
+            crecer();
+        }
+        uint32_t h = hashNombre(texto);
+        size_t i = ranura(texto, h);
+        if (ranuras[i] == NINGUNO) {
+            ranuras[i] = static_cast<IdNombre>(textos.size());
+            textos.push_back(guardar(texto));
+            hashes.push_back(h);
+        }
+        return ranuras[i];
+    }
+
+    // Número de un nombre ya internado, o NINGUNO; no agrega nada
+    IdNombre buscar(string_view texto) const {
+        return ranuras.empty() ? NINGUNO : ranuras[ranura(texto, hashNombre(texto))];
+    }
+
+    string_view texto(IdNombre id) const { return textos[id]; }
+    size_t size() const { return textos.size(); }
+
+private:
+    static constexpr size_t TAM_BLOQUE = 64 * 1024;
+
+    vector<string_view> textos;    // id -> texto
+    vector<uint32_t> hashes;       // id -> hash, para no recalcularlo al crecer
+    vector<IdNombre> ranuras;      // direccionamiento abierto con sondeo lineal
+    vector<unique_ptr<char[]>> bloques;
+    char *libre = nullptr;
+    char *fin = nullptr;
+
+    // Ranura que contiene el nombre, o la ranura libre donde debería ir
+    size_t ranura(string_view texto, uint32_t h) const {
+        size_t mascara = ranuras.size() - 1;
+        size_t i = h & mascara;
+        while (ranuras[i] != NINGUNO && (hashes[ranuras[i]] != h || textos[ranuras[i]] != texto)) {
+            i = (i + 1) & mascara;
+        }
+        return i;
+    }
+
+    void crecer() {
+        ranuras.assign(max<size_t>(64, ranuras.size() * 2), NINGUNO);
+        size_t mascara = ranuras.size() - 1;
+        for (IdNombre id = 0; id < textos.size(); id++) {
+            size_t i = hashes[id] & mascara;
+            while (ranuras[i] != NINGUNO) {
+                i = (i + 1) & mascara;
+            }
+            ranuras[i] = id;
+        }
+    }
+
+    string_view guardar(string_view texto) {
+        if (texto.size() > static_cast<size_t>(fin - libre)) {
+            size_t tam = max(TAM_BLOQUE, texto.size());
+            bloques.emplace_back(new char[tam]);
+            libre = bloques.back().get();
+            fin = libre + tam;
+        }
+        char *copia = libre;
+        copy(texto.begin(), texto.end(), copia);
+        libre += texto.size();
+        return {copia, texto.size()};
+    }
+};
+
+// Nombres que las fases usan directamente. Se internan primero y en este orden, así que
+// su id coincide con su posición y se comparan contra constantes.
+enum NombreFijo : IdNombre {
+    N_VACIO,
+    N_INT,
+    N_STRING,
+    N_DESCONOCIDO,
+    N_GLOBAL,
+    N_CONDITION,
+    N_MAS,
+    N_MENOS,
+    N_POR,
+    N_ENTRE,
+    N_MODULO,
+    N_MENOR,
+    N_MENOR_IGUAL,
+    N_MAYOR,
+    N_MAYOR_IGUAL,
+    N_IGUAL,
+    N_DISTINTO,
+    N_Y,
+    N_O,
+    N_NO,
+    N_DESPLAZAR,
+};
+
+constexpr string_view NOMBRES_FIJOS[] = {
+    "", "int", "string", "desconocido", "global", "condition",
+    "+", "-", "*", "/", "%", "<", "<=", ">", ">=", "==", "!=", "&&", "||", "!", "<<",
+};
+
+// Internador compartido por el parser, el analizador semántico y el generador de TAC
+inline Internador &nombres() {
+    static Internador global = [] {
+        Internador internador;
+        for (string_view nombre : NOMBRES_FIJOS) {
+            internador.internar(nombre);
+        }
+        return internador;
+    }();
+    return global;
+}
+
+inline IdNombre internar(string_view texto) {
+    return nombres().internar(texto);
+}
+
+inline string_view nombreDe(IdNombre id) {
+    return nombres().texto(id);
+}
+
+// ---------------------------------------------------------------------------
+// Arena de memoria para el AST
+// ---------------------------------------------------------------------------
+
+// Secuencia de elementos guardada en una arena (no es dueña de la memoria)
+template <typename T>
+struct Lista {
+    T *datos = nullptr;
+    uint32_t cantidad = 0;
+
+    T *begin() const { return datos; }
+    T *end() const { return datos + cantidad; }
+    size_t size() const { return cantidad; }
+    bool empty() const { return cantidad == 0; }
+    T &operator[](size_t i) const { return datos[i]; }
+};
+
+// Reserva bloques grandes y reparte trozos consecutivos. Todo el AST de una unidad de
+// compilación vive en una sola arena y se libera de una vez, sin recorrer los nodos.
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // Construye un objeto dentro de la arena. Su destructor nunca se ejecuta, así que los
+    // nodos solo deben tener miembros que no liberan nada (punteros, string_view, Lista).
+    template <typename T, typename... Args>
+    T *crear(Args &&...args) {
+        return new (reservar(sizeof(T), alignof(T))) T(forward<Args>(args)...);
+    }
+
+    // Copia una secuencia de elementos a la arena
+    template <typename T>
+    Lista<T> copiar(const T *datos, size_t cantidad) {
+        static_assert(is_trivially_copyable<T>::value, "Solo se copian tipos triviales a la arena");
+        if (cantidad == 0) {
+            return {};
+        }
+        T *destino = static_cast<T *>(reservar(sizeof(T) * cantidad, alignof(T)));
+        copy(datos, datos + cantidad, destino);
+        return {destino, static_cast<uint32_t>(cantidad)};
+    }
+
+    template <typename T>
+    Lista<T> copiar(initializer_list<T> elementos) {
+        return copiar(elementos.begin(), elementos.size());
+    }
+
+    // Libera todos los bloques en una sola llamada
+    void liberar() {
+        bloques.clear();
+        actual = fin = nullptr;
+        usados = 0;
+    }
+
+    size_t bytesUsados() const { return usados; }
+
+private:
+    static constexpr size_t TAM_BLOQUE = 256 * 1024;
+
+    vector<unique_ptr<char[]>> bloques;
+    char *actual = nullptr;
+    char *fin = nullptr;
+    size_t usados = 0;
+
+    void *reservar(size_t bytes, size_t alineacion) {
+        char *inicio = alinear(actual, alineacion);
+        if (!actual || bytes > static_cast<size_t>(fin - inicio)) {
+            size_t tam = max(TAM_BLOQUE, bytes + alineacion);
+            bloques.emplace_back(new char[tam]);
+            actual = bloques.back().get();
+            fin = actual + tam;
+            inicio = alinear(actual, alineacion);
+        }
+        actual = inicio + bytes;
+        usados += bytes;
+        return inicio;
+    }
+
+    static char *alinear(char *p, size_t alineacion) {
+        uintptr_t valor = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char *>((valor + alineacion - 1) & ~static_cast<uintptr_t>(alineacion - 1));
+    }
+};
+
+// Etiqueta de la clase concreta de cada nodo. Los recorridos despachan con un switch
+// sobre este byte en lugar de probar dynamic_cast contra cada clase.
+enum class TipoNodo : uint8_t {
+    FunctionDef,
+    Assign,
+    Literal,
+    Return,
+    If,
+    While,
+    BinaryOp,
+    UnaryOp,
+};
+
+// Definición de clases del AST. Los nodos se crean en una Arena y se enlazan con punteros simples.
 class ASTNode {
 public:
+    const TipoNodo tipo;
+
+    explicit ASTNode(TipoNodo tipo) : tipo(tipo) {}
     virtual ~ASTNode() = default;
 };
 
+using ListaNodos = Lista<ASTNode *>;
+
 class FunctionDef : public ASTNode {
 public:
-    string name;
-    vector<string> args;
-    vector<shared_ptr<ASTNode>> body;
-    string return_type;
+    static constexpr TipoNodo TIPO = TipoNodo::FunctionDef;
 
-    FunctionDef(const string& name, const vector<string>& args, const vector<shared_ptr<ASTNode>>& body, const string& return_type)
-        : name(name), args(args), body(body), return_type(return_type) {}
+    IdNombre name;
+    Lista<IdNombre> args;
+    ListaNodos body;
+    IdNombre return_type;
+
+    FunctionDef(IdNombre name, Lista<IdNombre> args, ListaNodos body, IdNombre return_type)
+        : ASTNode(TIPO), name(name), args(args), body(body), return_type(return_type) {}
 };
 
 class Assign : public ASTNode {
 public:
-    string target;
-    shared_ptr<ASTNode> value;
+    static constexpr TipoNodo TIPO = TipoNodo::Assign;
+
+    IdNombre target;
+    ASTNode* value;
+    IdNombre declared_type; // N_VACIO si es una asignación y no una declaración
 
-    Assign(const string& target, shared_ptr<ASTNode> value) : target(target), value(value) {}
+    Assign(IdNombre target, ASTNode* value, IdNombre declared_type = N_VACIO)
+        : ASTNode(TIPO), target(target), value(value), declared_type(declared_type) {}
 };
 
 class Literal : public ASTNode {
 public:
-    string value;
-    string type;
+    static constexpr TipoNodo TIPO = TipoNodo::Literal;
+
+    IdNombre value;
+    IdNombre type;
 
-    Literal(const string& value, const string& type) : value(value), type(type) {}
+    Literal(IdNombre value, IdNombre type) : ASTNode(TIPO), value(value), type(type) {}
 };
 
 class Return : public ASTNode {
 public:
-    shared_ptr<ASTNode> value;
+    static constexpr TipoNodo TIPO = TipoNodo::Return;
 
-    Return(shared_ptr<ASTNode> value) : value(value) {}
+    ASTNode* value;
+
+    Return(ASTNode* value) : ASTNode(TIPO), value(value) {}
 };
 
 class If : public ASTNode {
 public:
-    shared_ptr<ASTNode> condition;
-    vector<shared_ptr<ASTNode>> then_body;
-    vector<shared_ptr<ASTNode>> else_body;
+    static constexpr TipoNodo TIPO = TipoNodo::If;
+
+    ASTNode* condition;
+    ListaNodos then_body;
+    ListaNodos else_body;
 
-    If(shared_ptr<ASTNode> condition, const vector<shared_ptr<ASTNode>>& then_body, const vector<shared_ptr<ASTNode>>& else_body)
-        : condition(condition), then_body(then_body), else_body(else_body) {}
+    If(ASTNode* condition, ListaNodos then_body, ListaNodos else_body)
+        : ASTNode(TIPO), condition(condition), then_body(then_body), else_body(else_body) {}
 };
 
 class While : public ASTNode {
 public:
-    shared_ptr<ASTNode> condition;
-    vector<shared_ptr<ASTNode>> body;
+    static constexpr TipoNodo TIPO = TipoNodo::While;
+
+    ASTNode* condition;
+    ListaNodos body;
+
+    While(ASTNode* condition, ListaNodos body)
+        : ASTNode(TIPO), condition(condition), body(body) {}
+};
+
+class BinaryOp : public ASTNode {
+public:
+    static constexpr TipoNodo TIPO = TipoNodo::BinaryOp;
+
+    IdNombre op;
+    ASTNode* left;
+    ASTNode* right;
+
+    BinaryOp(IdNombre op, ASTNode* left, ASTNode* right)
+        : ASTNode(TIPO), op(op), left(left), right(right) {}
+};
+
+class UnaryOp : public ASTNode {
+public:
+    static constexpr TipoNodo TIPO = TipoNodo::UnaryOp;
+
+    IdNombre op;
+    ASTNode* operand;
 
-    While(shared_ptr<ASTNode> condition, const vector<shared_ptr<ASTNode>>& body)
-        : condition(condition), body(body) {}
+    UnaryOp(IdNombre op, ASTNode* operand)
+        : ASTNode(TIPO), op(op), operand(operand) {}
 };
 
+// Convierte el nodo a T si su etiqueta coincide (o devuelve nullptr), sin consultar RTTI
+template <typename T>
+T *nodoComo(ASTNode *nodo) {
+    return nodo && nodo->tipo == T::TIPO ? static_cast<T *>(nodo) : nullptr;
+}
+
+// Reúne varias lambdas en un solo visitante con operator() sobrecargado
+template <typename... Casos>
+struct Sobrecarga : Casos... {
+    using Casos::operator()...;
+};
+
+template <typename... Casos>
+Sobrecarga(Casos...) -> Sobrecarga<Casos...>;
+
+// Llama al visitante con el nodo ya convertido a su clase concreta: un switch por visita.
+// El visitante debe aceptar también ASTNode*, que recibe los nodos nulos y las clases
+// que no le interesan.
+template <typename Visitante>
+decltype(auto) despachar(ASTNode *nodo, Visitante &&visitante) {
+    if (nodo) {
+        switch (nodo->tipo) {
+            case TipoNodo::FunctionDef: return visitante(static_cast<FunctionDef *>(nodo));
+            case TipoNodo::Assign: return visitante(static_cast<Assign *>(nodo));
+            case TipoNodo::Literal: return visitante(static_cast<Literal *>(nodo));
+            case TipoNodo::Return: return visitante(static_cast<Return *>(nodo));
+            case TipoNodo::If: return visitante(static_cast<If *>(nodo));
+            case TipoNodo::While: return visitante(static_cast<While *>(nodo));
+            case TipoNodo::BinaryOp: return visitante(static_cast<BinaryOp *>(nodo));
+            case TipoNodo::UnaryOp: return visitante(static_cast<UnaryOp *>(nodo));
+        }
+    }
+    return visitante(nodo);
+}
+
+// Imprime una expresión en una sola línea, con paréntesis explícitos
+void imprimirExpresion(ASTNode* nodo) {
+    despachar(nodo, Sobrecarga{
+        [](Literal* literal) {
+            cout << nombreDe(literal->value);
+        },
+        [](BinaryOp* binary) {
+            cout << "(";
+            imprimirExpresion(binary->left);
+            cout << " " << nombreDe(binary->op) << " ";
+            imprimirExpresion(binary->right);
+            cout << ")";
+        },
+        [](UnaryOp* unary) {
+            cout << nombreDe(unary->op);
+            imprimirExpresion(unary->operand);
+        },
+        [](ASTNode*) {}
+    });
+}
+
 // imprimir
-void imprimirAST(shared_ptr<ASTNode> nodo, int nivel = 0) {
-    if (auto func_def = dynamic_pointer_cast<FunctionDef>(nodo)) {
-        cout << string(nivel * 2, ' ') << "FunctionDef: " << func_def->name << " -> " << func_def->return_type << endl;
-        for (const auto& stmt : func_def->body) {
-            imprimirAST(stmt, nivel + 1);
-        }
-    } else if (auto assign = dynamic_pointer_cast<Assign>(nodo)) {
-        cout << string(nivel * 2, ' ') << "Assign: " << assign->target << " = ";
-        imprimirAST(assign->value, 0);
-    } else if (auto literal = dynamic_pointer_cast<Literal>(nodo)) {
-        cout << literal->value << " (" << literal->type << ")" << endl;
-    } else if (auto return_stmt = dynamic_pointer_cast<Return>(nodo)) {
-        cout << string(nivel * 2, ' ') << "Return: ";
-        imprimirAST(return_stmt->value, 0);
-    } else if (auto if_stmt = dynamic_pointer_cast<If>(nodo)) {
-        cout << string(nivel * 2, ' ') << "If: " << endl;
-        cout << string((nivel + 1) * 2, ' ') << "Condition: ";
-        imprimirAST(if_stmt->condition, 0);
-        cout << string((nivel + 1) * 2, ' ') << "Then: " << endl;
-        for (const auto& stmt : if_stmt->then_body) {
-            imprimirAST(stmt, nivel + 2);
-        }
-        if (!if_stmt->else_body.empty()) {
-            cout << string((nivel + 1) * 2, ' ') << "Else: " << endl;
-            for (const auto& stmt : if_stmt->else_body) {
+void imprimirAST(ASTNode* nodo, int nivel = 0) {
+    despachar(nodo, Sobrecarga{
+        [nivel](FunctionDef* func_def) {
+            cout << string(nivel * 2, ' ') << "FunctionDef: " << nombreDe(func_def->name) << " -> " << nombreDe(func_def->return_type) << endl;
+            for (const auto& stmt : func_def->body) {
+                imprimirAST(stmt, nivel + 1);
+            }
+        },
+        [nivel](Assign* assign) {
+            cout << string(nivel * 2, ' ') << "Assign: " << nombreDe(assign->target) << " = ";
+            imprimirAST(assign->value, 0);
+        },
+        [](Literal* literal) {
+            cout << nombreDe(literal->value) << " (" << nombreDe(literal->type) << ")" << endl;
+        },
+        [](BinaryOp* binary) {
+            imprimirExpresion(binary);
+            cout << endl;
+        },
+        [](UnaryOp* unary) {
+            imprimirExpresion(unary);
+            cout << endl;
+        },
+        [nivel](Return* return_stmt) {
+            cout << string(nivel * 2, ' ') << "Return: ";
+            imprimirAST(return_stmt->value, 0);
+        },
+        [nivel](If* if_stmt) {
+            cout << string(nivel * 2, ' ') << "If: " << endl;
+            cout << string((nivel + 1) * 2, ' ') << "Condition: ";
+            imprimirAST(if_stmt->condition, 0);
+            cout << string((nivel + 1) * 2, ' ') << "Then: " << endl;
+            for (const auto& stmt : if_stmt->then_body) {
                 imprimirAST(stmt, nivel + 2);
             }
+            if (!if_stmt->else_body.empty()) {
+                cout << string((nivel + 1) * 2, ' ') << "Else: " << endl;
+                for (const auto& stmt : if_stmt->else_body) {
+                    imprimirAST(stmt, nivel + 2);
+                }
+            }
+        },
+        [nivel](While* while_stmt) {
+            cout << string(nivel * 2, ' ') << "While: " << endl;
+            cout << string((nivel + 1) * 2, ' ') << "Condition: ";
+            imprimirAST(while_stmt->condition, 0);
+            cout << string((nivel + 1) * 2, ' ') << "Body: " << endl;
+            for (const auto& stmt : while_stmt->body) {
+                imprimirAST(stmt, nivel + 2);
+            }
+        },
+        [](ASTNode*) {}
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Plegado de constantes y simplificación algebraica sobre el AST
+// ---------------------------------------------------------------------------
+
+// Reescribe las expresiones del AST en su lugar según el nivel de optimización:
+//   -O0  no toca nada
+//   -O1  pliega operaciones cuyos operandos son todos constantes enteras
+//   -O2  además aplica identidades (x+0, x*1, x*0, --x, 0&&x, 1||x) y cambia x*2^k por x<<k
+// El lenguaje no tiene llamadas ni efectos en las expresiones, así que descartar un
+// operando (x*0) no cambia el comportamiento del programa.
+class SimplificadorAST {
+public:
+    SimplificadorAST(Arena& arena, int nivel) : arena(arena), nivel(nivel) {}
+
+    // Número de nodos reemplazados hasta ahora
+    size_t cambios = 0;
+
+    void simplificar(ASTNode* nodo) {
+        if (nivel == 0) {
+            return;
         }
-    } else if (auto while_stmt = dynamic_pointer_cast<While>(nodo)) {
-        cout << string(nivel * 2, ' ') << "While: " << endl;
-        cout << string((nivel + 1) * 2, ' ') << "Condition: ";
-        imprimirAST(while_stmt->condition, 0);
-        cout << string((nivel + 1) * 2, ' ') << "Body: " << endl;
-        for (const auto& stmt : while_stmt->body) {
-            imprimirAST(stmt, nivel + 2);
+        despachar(nodo, Sobrecarga{
+            [this](FunctionDef* func_def) {
+                simplificarBloque(func_def->body);
+            },
+            [this](Assign* assign) {
+                assign->value = expresion(assign->value);
+            },
+            [this](Return* return_stmt) {
+                return_stmt->value = expresion(return_stmt->value);
+            },
+            [this](If* if_stmt) {
+                if_stmt->condition = expresion(if_stmt->condition);
+                simplificarBloque(if_stmt->then_body);
+                simplificarBloque(if_stmt->else_body);
+            },
+            [this](While* while_stmt) {
+                while_stmt->condition = expresion(while_stmt->condition);
+                simplificarBloque(while_stmt->body);
+            },
+            [](ASTNode*) {}
+        });
+    }
+
+private:
+    Arena& arena;
+    int nivel;
+
+    void simplificarBloque(ListaNodos cuerpo) {
+        for (ASTNode* stmt : cuerpo) {
+            simplificar(stmt);
         }
     }
-}
+
+    // Valor de un literal entero ("42" o "-7"); falso si el nodo no es una constante
+    static bool valorConstante(ASTNode* nodo, int64_t& valor) {
+        auto literal = nodoComo<Literal>(nodo);
+        if (!literal) {
+            return false;
+        }
+        string_view texto = nombreDe(literal->value);
+        bool negativo = !texto.empty() && texto[0] == '-';
+        if (negativo) {
+            texto.remove_prefix(1);
+        }
+        if (texto.empty() || texto.size() > 18) {
+            return false;
+        }
+        valor = 0;
+        for (char c : texto) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            valor = valor * 10 + (c - '0');
+        }
+        if (negativo) {
+            valor = -valor;
+        }
+        return true;
+    }
+
+    static bool esConstante(ASTNode* nodo, int64_t valor) {
+        int64_t v;
+        return valorConstante(nodo, v) && v == valor;
+    }
+
+    ASTNode* constante(int64_t valor) {
+        cambios++;
+        return arena.crear<Literal>(internar(to_string(valor)), N_INT);
+    }
+
+    ASTNode* reemplazo(ASTNode* nodo) {
+        cambios++;
+        return nodo;
+    }
+
+    // Resultado de `a op b` si se puede calcular sin desbordamiento ni división por cero
+    static bool plegar(IdNombre op, int64_t a, int64_t b, int64_t& r) {
+        switch (op) {
+            case N_MAS: return !__builtin_add_overflow(a, b, &r);
+            case N_MENOS: return !__builtin_sub_overflow(a, b, &r);
+            case N_POR: return !__builtin_mul_overflow(a, b, &r);
+            case N_ENTRE:
+            case N_MODULO:
+                if (b == 0 || (a == INT64_MIN && b == -1)) {
+                    return false;
+                }
+                r = op == N_ENTRE ? a / b : a % b;
+                return true;
+            case N_MENOR: r = a < b; return true;
+            case N_MENOR_IGUAL: r = a <= b; return true;
+            case N_MAYOR: r = a > b; return true;
+            case N_MAYOR_IGUAL: r = a >= b; return true;
+            case N_IGUAL: r = a == b; return true;
+            case N_DISTINTO: r = a != b; return true;
+            case N_Y: r = a != 0 && b != 0; return true;
+            case N_O: r = a != 0 || b != 0; return true;
+            default: return false;
+        }
+    }
+
+    // Exponente k si valor == 2^k con k >= 1, o -1
+    static int potenciaDeDos(int64_t valor) {
+        if (valor < 2 || (valor & (valor - 1)) != 0) {
+            return -1;
+        }
+        return __builtin_ctzll(static_cast<unsigned long long>(valor));
+    }
+
+    ASTNode* expresion(ASTNode* nodo) {
+        return despachar(nodo, Sobrecarga{
+            [this](BinaryOp* binary) {
+                binary->left = expresion(binary->left);
+                binary->right = expresion(binary->right);
+                return binario(binary);
+            },
+            [this](UnaryOp* unary) {
+                unary->operand = expresion(unary->operand);
+                int64_t v;
+                if (unary->op == N_MENOS && valorConstante(unary->operand, v) && v != INT64_MIN) {
+                    return constante(-v);
+                }
+                if (unary->op == N_NO && valorConstante(unary->operand, v)) {
+                    return constante(v == 0);
+                }
+                if (nivel >= 2) {
+                    // La doble negación aritmética se cancela
+                    auto interno = nodoComo<UnaryOp>(unary->operand);
+                    if (unary->op == N_MENOS && interno && interno->op == N_MENOS) {
+                        return reemplazo(interno->operand);
+                    }
+                }
+                return static_cast<ASTNode*>(unary);
+            },
+            [](ASTNode* otro) {
+                return otro;
+            }
+        });
+    }
+
+    ASTNode* binario(BinaryOp* binary) {
+        int64_t a, b, r;
+        bool izquierdoConstante = valorConstante(binary->left, a);
+        bool derechoConstante = valorConstante(binary->right, b);
+        if (izquierdoConstante && derechoConstante && plegar(binary->op, a, b, r)) {
+            return constante(r);
+        }
+        if (nivel < 2) {
+            return binary;
+        }
+
+        ASTNode* x = binary->left;
+        ASTNode* y = binary->right;
+        switch (binary->op) {
+            case N_MAS:
+                if (esConstante(y, 0)) return reemplazo(x);
+                if (esConstante(x, 0)) return reemplazo(y);
+                break;
+            case N_MENOS:
+                if (esConstante(y, 0)) return reemplazo(x);
+                break;
+            case N_POR: {
+                if (esConstante(y, 1)) return reemplazo(x);
+                if (esConstante(x, 1)) return reemplazo(y);
+                if (esConstante(x, 0) || esConstante(y, 0)) return constante(0);
+                // Reducción de fuerza: multiplicar por 2^k es desplazar k bits
+                int k = derechoConstante ? potenciaDeDos(b) : -1;
+                if (k < 0 && izquierdoConstante) {
+                    k = potenciaDeDos(a);
+                    swap(x, y);
+                }
+                if (k > 0) {
+                    cambios++;
+                    return arena.crear<BinaryOp>(N_DESPLAZAR, x, arena.crear<Literal>(internar(to_string(k)), N_INT));
+                }
+                break;
+            }
+            case N_ENTRE:
+                if (esConstante(y, 1)) return reemplazo(x);
+                break;
+            case N_Y:
+                if (esConstante(x, 0)) return constante(0);
+                break;
+            case N_O:
+                if (izquierdoConstante && a != 0) return constante(1);
+                break;
+            default:
+                break;
+        }
+        return binary;
+    }
+};
+
 
 
 
@@ -191,97 +1410,233 @@ void imprimirAST(shared_ptr<ASTNode> nodo, int nivel = 0) {
 
 // Estructuras para el analizador semántico
 struct Simbolo {
-    string variable;
-    string tipo;
-    string ambito;
+    IdNombre variable;
+    IdNombre tipo;
+    IdNombre ambito;
 };
 
 struct Funcion {
-    string nombre;
-    string tipo;
+    IdNombre nombre;
+    IdNombre tipo;
 };
 
-class AnalizadorSemantic {
-private:
-    vector<Simbolo> tabla_simbolos;
-    vector<Funcion> funciones;
+// ---------------------------------------------------------------------------
+// Tabla de símbolos: un mapa hash por ámbito y una pila de ámbitos
+// ---------------------------------------------------------------------------
 
+// Mapa de un ámbito: id de nombre -> índice del símbolo, con direccionamiento abierto
+class MapaAmbito {
 public:
-    void analizar(shared_ptr<ASTNode> arbol) {
-        visit(arbol, "global");
-        imprimir_tabla_simbolos();
-    }
+    static constexpr uint32_t NINGUNO = UINT32_MAX;
 
-    void visit(shared_ptr<ASTNode> nodo, const string& ambito) {
-        if (auto func_def = dynamic_pointer_cast<FunctionDef>(nodo)) {
-            for (const auto& arg : func_def->args) {
-                agregar_variable(arg, "desconocido", func_def->name); // Tipo desconocido por ahora
+    uint32_t buscar(IdNombre nombre) const {
+        if (ocupadas == 0) {
+            return NINGUNO;
+        }
+        size_t mascara = ranuras.size() - 1;
+        for (size_t i = posicion(nombre);; i = (i + 1) & mascara) {
+            if (ranuras[i].nombre == nombre) {
+                return ranuras[i].simbolo;
             }
-
-            for (const auto& statement : func_def->body) {
-                visit(statement, func_def->name);
+            if (ranuras[i].nombre == NINGUNO) {
+                return NINGUNO;
             }
+        }
+    }
 
-            funciones.push_back({func_def->name, func_def->return_type});
-        } else if (auto assign = dynamic_pointer_cast<Assign>(nodo)) {
-            string tipo_dato = obtener_tipo_dato(assign->value);
-            agregar_variable(assign->target, tipo_dato, ambito);
-        } else if (auto return_stmt = dynamic_pointer_cast<Return>(nodo)) {
-            // Analizar el valor de retorno
-            visit(return_stmt->value, ambito);
-        } else if (auto if_stmt = dynamic_pointer_cast<If>(nodo)) {
-            // Analizar la condición
-            visit(if_stmt->condition, ambito);
-            // Analizar el cuerpo del bloque "then"
-            for (const auto& stmt : if_stmt->then_body) {
-                visit(stmt, ambito);
-            }
-            // Analizar el cuerpo del bloque "else"
-            for (const auto& stmt : if_stmt->else_body) {
-                visit(stmt, ambito);
+    // El nombre no debe estar ya en el mapa
+    void insertar(IdNombre nombre, uint32_t simbolo) {
+        if ((ocupadas + 1) * 4 > ranuras.size() * 3) {
+            crecer();
+        }
+        size_t mascara = ranuras.size() - 1;
+        size_t i = posicion(nombre);
+        while (ranuras[i].nombre != NINGUNO) {
+            i = (i + 1) & mascara;
+        }
+        ranuras[i] = {nombre, simbolo};
+        ocupadas++;
+    }
+
+    // Deja el mapa vacío conservando su capacidad, para reutilizarlo en el siguiente ámbito
+    void vaciar() {
+        if (ocupadas > 0) {
+            fill(ranuras.begin(), ranuras.end(), Entrada{NINGUNO, NINGUNO});
+            ocupadas = 0;
+        }
+    }
+
+private:
+    struct Entrada {
+        IdNombre nombre;
+        uint32_t simbolo;
+    };
+
+    vector<Entrada> ranuras;
+    size_t ocupadas = 0;
+    unsigned bits = 0;
+
+    // Hash multiplicativo: los ids son consecutivos, así que se mezclan con la razón áurea
+    size_t posicion(IdNombre nombre) const {
+        return (nombre * 0x9E3779B1u) >> (32 - bits);
+    }
+
+    void crecer() {
+        vector<Entrada> anteriores = move(ranuras);
+        bits = max(4u, bits + 1);
+        ranuras.assign(size_t(1) << bits, Entrada{NINGUNO, NINGUNO});
+        ocupadas = 0;
+        for (const Entrada &entrada : anteriores) {
+            if (entrada.nombre != NINGUNO) {
+                insertar(entrada.nombre, entrada.simbolo);
             }
-        } else if (auto while_stmt = dynamic_pointer_cast<While>(nodo)) {
-            // Analizar la condición
-            visit(while_stmt->condition, ambito);
-            // Analizar el cuerpo del bucle
-            for (const auto& stmt : while_stmt->body) {
-                visit(stmt, ambito);
+        }
+    }
+};
+
+// Pila de ámbitos sobre una lista de símbolos en orden de declaración. Buscar recorre los
+// ámbitos de dentro hacia fuera, así que una declaración interna oculta a la externa.
+class TablaSimbolos {
+public:
+    TablaSimbolos() {
+        abrirAmbito(N_GLOBAL);
+    }
+
+    void abrirAmbito(IdNombre nombre) {
+        if (profundidad == ambitos.size()) {
+            ambitos.emplace_back();
+            nombresAmbito.emplace_back();
+        }
+        nombresAmbito[profundidad] = nombre;
+        profundidad++;
+    }
+
+    void cerrarAmbito() {
+        profundidad--;
+        ambitos[profundidad].vaciar();
+    }
+
+    // Nombre del ámbito actual (los bloques heredan el de la función que los contiene)
+    IdNombre ambitoActual() const {
+        return nombresAmbito[profundidad - 1];
+    }
+
+    // Declara el nombre en el ámbito actual; si ya estaba declarado ahí, actualiza su tipo
+    Simbolo &declarar(IdNombre nombre, IdNombre tipo) {
+        MapaAmbito &ambito = ambitos[profundidad - 1];
+        uint32_t existente = ambito.buscar(nombre);
+        if (existente != MapaAmbito::NINGUNO) {
+            simbolos[existente].tipo = tipo;
+            return simbolos[existente];
+        }
+        ambito.insertar(nombre, static_cast<uint32_t>(simbolos.size()));
+        simbolos.push_back({nombre, tipo, ambitoActual()});
+        return simbolos.back();
+    }
+
+    // Símbolo visible con ese nombre, o nullptr si no está declarado en ningún ámbito abierto
+    Simbolo *buscar(IdNombre nombre) {
+        for (size_t i = profundidad; i-- > 0;) {
+            uint32_t simbolo = ambitos[i].buscar(nombre);
+            if (simbolo != MapaAmbito::NINGUNO) {
+                return &simbolos[simbolo];
             }
         }
+        return nullptr;
+    }
+
+    const vector<Simbolo> &todos() const { return simbolos; }
+
+private:
+    vector<Simbolo> simbolos;
+    vector<MapaAmbito> ambitos;        // se reutilizan al volver a abrir un ámbito
+    vector<IdNombre> nombresAmbito;
+    size_t profundidad = 0;
+};
+
+class AnalizadorSemantic {
+private:
+    TablaSimbolos tabla;
+    vector<Funcion> funciones;
+
+public:
+    void analizar(ASTNode* arbol) {
+        visit(arbol);
+        imprimir_tabla_simbolos();
+    }
+
+    void visit(ASTNode* nodo) {
+        despachar(nodo, Sobrecarga{
+            [this](FunctionDef* func_def) {
+                tabla.abrirAmbito(func_def->name);
+                for (const auto& arg : func_def->args) {
+                    agregar_variable(arg, N_DESCONOCIDO); // Tipo desconocido por ahora
+                }
 
-        // Otros tipos de nodos...
+                for (const auto& statement : func_def->body) {
+                    visit(statement);
+                }
+                tabla.cerrarAmbito();
+
+                funciones.push_back({func_def->name, func_def->return_type});
+            },
+            [this](Assign* assign) {
+                if (assign->declared_type != N_VACIO) {
+                    // Declaración: crea la variable en el ámbito actual, ocultando las externas
+                    agregar_variable(assign->target, assign->declared_type);
+                } else if (!tabla.buscar(assign->target)) {
+                    // Asignación a una variable no declarada: se declara con el tipo del valor
+                    agregar_variable(assign->target, obtener_tipo_dato(assign->value));
+                }
+            },
+            [this](Return* return_stmt) {
+                // Analizar el valor de retorno
+                visit(return_stmt->value);
+            },
+            [this](If* if_stmt) {
+                // Analizar la condición
+                visit(if_stmt->condition);
+                // Analizar el cuerpo del bloque "then"
+                visitarBloque(if_stmt->then_body);
+                // Analizar el cuerpo del bloque "else"
+                visitarBloque(if_stmt->else_body);
+            },
+            [this](While* while_stmt) {
+                // Analizar la condición
+                visit(while_stmt->condition);
+                // Analizar el cuerpo del bucle
+                visitarBloque(while_stmt->body);
+            },
+            [](ASTNode*) {}
+        });
+    }
 
-        // Recorrer hijos del nodo (si los tiene)
+    // Cada bloque abre su propio ámbito, que se descarta al salir
+    void visitarBloque(ListaNodos cuerpo) {
+        tabla.abrirAmbito(tabla.ambitoActual());
+        for (const auto& stmt : cuerpo) {
+            visit(stmt);
+        }
+        tabla.cerrarAmbito();
     }
 
-    string obtener_tipo_dato(shared_ptr<ASTNode> nodo) {
-        if (auto literal = dynamic_pointer_cast<Literal>(nodo)) {
+    IdNombre obtener_tipo_dato(ASTNode* nodo) {
+        if (auto literal = nodoComo<Literal>(nodo)) {
             return literal->type;
         }
         // Otros casos para diferentes tipos de nodos...
-        return "desconocido";
+        return N_DESCONOCIDO;
     }
 
-    void agregar_variable(const string& nombre, const string& tipo, const string& ambito_actual) {
-        // Verificar si la variable ya existe en el ámbito actual
-        auto it = find_if(tabla_simbolos.begin(), tabla_simbolos.end(),
-                          [&nombre, &ambito_actual](const Simbolo& simbolo) {
-                              return simbolo.variable == nombre && simbolo.ambito == ambito_actual;
-                          });
-
-        if (it == tabla_simbolos.end()) {
-            // Si no existe, agregar la nueva variable
-            tabla_simbolos.push_back({nombre, tipo, ambito_actual});
-        } else {
-            // Si ya existe, actualizar el tipo si es necesario
-            it->tipo = tipo;
-        }
+    void agregar_variable(IdNombre nombre, IdNombre tipo) {
+        // Si ya existe en el ámbito actual solo se actualiza su tipo
+        tabla.declarar(nombre, tipo);
     }
 
     void imprimir_tabla_simbolos() {
         cout << "Variable\tTipo\tÁmbito\n";
-        for (const auto& simbolo : tabla_simbolos) {
-            cout << simbolo.variable << "\t" << simbolo.tipo << "\t" << simbolo.ambito << "\n";
+        for (const auto& simbolo : tabla.todos()) {
+            cout << nombreDe(simbolo.variable) << "\t" << nombreDe(simbolo.tipo) << "\t" << nombreDe(simbolo.ambito) << "\n";
         }
     }
 };
@@ -294,65 +1649,113 @@ bool parseTerm(const vector<Token> &tokens, size_t &pos); //Analiza y evalúa t
 bool parseFactor(const vector<Token> &tokens, size_t &pos); //Analiza y evalúa factores dentro de un término, que pueden ser operandos simples o subexpresiones dentro de paréntesis.
 bool parseUnary(const vector<Token> &tokens, size_t &pos);// Analiza valores binarios
 
-class BinaryOp : public ASTNode {
-public:
-    string op;
-    shared_ptr<ASTNode> left;
-    shared_ptr<ASTNode> right;
-
-    BinaryOp(const string& op, shared_ptr<ASTNode> left, shared_ptr<ASTNode> right)
-        : op(op), left(left), right(right) {}
+// Tokens [inicio, fin) que ocupa una sentencia
+struct RangoTokens {
+    uint32_t inicio;
+    uint32_t fin;
 };
 
-class UnaryOp : public ASTNode {
+class Parser {
 public:
-    string op;
-    shared_ptr<ASTNode> operand;
-
-    UnaryOp(const string& op, shared_ptr<ASTNode> operand)
-        : op(op), operand(operand) {}
-};
+    Parser(const Fuente& fuente, const vector<Token>& tokens, Arena& arena) : fuente(fuente), tokens(tokens), arena(arena), pos(0) {}
 
+    ASTNode* parse() {
+        return parseFunction();
+    }
 
+    // Tokens de cada sentencia del cuerpo de la función, después de parse()
+    const vector<RangoTokens>& rangosCuerpo() const {
+        return rangos;
+    }
 
-class Parser {
-public:
-    Parser(const vector<Token>& tokens) : tokens(tokens), pos(0) {}
+    // Analiza sentencias sueltas que deben ocupar exactamente los tokens [desde, hasta)
+    bool parseSentencias(size_t desde, size_t hasta, vector<ASTNode*>& sentencias, vector<RangoTokens>& rangosSentencias) {
+        pos = desde;
+        while (pos < hasta) {
+            size_t inicio = pos;
+            auto stmt = parseStatement();
+            if (!stmt || pos > hasta) {
+                return false;
+            }
+            sentencias.push_back(stmt);
+            rangosSentencias.push_back({static_cast<uint32_t>(inicio), static_cast<uint32_t>(pos)});
+        }
+        return true;
+    }
 
-    shared_ptr<ASTNode> parse() {
-        return parseFunction();
+    // Posición del último token examinado, para los mensajes de error
+    const Token& tokenActual() const {
+        return actual();
     }
 
 private:
-    vector<Token> tokens;
+    const Fuente& fuente;
+    const vector<Token>& tokens;
+    Arena& arena;
     size_t pos;
+    vector<ASTNode*> pendientes; // Pila de sentencias de los bloques abiertos, antes de copiarlas a la arena
+    vector<RangoTokens> rangos;  // Tokens de cada sentencia del cuerpo de la función
+
+    // Token actual; al pasar el final se devuelve un token vacío que no coincide con nada
+    const Token& actual() const {
+        static const Token fin{0, 0, 0, 0, TokenType::UNKNOWN};
+        return pos < tokens.size() ? tokens[pos] : fin;
+    }
 
-    shared_ptr<ASTNode> parseFunction() {
-        if (tokens[pos].type == TokenType::KEYWORD && tokens[pos].value == "int") {
+    string_view valorActual() const {
+        return fuente.lexema(actual());
+    }
+
+    bool esSimbolo(string_view simbolo) const {
+        return actual().type == TokenType::SYMBOL && valorActual() == simbolo;
+    }
+
+    bool esClave(string_view clave) const {
+        return actual().type == TokenType::KEYWORD && valorActual() == clave;
+    }
+
+    // Analiza declaraciones hasta la llave de cierre; falla si alguna no es válida.
+    // Si se pide, anota los tokens que ocupa cada sentencia.
+    bool parseBloque(ListaNodos& cuerpo, vector<RangoTokens>* rangosSentencias = nullptr) {
+        size_t inicio = pendientes.size();
+        while (pos < tokens.size() && !esSimbolo("}")) {
+            size_t primero = pos;
+            auto stmt = parseStatement();
+            if (!stmt) {
+                pendientes.resize(inicio);
+                return false;
+            }
+            pendientes.push_back(stmt);
+            if (rangosSentencias) {
+                rangosSentencias->push_back({static_cast<uint32_t>(primero), static_cast<uint32_t>(pos)});
+            }
+        }
+        if (!esSimbolo("}")) {
+            pendientes.resize(inicio);
+            return false;
+        }
+        pos++;
+        cuerpo = arena.copiar(pendientes.data() + inicio, pendientes.size() - inicio);
+        pendientes.resize(inicio);
+        return true;
+    }
+
+    ASTNode* parseFunction() {
+        if (esClave("int")) {
             pos++;
-            if (tokens[pos].type == TokenType::IDENTIFIER) {
-                string funcName = tokens[pos].value;
+            if (actual().type == TokenType::IDENTIFIER) {
+                IdNombre funcName = internar(valorActual());
                 pos++;
-                if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == "(") {
+                if (esSimbolo("(")) {
                     pos++;
                     // Ignorar argumentos por simplicidad
-                    if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == ")") {
+                    if (esSimbolo(")")) {
                         pos++;
-                        if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == "{") {
+                        if (esSimbolo("{")) {
                             pos++;
-                            vector<shared_ptr<ASTNode>> body;
-                            while (pos < tokens.size() && (tokens[pos].type != TokenType::SYMBOL || tokens[pos].value != "}")) {
-                                auto stmt = parseStatement();
-                                if (stmt) {
-                                    body.push_back(stmt);
-                                } else {
-                                    cerr << "Error al analizar la declaración en la función." << endl;
-                                    return nullptr;
-                                }
-                            }
-                            if (pos < tokens.size() && tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == "}") {
-                                pos++;
-                                return make_shared<FunctionDef>(funcName, vector<string>{}, body, "int");
+                            ListaNodos body;
+                            if (parseBloque(body, &rangos)) {
+                                return arena.crear<FunctionDef>(funcName, Lista<IdNombre>{}, body, N_INT);
                             }
                         }
                     }
@@ -362,158 +1765,162 @@ private:
         return nullptr;
     }
 
-    shared_ptr<ASTNode> parseStatement() {
-        if (tokens[pos].type == TokenType::KEYWORD && (tokens[pos].value == "int" || tokens[pos].value == "string")) {
+    ASTNode* parseStatement() {
+        if (esClave("int") || esClave("string")) {
             return parseDeclaration();
-        } else if (tokens[pos].type == TokenType::KEYWORD && tokens[pos].value == "if") {
+        } else if (esClave("if")) {
             return parseIf();
-        } else if (tokens[pos].type == TokenType::KEYWORD && tokens[pos].value == "while") {
+        } else if (esClave("while")) {
             return parseWhile();
-        } else if (tokens[pos].type == TokenType::KEYWORD && tokens[pos].value == "return") {
+        } else if (esClave("return")) {
             return parseReturn();
         } else {
             return parseAssignment();
         }
     }
 
-    shared_ptr<ASTNode> parseDeclaration() {
-        string type = tokens[pos].value;
+    ASTNode* parseDeclaration() {
+        IdNombre tipo = internar(valorActual());
         pos++;
-        if (tokens[pos].type == TokenType::IDENTIFIER) {
-            string varName = tokens[pos].value;
+        if (actual().type == TokenType::IDENTIFIER) {
+            IdNombre varName = internar(valorActual());
             pos++;
-            if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == "=") {
+            if (esSimbolo("=")) {
                 pos++;
                 auto value = parseExpression();
-                if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == ";") {
+                if (value && esSimbolo(";")) {
                     pos++;
-                    return make_shared<Assign>(varName, value);
+                    return arena.crear<Assign>(varName, value, tipo);
                 }
             }
         }
         return nullptr;
     }
 
-    shared_ptr<ASTNode> parseIf() {
+    ASTNode* parseIf() {
         pos++;
-        if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == "(") {
+        if (esSimbolo("(")) {
             pos++;
             auto condition = parseExpression();
-            if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == ")") {
+            if (condition && esSimbolo(")")) {
                 pos++;
-                if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == "{") {
+                if (esSimbolo("{")) {
                     pos++;
-                    vector<shared_ptr<ASTNode>> thenBody;
-                    while (pos < tokens.size() && (tokens[pos].type != TokenType::SYMBOL || tokens[pos].value != "}")) {
-                        thenBody.push_back(parseStatement());
+                    ListaNodos thenBody;
+                    if (!parseBloque(thenBody)) {
+                        return nullptr;
                     }
-                    pos++;
-                    vector<shared_ptr<ASTNode>> elseBody;
-                    if (tokens[pos].type == TokenType::KEYWORD && tokens[pos].value == "else") {
+                    ListaNodos elseBody;
+                    if (esClave("else")) {
                         pos++;
-                        if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == "{") {
-                            pos++;
-                            while (pos < tokens.size() && (tokens[pos].type != TokenType::SYMBOL || tokens[pos].value != "}")) {
-                                elseBody.push_back(parseStatement());
-                            }
-                            pos++;
+                        if (!esSimbolo("{")) {
+                            return nullptr;
+                        }
+                        pos++;
+                        if (!parseBloque(elseBody)) {
+                            return nullptr;
                         }
                     }
-                    return make_shared<If>(condition, thenBody, elseBody);
+                    return arena.crear<If>(condition, thenBody, elseBody);
                 }
             }
         }
         return nullptr;
     }
 
-    shared_ptr<ASTNode> parseWhile() {
+    ASTNode* parseWhile() {
         pos++;
-        if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == "(") {
+        if (esSimbolo("(")) {
             pos++;
             auto condition = parseExpression();
-            if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == ")") {
+            if (condition && esSimbolo(")")) {
                 pos++;
-                if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == "{") {
+                if (esSimbolo("{")) {
                     pos++;
-                    vector<shared_ptr<ASTNode>> body;
-                    while (pos < tokens.size() && (tokens[pos].type != TokenType::SYMBOL || tokens[pos].value != "}")) {
-                        body.push_back(parseStatement());
+                    ListaNodos body;
+                    if (parseBloque(body)) {
+                        return arena.crear<While>(condition, body);
                     }
-                    pos++;
-                    return make_shared<While>(condition, body);
                 }
             }
         }
         return nullptr;
     }
 
-    shared_ptr<ASTNode> parseReturn() {
+    ASTNode* parseReturn() {
         pos++;
         auto value = parseExpression();
-        if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == ";") {
+        if (value && esSimbolo(";")) {
             pos++;
-            return make_shared<Return>(value);
+            return arena.crear<Return>(value);
         }
         return nullptr;
     }
 
-    shared_ptr<ASTNode> parseAssignment() {
-        if (tokens[pos].type == TokenType::IDENTIFIER) {
-            string varName = tokens[pos].value;
+    ASTNode* parseAssignment() {
+        if (actual().type == TokenType::IDENTIFIER) {
+            IdNombre varName = internar(valorActual());
             pos++;
-            if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == "=") {
+            if (esSimbolo("=")) {
                 pos++;
                 auto value = parseExpression();
-                if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == ";") {
+                if (value && esSimbolo(";")) {
                     pos++;
-                    return make_shared<Assign>(varName, value);
+                    return arena.crear<Assign>(varName, value);
                 }
             }
         }
         return nullptr;
     }
 
-    shared_ptr<ASTNode> parseExpression() {
-        return parseBinaryOp(0);
+    ASTNode* parseExpression() {
+        return parseBinaryOp(1);
     }
 
-    shared_ptr<ASTNode> parseBinaryOp(int minPrecedence) {
+    // Precedencia por escalada: solo continúa mientras el token actual sea un operador binario
+    ASTNode* parseBinaryOp(int minPrecedence) {
         auto left = parseUnary();
-        while (pos < tokens.size() && getPrecedence(tokens[pos].value) >= minPrecedence) {
-            string op = tokens[pos].value;
-            int precedence = getPrecedence(op);
+        while (left && actual().type == TokenType::SYMBOL) {
+            int precedence = getPrecedence(valorActual());
+            if (precedence == 0 || precedence < minPrecedence) {
+                break;
+            }
+            IdNombre op = internar(valorActual());
             pos++;
-            auto right = parseUnary();
-            while (pos < tokens.size() && getPrecedence(tokens[pos].value) > precedence) {
-                right = parseBinaryOp(precedence + 1);
+            auto right = parseBinaryOp(precedence + 1);
+            if (!right) {
+                return nullptr;
             }
-            left = make_shared<BinaryOp>(op, left, right);
+            left = arena.crear<BinaryOp>(op, left, right);
         }
         return left;
     }
 
-    shared_ptr<ASTNode> parseUnary() {
-        if (tokens[pos].value == "-") {
+    ASTNode* parseUnary() {
+        if (esSimbolo("-")) {
             pos++;
             auto node = parsePrimary();
-            return make_shared<UnaryOp>("-", node);
+            if (!node) {
+                return nullptr;
+            }
+            return arena.crear<UnaryOp>(N_MENOS, node);
         }
         return parsePrimary();
     }
 
-    shared_ptr<ASTNode> parsePrimary() {
-        if (tokens[pos].type == TokenType::NUMBER) {
-            string value = tokens[pos].value;
+    ASTNode* parsePrimary() {
+        if (actual().type == TokenType::NUMBER) {
+            IdNombre value = internar(valorActual());
             pos++;
-            return make_shared<Literal>(value, "int");
-        } else if (tokens[pos].type == TokenType::IDENTIFIER) {
-            string value = tokens[pos].value;
+            return arena.crear<Literal>(value, N_INT);
+        } else if (actual().type == TokenType::IDENTIFIER) {
+            IdNombre value = internar(valorActual());
             pos++;
-            return make_shared<Literal>(value, "string");
-        } else if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == "(") {
+            return arena.crear<Literal>(value, N_STRING);
+        } else if (esSimbolo("(")) {
             pos++;
             auto node = parseExpression();
-            if (tokens[pos].type == TokenType::SYMBOL && tokens[pos].value == ")") {
+            if (node && esSimbolo(")")) {
                 pos++;
                 return node;
             }
@@ -521,34 +1928,353 @@ private:
         return nullptr;
     }
 
-    int getPrecedence(const string &op) {
-        if (op == "+" || op == "-") return 1;
-        if (op == "*" || op == "/") return 2;
+    int getPrecedence(string_view op) const {
+        if (op == "||") return 1;
+        if (op == "&&") return 2;
+        if (op == "==" || op == "!=") return 3;
+        if (op == "<" || op == ">" || op == "<=" || op == ">=") return 4;
+        if (op == "+" || op == "-") return 5;
+        if (op == "*" || op == "/" || op == "%") return 6;
         return 0;
     }
 };
 
-int main() {
-    ifstream file("prueba.txt");
+// ---------------------------------------------------------------------------
+// Análisis incremental: después de una edición se rehace solo la zona dañada
+// ---------------------------------------------------------------------------
+
+// Reemplaza `borrar` bytes a partir de `desplazamiento` por `texto`
+struct Edicion {
+    size_t desplazamiento;
+    size_t borrar;
+    string texto;
+};
+
+// Texto, tokens y AST de un archivo que se va editando. Una edición vuelve a tokenizar
+// desde el inicio de la línea dañada hasta que un token nuevo, ya pasado el texto
+// insertado, coincide con uno viejo desplazado (mismo inicio, largo y tipo): el léxico
+// solo depende de la posición, así que de ahí en adelante se reutilizan los tokens viejos
+// corrigiendo su posición. Después se vuelven a analizar solo las sentencias del cuerpo
+// de la función que tocan tokens cambiados y se reutilizan las demás, ya simplificadas.
+// Si la edición alcanza la cabecera o la llave final, o mueve el final de una sentencia,
+// se analiza todo de nuevo. Los nodos reemplazados quedan en la arena hasta entonces.
+class SesionIncremental {
+public:
+    // Trabajo hecho por la última carga o edición
+    struct Estadistica {
+        size_t tokensNuevos = 0;
+        size_t tokensReutilizados = 0;
+        size_t sentenciasNuevas = 0;
+        size_t sentenciasReutilizadas = 0;
+        bool completo = false;   // se analizó todo el archivo
+    };
 
-    // Verificar si el archivo se abrió correctamente
-    if (!file.is_open()) {
+    SesionIncremental(string texto, int nivel) : nivel(nivel), fuenteActual(move(texto)) {
+        lista = tokenize(fuenteActual);
+        ultima = {};
+        ultima.tokensNuevos = lista.size();
+        analizarTodo();
+    }
+
+    const Fuente& fuente() const { return fuenteActual; }
+    const vector<Token>& tokens() const { return lista; }
+    const Estadistica& estadistica() const { return ultima; }
+
+    // AST de la versión actual, o nullptr si tiene errores de sintaxis
+    ASTNode* ast() const { return raiz; }
+
+    // Token donde se detuvo el análisis cuando hay errores
+    const Token& tokenError() const { return error; }
+
+    void aplicar(const Edicion& edicion) {
+        size_t desde = min(edicion.desplazamiento, fuenteActual.contenido().size());
+        size_t borrar = min(edicion.borrar, fuenteActual.contenido().size() - desde);
+        fuenteActual.reemplazar(desde, borrar, edicion.texto);
+        string_view texto = fuenteActual.contenido();
+        int64_t delta = static_cast<int64_t>(edicion.texto.size()) - static_cast<int64_t>(borrar);
+        size_t finInsertado = desde + edicion.texto.size();
+
+        // Se vuelve a tokenizar desde el primer token de la línea donde empieza la edición.
+        // Lo anterior a `desde` no cambió, así que se puede mirar en el texto nuevo.
+        size_t salto = desde == 0 ? string_view::npos : texto.rfind('\n', desde - 1);
+        size_t inicioLinea = salto == string_view::npos ? 0 : salto + 1;
+        auto porInicio = [](const Token& t, size_t offset) { return t.offset < offset; };
+        size_t primero = lower_bound(lista.begin(), lista.end(), inicioLinea, porInicio) - lista.begin();
+        size_t previo = primero > 0 ? lista[primero - 1].offset : 0;
+        uint32_t linea = (primero > 0 ? lista[primero - 1].line : 1) +
+                         static_cast<uint32_t>(count(texto.begin() + previo, texto.begin() + inicioLinea, '\n'));
+
+        // Tokens nuevos hasta alcanzar uno viejo que no cambió
+        size_t viejo = lower_bound(lista.begin(), lista.end(), desde + borrar, porInicio) - lista.begin();
+        CursorLexico cursor(fuenteActual, inicioLinea, linea, inicioLinea);
+        vector<Token> nuevos;
+        Token token;
+        bool sincronizado = false;
+        while (cursor.siguiente(token)) {
+            if (token.offset >= finInsertado) {
+                while (viejo < lista.size() && lista[viejo].offset + delta < token.offset) {
+                    viejo++;
+                }
+                if (viejo < lista.size() && lista[viejo].offset + delta == token.offset &&
+                    lista[viejo].length == token.length && lista[viejo].type == token.type) {
+                    sincronizado = true;
+                    break;
+                }
+            }
+            nuevos.push_back(token);
+        }
+        if (!sincronizado) {
+            viejo = lista.size();
+        }
+
+        // Los tokens reutilizados se corren en su lugar; los de la línea donde se
+        // resincronizó también cambian de columna
+        if (sincronizado) {
+            uint32_t lineaVieja = lista[viejo].line;
+            int64_t deltaLineas = static_cast<int64_t>(token.line) - lineaVieja;
+            for (size_t i = viejo; i < lista.size(); i++) {
+                Token& t = lista[i];
+                bool mismaLinea = t.line == lineaVieja;
+                t.offset = static_cast<uint32_t>(t.offset + delta);
+                t.line = static_cast<uint32_t>(t.line + deltaLineas);
+                if (mismaLinea) {
+                    t.column = cursor.columnaDe(t.offset);
+                }
+            }
+        }
+        size_t reemplazados = viejo - primero;
+        if (nuevos.size() > reemplazados) {
+            lista.insert(lista.begin() + viejo, nuevos.size() - reemplazados, Token{});
+        } else {
+            lista.erase(lista.begin() + primero + nuevos.size(), lista.begin() + viejo);
+        }
+        copy(nuevos.begin(), nuevos.end(), lista.begin() + primero);
+
+        // Tokens viejos [primero, viejo) reemplazados por los nuevos
+        int64_t deltaTokens = static_cast<int64_t>(nuevos.size()) - static_cast<int64_t>(reemplazados);
+        ultima = {};
+        ultima.tokensNuevos = nuevos.size();
+        ultima.tokensReutilizados = lista.size() - nuevos.size();
+        if (primero == viejo && nuevos.empty() && raiz) {
+            // Solo cambiaron espacios: el AST sigue igual
+            ultima.sentenciasReutilizadas = rangos.size();
+            return;
+        }
+        if (!raiz || rangos.empty() || primero < rangos.front().inicio || viejo > rangos.back().fin) {
+            analizarTodo();
+            return;
+        }
+
+        // Se agranda el tramo hasta bordes de sentencia
+        size_t inicio = primero, fin = viejo;
+        auto primeraQueTermina = lower_bound(rangos.begin(), rangos.end(), inicio + 1,
+                                             [](const RangoTokens& r, size_t i) { return r.fin < i; });
+        if (primeraQueTermina != rangos.end() && primeraQueTermina->inicio < inicio) {
+            inicio = primeraQueTermina->inicio;
+        }
+        auto primeraDespues = lower_bound(rangos.begin(), rangos.end(), fin,
+                                          [](const RangoTokens& r, size_t i) { return r.inicio < i; });
+        if (primeraDespues != rangos.begin() && prev(primeraDespues)->fin > fin) {
+            fin = prev(primeraDespues)->fin;
+        }
+        auto desdeSentencia = lower_bound(rangos.begin(), rangos.end(), inicio,
+                                          [](const RangoTokens& r, size_t i) { return r.inicio < i; });
+        auto hastaSentencia = lower_bound(rangos.begin(), rangos.end(), fin,
+                                          [](const RangoTokens& r, size_t i) { return r.inicio < i; });
+        size_t s1 = desdeSentencia - rangos.begin();
+        size_t s2 = hastaSentencia - rangos.begin();
+
+        Parser parser(fuenteActual, lista, arena);
+        vector<ASTNode*> sentencias;
+        vector<RangoTokens> rangosNuevos;
+        if (!parser.parseSentencias(inicio, static_cast<size_t>(fin + deltaTokens), sentencias, rangosNuevos)) {
+            analizarTodo();
+            return;
+        }
+        SimplificadorAST simplificador(arena, nivel);
+        for (ASTNode* stmt : sentencias) {
+            simplificador.simplificar(stmt);
+        }
+
+        auto funcion = static_cast<FunctionDef*>(raiz);
+        vector<ASTNode*> cuerpo(funcion->body.begin(), funcion->body.begin() + s1);
+        cuerpo.insert(cuerpo.end(), sentencias.begin(), sentencias.end());
+        cuerpo.insert(cuerpo.end(), funcion->body.begin() + s2, funcion->body.end());
+        for (size_t i = s2; i < rangos.size(); i++) {
+            rangos[i].inicio = static_cast<uint32_t>(rangos[i].inicio + deltaTokens);
+            rangos[i].fin = static_cast<uint32_t>(rangos[i].fin + deltaTokens);
+        }
+        rangos.erase(rangos.begin() + s1, rangos.begin() + s2);
+        rangos.insert(rangos.begin() + s1, rangosNuevos.begin(), rangosNuevos.end());
+        raiz = arena.crear<FunctionDef>(funcion->name, funcion->args, arena.copiar(cuerpo.data(), cuerpo.size()),
+                                        funcion->return_type);
+        ultima.sentenciasNuevas = sentencias.size();
+        ultima.sentenciasReutilizadas = cuerpo.size() - sentencias.size();
+    }
+
+private:
+    int nivel;
+    Fuente fuenteActual;
+    vector<Token> lista;
+    Arena arena;
+    ASTNode* raiz = nullptr;
+    vector<RangoTokens> rangos;   // Tokens de cada sentencia del cuerpo de la función
+    Token error{};
+    Estadistica ultima;
+
+    void analizarTodo() {
+        arena.liberar();
+        Parser parser(fuenteActual, lista, arena);
+        raiz = parser.parse();
+        rangos = parser.rangosCuerpo();
+        ultima.completo = true;
+        ultima.sentenciasNuevas = rangos.size();
+        ultima.sentenciasReutilizadas = 0;
+        if (!raiz) {
+            error = parser.tokenActual();
+            rangos.clear();
+            return;
+        }
+        SimplificadorAST simplificador(arena, nivel);
+        simplificador.simplificar(raiz);
+    }
+};
+
+// Texto de una edición escrito en la línea de órdenes: \n, \t y \\ son escapes
+string desescapar(string_view texto) {
+    string resultado;
+    for (size_t i = 0; i < texto.size(); i++) {
+        if (texto[i] == '\\' && i + 1 < texto.size()) {
+            char c = texto[++i];
+            resultado += c == 'n' ? '\n' : c == 't' ? '\t' : c;
+        } else {
+            resultado += texto[i];
+        }
+    }
+    return resultado;
+}
+
+// AST impreso, para comparar dos versiones
+string textoAST(ASTNode* ast) {
+    ostringstream salida;
+    streambuf* anterior = cout.rdbuf(salida.rdbuf());
+    imprimirAST(ast);
+    cout.rdbuf(anterior);
+    return salida.str();
+}
+
+bool mismosTokens(const vector<Token>& a, const vector<Token>& b) {
+    return equal(a.begin(), a.end(), b.begin(), b.end(), [](const Token& x, const Token& y) {
+        return x.offset == y.offset && x.length == y.length && x.line == y.line && x.column == y.column && x.type == y.type;
+    });
+}
+
+// Modo --incremental: aplica las ediciones en orden y compara cada resultado, en
+// tiempo y contenido, con analizar desde cero el texto editado
+int ejecutarIncremental(const string& ruta, const vector<Edicion>& ediciones, int nivel) {
+    Fuente archivo;
+    if (!archivo.abrir(ruta)) {
         cout << "Error al abrir el archivo." << endl;
-        return 1; // O gestiona el error de otra manera
+        return 1;
     }
+    auto medir = [](auto&& accion) {
+        auto inicio = chrono::steady_clock::now();
+        accion();
+        return chrono::duration<double, micro>(chrono::steady_clock::now() - inicio).count();
+    };
 
-    string line;
-    vector<Token> tokens;
+    unique_ptr<SesionIncremental> sesion;
+    double inicial = medir([&] { sesion = make_unique<SesionIncremental>(string(archivo.contenido()), nivel); });
+    cout << fixed << setprecision(1);
+    cout << ruta << ": " << sesion->tokens().size() << " tokens, " << sesion->estadistica().sentenciasNuevas
+         << " sentencias, análisis completo en " << inicial << " µs" << endl;
+
+    bool coinciden = true;
+    for (size_t e = 0; e < ediciones.size(); e++) {
+        double incremental = medir([&] { sesion->aplicar(ediciones[e]); });
+        unique_ptr<SesionIncremental> completa;
+        double desdeCero = medir([&] { completa = make_unique<SesionIncremental>(string(sesion->fuente().contenido()), nivel); });
+
+        const SesionIncremental::Estadistica& est = sesion->estadistica();
+        cout << "Edición " << e + 1 << ": " << est.tokensNuevos << " tokens nuevos y " << est.tokensReutilizados
+             << " reutilizados; " << est.sentenciasNuevas << " sentencias analizadas y " << est.sentenciasReutilizadas
+             << " reutilizadas" << (est.completo ? " (análisis completo)" : "") << "; " << incremental
+             << " µs contra " << desdeCero << " µs desde cero";
+
+        bool igual = mismosTokens(sesion->tokens(), completa->tokens()) && !sesion->ast() == !completa->ast();
+        if (igual && sesion->ast()) {
+            igual = textoAST(sesion->ast()) == textoAST(completa->ast());
+        } else if (igual) {
+            igual = sesion->tokenError().offset == completa->tokenError().offset;
+        }
+        coinciden = coinciden && igual;
+        cout << (igual ? "" : "; NO coincide con el análisis completo") << endl;
+    }
 
-    // Leer cada línea del archivo
-    while (getline(file, line)) {
-        vector<Token> line_tokens = tokenize(line);
-        tokens.insert(tokens.end(), line_tokens.begin(), line_tokens.end());
+    if (sesion->ast()) {
+        cout << "Árbol de Sintaxis Abstracta (AST) final:" << endl;
+        imprimirAST(sesion->ast());
+    } else {
+        const Token& error = sesion->tokenError();
+        cout << "Error al analizar la declaración en la función (línea " << error.line
+             << ", columna " << error.column << ")." << endl;
     }
+    return coinciden ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    // Argumentos: [-O0|-O1|-O2] [archivo]; por defecto -O1 y prueba.txt
+    //           --incremental [-Ox] archivo desplazamiento borrar texto [desplazamiento borrar texto]...
+    int nivelOptimizacion = 1;
+    string ruta = "prueba.txt";
+    bool incremental = false;
+    vector<string> resto;
+    for (int i = 1; i < argc; i++) {
+        string argumento = argv[i];
+        if (argumento.size() == 3 && argumento.compare(0, 2, "-O") == 0 && argumento[2] >= '0' && argumento[2] <= '2') {
+            nivelOptimizacion = argumento[2] - '0';
+        } else if (argumento == "--incremental") {
+            incremental = true;
+        } else if (incremental && !resto.empty()) {
+            resto.push_back(argumento);
+        } else {
+            ruta = argumento;
+            resto.push_back(argumento);
+        }
+    }
+    if (incremental) {
+        // Desplazamiento y cantidad a borrar son enteros sin signo escritos completos
+        auto leerNumero = [](const string& texto, size_t& valor) {
+            auto [ultimo, error] = from_chars(texto.data(), texto.data() + texto.size(), valor);
+            return error == errc() && ultimo == texto.data() + texto.size();
+        };
+        vector<Edicion> ediciones;
+        bool valido = resto.size() >= 4 && (resto.size() - 1) % 3 == 0;
+        for (size_t i = 1; valido && i < resto.size(); i += 3) {
+            Edicion edicion{0, 0, desescapar(resto[i + 2])};
+            valido = leerNumero(resto[i], edicion.desplazamiento) && leerNumero(resto[i + 1], edicion.borrar);
+            ediciones.push_back(move(edicion));
+        }
+        if (!valido) {
+            cout << "Uso: --incremental [-Ox] archivo desplazamiento borrar texto [desplazamiento borrar texto]..." << endl;
+            return 1;
+        }
+        return ejecutarIncremental(ruta, ediciones, nivelOptimizacion);
+    }
+
+    // Proyectar el archivo completo en memoria y verificar que se abrió correctamente
+    Fuente fuente;
+    if (!fuente.abrir(ruta)) {
+        cout << "Error al abrir el archivo." << endl;
+        return 1; // O gestiona el error de otra manera
+    }
+
+    // Analizar todo el texto en una sola pasada
+    vector<Token> tokens = tokenize(fuente);
 
     // Imprimir los tokens identificados
     for (const Token &token : tokens) {
-        cout << "Token: " << token.value << ", Tipo: ";
+        cout << "Token: " << fuente.lexema(token) << ", Tipo: ";
         switch (token.type) {
             case TokenType::KEYWORD:
                 cout << "Palabra clave";
@@ -570,8 +2296,16 @@ int main() {
     }
 
     // Crear el parser y analizar los tokens
-    Parser parser(tokens);
-    auto ast = parser.parse();
+    // Todo el AST se crea en esta arena y se libera de una sola vez al terminar
+    Arena arena;
+    Parser parser(fuente, tokens, arena);
+    ASTNode* ast = parser.parse();
+
+    // Plegar constantes y simplificar expresiones según el nivel de optimización
+    if (ast) {
+        SimplificadorAST simplificador(arena, nivelOptimizacion);
+        simplificador.simplificar(ast);
+    }
 
     // Verificar si el análisis sintáctico fue exitoso
     if (ast) {
@@ -579,7 +2313,9 @@ int main() {
         cout << "Árbol de Sintaxis Abstracta (AST):" << endl;
         imprimirAST(ast);
     } else {
-        cout << "Error al analizar la declaración en la función." << endl;
+        const Token& error = parser.tokenActual();
+        cout << "Error al analizar la declaración en la función (línea " << error.line
+             << ", columna " << error.column << ")." << endl;
         return 1;
     }
 
@@ -6,6 +6,18 @@
 #include <memory>
 #include <unordered_map>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -24,30 +36,188 @@ struct Token {
     string value;
 };
 
-// Función para clasificar palabras
-TokenType identifyToken(const string &word) {
-    // Palabras clave
-    const vector<string> keywords = {
+// Texto fuente completo, de solo lectura. El archivo se proyecta en memoria (mmap o
+// MapViewOfFile) y, si no se puede, se lee con una sola lectura.
+class Fuente {
+public:
+    Fuente() = default;
+    explicit Fuente(string texto) : copia(move(texto)), datos(copia.data()), tamano(copia.size()) {}
+    Fuente(const Fuente &) = delete;
+    Fuente &operator=(const Fuente &) = delete;
+    ~Fuente() { liberar(); }
+
+    // Abre el archivo indicado; devuelve false si no se puede leer
+    bool abrir(const string &ruta) {
+        liberar();
+#ifdef _WIN32
+        HANDLE archivo = CreateFileA(ruta.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                     FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (archivo != INVALID_HANDLE_VALUE) {
+            LARGE_INTEGER tam;
+            if (GetFileSizeEx(archivo, &tam) && tam.QuadPart > 0) {
+                HANDLE proyeccion = CreateFileMappingA(archivo, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (proyeccion) {
+                    void *vista = MapViewOfFile(proyeccion, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(proyeccion);
+                    if (vista) {
+                        CloseHandle(archivo);
+                        mapeo = vista;
+                        datos = static_cast<const char *>(vista);
+                        tamano = static_cast<size_t>(tam.QuadPart);
+                        return true;
+                    }
+                }
+            }
+            CloseHandle(archivo);
+        }
+#else
+        int fd = open(ruta.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+                void *vista = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (vista != MAP_FAILED) {
+                    madvise(vista, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                    close(fd);
+                    mapeo = vista;
+                    datos = static_cast<const char *>(vista);
+                    tamano = static_cast<size_t>(info.st_size);
+                    return true;
+                }
+            }
+            close(fd);
+        }
+#endif
+        // Alternativa: leer todo el archivo con una sola lectura
+        ifstream archivo(ruta, ios::binary);
+        if (!archivo.is_open()) {
+            return false;
+        }
+        archivo.seekg(0, ios::end);
+        streamoff tam = archivo.tellg();
+        if (tam < 0) {
+            // Sin tamaño conocido (p. ej. una tubería): se lee el flujo hasta el final
+            archivo.clear();
+            copia.assign(istreambuf_iterator<char>(archivo), istreambuf_iterator<char>());
+            datos = copia.data();
+            tamano = copia.size();
+            return true;
+        }
+        archivo.seekg(0, ios::beg);
+        copia.resize(static_cast<size_t>(tam));
+        if (!archivo.read(&copia[0], tam)) {
+            copia.clear();
+            return false;
+        }
+        datos = copia.data();
+        tamano = copia.size();
+        return true;
+    }
+
+    string_view contenido() const { return string_view(datos, tamano); }
+
+private:
+    string copia;             // Solo se usa cuando el texto no viene de una proyección
+    const char *datos = nullptr;
+    size_t tamano = 0;
+    void *mapeo = nullptr;    // Vista proyectada, o nullptr si se usa la copia
+
+    void liberar() {
+        if (mapeo) {
+#ifdef _WIN32
+            UnmapViewOfFile(mapeo);
+#else
+            munmap(mapeo, tamano);
+#endif
+            mapeo = nullptr;
+        }
+        copia.clear();
+        datos = nullptr;
+        tamano = 0;
+    }
+};
+
+
+// Palabras clave del lenguaje
+constexpr string_view PALABRAS_CLAVE[] = {
         "auto", "break", "case", "catch", "class", "const", "continue", "default", "delete",
         "do", "else", "enum", "explicit", "export", "extern", "false", "for", "friend", "goto",
         "if", "inline", "mutable", "namespace", "new", "operator", "private", "protected", "public",
         "register", "reinterpret_cast", "return", "sizeof", "static", "static_cast", "struct", "switch",
         "template", "this", "throw", "true", "try", "typedef", "typeid", "typename", "union", "using",
         "virtual", "void", "volatile", "while", "int", "string"
-    };
+};
+
+// Símbolos de un solo carácter
+constexpr string_view SIMBOLOS = "+-*/%(){}=;";
+
+// Tabla hash perfecta de palabras clave, generada en tiempo de compilación.
+// La función hash solo mira la longitud y tres caracteres (primero, segundo y último),
+// y se busca una semilla con la que ninguna palabra clave colisione.
+constexpr int BITS_TABLA_CLAVES = 8;
+
+constexpr uint32_t hashPalabraClave(string_view palabra, uint32_t semilla) {
+    uint32_t h = (semilla ^ static_cast<uint32_t>(palabra.size())) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[0])) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[palabra.size() > 1 ? 1 : 0])) * 0x01000193u;
+    h = (h ^ static_cast<unsigned char>(palabra[palabra.size() - 1])) * 0x01000193u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    return h >> (32 - BITS_TABLA_CLAVES);
+}
 
+struct TablaPalabrasClave {
+    uint32_t semilla;
+    array<string_view, 1 << BITS_TABLA_CLAVES> ranuras;
+};
+
+constexpr TablaPalabrasClave construirTablaPalabrasClave() {
+    for (uint32_t semilla = 1; semilla < 100000; semilla++) {
+        // Primero se prueba la semilla con un mapa de ranuras ocupadas
+        array<bool, 1 << BITS_TABLA_CLAVES> ocupadas{};
+        bool sinColisiones = true;
+        for (string_view palabra : PALABRAS_CLAVE) {
+            bool &ocupada = ocupadas[hashPalabraClave(palabra, semilla)];
+            if (ocupada) {
+                sinColisiones = false;
+                break;
+            }
+            ocupada = true;
+        }
+        if (!sinColisiones) continue;
+
+        TablaPalabrasClave tabla{semilla, {}};
+        for (string_view palabra : PALABRAS_CLAVE) {
+            tabla.ranuras[hashPalabraClave(palabra, semilla)] = palabra;
+        }
+        return tabla;
+    }
+    return {0, {}};
+}
+
+constexpr TablaPalabrasClave TABLA_PALABRAS_CLAVE = construirTablaPalabrasClave();
+static_assert(TABLA_PALABRAS_CLAVE.semilla != 0, "No se encontró una semilla sin colisiones para las palabras clave");
+
+// Búsqueda en O(1): una sola ranura candidata y una comparación
+inline bool esPalabraClave(string_view palabra) {
+    if (palabra.empty()) return false;
+    return TABLA_PALABRAS_CLAVE.ranuras[hashPalabraClave(palabra, TABLA_PALABRAS_CLAVE.semilla)] == palabra;
+}
+
+// Función para clasificar palabras
+TokenType identifyToken(string_view word) {
     // Verificar si es una palabra clave
-    if (find(keywords.begin(), keywords.end(), word) != keywords.end()) {
+    if (esPalabraClave(word)) {
         return TokenType::KEYWORD;
     }
 
     // Verificar si es un número (simplificación: solo enteros)
-    if (all_of(word.begin(), word.end(), ::isdigit)) {
+    if (all_of(word.begin(), word.end(), [](unsigned char c) { return isdigit(c) != 0; })) {
         return TokenType::NUMBER;
     }
 
     // Verificar si es un símbolo
-    if (word.size() == 1 && string("+-*/%(){}=;").find(word) != string::npos) {
+    if (word.size() == 1 && SIMBOLOS.find(word) != string::npos) {
         return TokenType::SYMBOL;
     }
 
@@ -56,11 +226,11 @@ TokenType identifyToken(const string &word) {
 }
 
 // Función para separar tokens considerando símbolos individuales
-vector<Token> tokenize(const string &line) {
+vector<Token> tokenize(string_view texto) {
     vector<Token> tokens;
     string word;
-    for (char ch : line) {
-        if (isspace(ch)) {
+    for (char ch : texto) {
+        if (isspace(static_cast<unsigned char>(ch))) {
             if (!word.empty()) {
                 tokens.push_back({identifyToken(word), word});
                 word.clear();
@@ -131,10 +301,11 @@ void imprimirAST(shared_ptr<ASTNode> nodo, int nivel = 0) {
 // Otros nodos del AST como Return, AnnAssign, etc.
 
 // Estructuras para el analizador semántico
+// Los textos apuntan al internador de la tabla y al AST, que viven más que el análisis
 struct Simbolo {
-    string variable;
-    string tipo;
-    string ambito;
+    string_view variable;
+    string_view tipo;
+    string_view ambito;
 };
 
 struct Funcion {
@@ -142,31 +313,258 @@ struct Funcion {
     string tipo;
 };
 
+// ---------------------------------------------------------------------------
+// Tabla de símbolos: nombres internados, un mapa hash por ámbito y una pila de ámbitos
+// ---------------------------------------------------------------------------
+
+// FNV-1a de 32 bits sobre el texto del nombre
+inline uint32_t hashNombre(string_view texto) {
+    uint32_t h = 0x811C9DC5u;
+    for (unsigned char c : texto) {
+        h = (h ^ c) * 0x01000193u;
+    }
+    return h;
+}
+
+// Asigna a cada nombre distinto un número consecutivo. Después de internar, dos nombres
+// son iguales si y solo si sus números lo son. Guarda su propia copia de cada texto.
+class Internador {
+public:
+    static constexpr uint32_t NINGUNO = UINT32_MAX;
+
+    uint32_t internar(string_view texto) {
+        if ((textos.size() + 1) * 2 > ranuras.size()) {
+            crecer();
+        }
+        uint32_t h = hashNombre(texto);
+        size_t i = ranura(texto, h);
+        if (ranuras[i] == NINGUNO) {
+            ranuras[i] = static_cast<uint32_t>(textos.size());
+            textos.push_back(guardar(texto));
+            hashes.push_back(h);
+        }
+        return ranuras[i];
+    }
+
+    // Número de un nombre ya internado, o NINGUNO; no agrega nada
+    uint32_t buscar(string_view texto) const {
+        return ranuras.empty() ? NINGUNO : ranuras[ranura(texto, hashNombre(texto))];
+    }
+
+    string_view texto(uint32_t id) const { return textos[id]; }
+    size_t size() const { return textos.size(); }
+
+private:
+    static constexpr size_t TAM_BLOQUE = 64 * 1024;
+
+    vector<string_view> textos;    // id -> texto
+    vector<uint32_t> hashes;       // id -> hash, para no recalcularlo al crecer
+    vector<uint32_t> ranuras;      // direccionamiento abierto con sondeo lineal
+    vector<unique_ptr<char[]>> bloques;
+    char *libre = nullptr;
+    char *fin = nullptr;
+
+    // Ranura que contiene el nombre, o la ranura libre donde debería ir
+    size_t ranura(string_view texto, uint32_t h) const {
+        size_t mascara = ranuras.size() - 1;
+        size_t i = h & mascara;
+        while (ranuras[i] != NINGUNO && (hashes[ranuras[i]] != h || textos[ranuras[i]] != texto)) {
+            i = (i + 1) & mascara;
+        }
+        return i;
+    }
+
+    void crecer() {
+        ranuras.assign(max<size_t>(64, ranuras.size() * 2), NINGUNO);
+        size_t mascara = ranuras.size() - 1;
+        for (uint32_t id = 0; id < textos.size(); id++) {
+            size_t i = hashes[id] & mascara;
+            while (ranuras[i] != NINGUNO) {
+                i = (i + 1) & mascara;
+            }
+            ranuras[i] = id;
+        }
+    }
+
+    string_view guardar(string_view texto) {
+        if (texto.size() > static_cast<size_t>(fin - libre)) {
+            size_t tam = max(TAM_BLOQUE, texto.size());
+            bloques.emplace_back(new char[tam]);
+            libre = bloques.back().get();
+            fin = libre + tam;
+        }
+        char *copia = libre;
+        copy(texto.begin(), texto.end(), copia);
+        libre += texto.size();
+        return {copia, texto.size()};
+    }
+};
+
+// Mapa de un ámbito: id de nombre -> índice del símbolo, con direccionamiento abierto
+class MapaAmbito {
+public:
+    static constexpr uint32_t NINGUNO = UINT32_MAX;
+
+    uint32_t buscar(uint32_t nombre) const {
+        if (ocupadas == 0) {
+            return NINGUNO;
+        }
+        size_t mascara = ranuras.size() - 1;
+        for (size_t i = posicion(nombre);; i = (i + 1) & mascara) {
+            if (ranuras[i].nombre == nombre) {
+                return ranuras[i].simbolo;
+            }
+            if (ranuras[i].nombre == NINGUNO) {
+                return NINGUNO;
+            }
+        }
+    }
+
+    // El nombre no debe estar ya en el mapa
+    void insertar(uint32_t nombre, uint32_t simbolo) {
+        if ((ocupadas + 1) * 4 > ranuras.size() * 3) {
+            crecer();
+        }
+        size_t mascara = ranuras.size() - 1;
+        size_t i = posicion(nombre);
+        while (ranuras[i].nombre != NINGUNO) {
+            i = (i + 1) & mascara;
+        }
+        ranuras[i] = {nombre, simbolo};
+        ocupadas++;
+    }
+
+    // Deja el mapa vacío conservando su capacidad, para reutilizarlo en el siguiente ámbito
+    void vaciar() {
+        if (ocupadas > 0) {
+            fill(ranuras.begin(), ranuras.end(), Entrada{NINGUNO, NINGUNO});
+            ocupadas = 0;
+        }
+    }
+
+private:
+    struct Entrada {
+        uint32_t nombre;
+        uint32_t simbolo;
+    };
+
+    vector<Entrada> ranuras;
+    size_t ocupadas = 0;
+    unsigned bits = 0;
+
+    // Hash multiplicativo: los ids son consecutivos, así que se mezclan con la razón áurea
+    size_t posicion(uint32_t nombre) const {
+        return (nombre * 0x9E3779B1u) >> (32 - bits);
+    }
+
+    void crecer() {
+        vector<Entrada> anteriores = move(ranuras);
+        bits = max(4u, bits + 1);
+        ranuras.assign(size_t(1) << bits, Entrada{NINGUNO, NINGUNO});
+        ocupadas = 0;
+        for (const Entrada &entrada : anteriores) {
+            if (entrada.nombre != NINGUNO) {
+                insertar(entrada.nombre, entrada.simbolo);
+            }
+        }
+    }
+};
+
+// Pila de ámbitos sobre una lista de símbolos en orden de declaración. Buscar recorre los
+// ámbitos de dentro hacia fuera, así que una declaración interna oculta a la externa.
+class TablaSimbolos {
+public:
+    TablaSimbolos() {
+        abrirAmbito("global");
+    }
+
+    void abrirAmbito(string_view nombre) {
+        if (profundidad == ambitos.size()) {
+            ambitos.emplace_back();
+            nombresAmbito.emplace_back();
+        }
+        nombresAmbito[profundidad] = nombre;
+        profundidad++;
+    }
+
+    void cerrarAmbito() {
+        profundidad--;
+        ambitos[profundidad].vaciar();
+    }
+
+    // Nombre del ámbito actual (los bloques heredan el de la función que los contiene)
+    string_view ambitoActual() const {
+        return nombresAmbito[profundidad - 1];
+    }
+
+    // Declara el nombre en el ámbito actual; si ya estaba declarado ahí, actualiza su tipo
+    Simbolo &declarar(string_view nombre, string_view tipo) {
+        uint32_t id = nombres.internar(nombre);
+        MapaAmbito &ambito = ambitos[profundidad - 1];
+        uint32_t existente = ambito.buscar(id);
+        if (existente != MapaAmbito::NINGUNO) {
+            simbolos[existente].tipo = tipo;
+            return simbolos[existente];
+        }
+        ambito.insertar(id, static_cast<uint32_t>(simbolos.size()));
+        simbolos.push_back({nombres.texto(id), tipo, ambitoActual()});
+        return simbolos.back();
+    }
+
+    // Símbolo visible con ese nombre, o nullptr si no está declarado en ningún ámbito abierto
+    Simbolo *buscar(string_view nombre) {
+        uint32_t id = nombres.buscar(nombre);
+        if (id == Internador::NINGUNO) {
+            return nullptr;
+        }
+        for (size_t i = profundidad; i-- > 0;) {
+            uint32_t simbolo = ambitos[i].buscar(id);
+            if (simbolo != MapaAmbito::NINGUNO) {
+                return &simbolos[simbolo];
+            }
+        }
+        return nullptr;
+    }
+
+    const vector<Simbolo> &todos() const { return simbolos; }
+
+private:
+    Internador nombres;
+    vector<Simbolo> simbolos;
+    vector<MapaAmbito> ambitos;        // se reutilizan al volver a abrir un ámbito
+    vector<string_view> nombresAmbito;
+    size_t profundidad = 0;
+};
+
 class AnalizadorSemantic {
 private:
-    vector<Simbolo> tabla_simbolos;
+    TablaSimbolos tabla;
     vector<Funcion> funciones;
 
 public:
     void analizar(shared_ptr<ASTNode> arbol) {
-        visit(arbol, "global");
+        visit(arbol);
         imprimir_tabla_simbolos();
     }
 
-    void visit(shared_ptr<ASTNode> nodo, const string& ambito) {
+    void visit(shared_ptr<ASTNode> nodo) {
         if (auto func_def = dynamic_pointer_cast<FunctionDef>(nodo)) {
+            tabla.abrirAmbito(func_def->name);
             for (const auto& arg : func_def->args) {
-                agregar_variable(arg, "desconocido", func_def->name); // Tipo desconocido por ahora
+                agregar_variable(arg, "desconocido"); // Tipo desconocido por ahora
             }
 
             for (const auto& statement : func_def->body) {
-                visit(statement, func_def->name);
+                visit(statement);
             }
+            tabla.cerrarAmbito();
 
             funciones.push_back({func_def->name, func_def->return_type});
         } else if (auto assign = dynamic_pointer_cast<Assign>(nodo)) {
-            string tipo_dato = obtener_tipo_dato(assign->value);
-            agregar_variable(assign->target, tipo_dato, ambito);
+            // Una asignación a una variable ya visible no declara nada nuevo
+            if (!tabla.buscar(assign->target)) {
+                agregar_variable(assign->target, obtener_tipo_dato(assign->value));
+            }
         }
 
         // Otros tipos de nodos...
@@ -174,7 +572,7 @@ public:
         // Recorrer hijos del nodo (si los tiene)
     }
 
-    string obtener_tipo_dato(shared_ptr<ASTNode> nodo) {
+    string_view obtener_tipo_dato(shared_ptr<ASTNode> nodo) {
         if (auto literal = dynamic_pointer_cast<Literal>(nodo)) {
             return literal->type;
         }
@@ -182,13 +580,14 @@ public:
         return "desconocido";
     }
 
-    void agregar_variable(const string& nombre, const string& tipo, const string& ambito_actual) {
-        tabla_simbolos.push_back({nombre, tipo, ambito_actual});
+    void agregar_variable(string_view nombre, string_view tipo) {
+        // Si ya existe en el ámbito actual solo se actualiza su tipo
+        tabla.declarar(nombre, tipo);
     }
 
     void imprimir_tabla_simbolos() {
         cout << "Variable\tTipo\tÁmbito\n";
-        for (const auto& simbolo : tabla_simbolos) {
+        for (const auto& simbolo : tabla.todos()) {
             cout << simbolo.variable << "\t" << simbolo.tipo << "\t" << simbolo.ambito << "\n";
         }
     }
@@ -255,23 +654,19 @@ bool parseFactor(const vector<Token> &tokens, size_t &pos) {
     }
     return false;
 }
-int main() {
-    ifstream file("prueba.txt");
+int main(int argc, char *argv[]) {
+    // Archivo a analizar: el primer argumento, o prueba.txt por defecto
+    string ruta = argc >= 2 ? argv[1] : "prueba.txt";
 
-    // Verificar si el archivo se abrió correctamente
-    if (!file.is_open()) {
+    // Proyectar el archivo en memoria y verificar que se abrió correctamente
+    Fuente fuente;
+    if (!fuente.abrir(ruta)) {
         cout << "Error al abrir el archivo." << endl;
         return 1; // O gestiona el error de otra manera
     }
 
-    string line;
-    vector<Token> tokens;
-
-    // Leer cada línea del archivo
-    while (getline(file, line)) {
-        vector<Token> line_tokens = tokenize(line);
-        tokens.insert(tokens.end(), line_tokens.begin(), line_tokens.end());
-    }
+    // Analizar todo el archivo de una sola vez
+    vector<Token> tokens = tokenize(fuente.contenido());
 
     // Imprimir los tokens identificados
     for (const Token &token : tokens) {